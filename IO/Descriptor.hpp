@@ -2,15 +2,24 @@
 #pragma once
 #include "IO/writer/RootOutput.hpp"
 #include "IO/reader/RootInput.hpp"
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <functional>
 #include <type_traits>
 
 struct FieldDesc {
+  // copies the field of `obj` into a branch buffer resolved beforehand
+  using BoundWrite = std::function<void(const void* obj)>;
+  // copies the current entry of a branch resolved beforehand into the field of `obj`
+  using BoundRead = std::function<void(void* obj)>;
+
   std::string name;
   std::function<void(const void* obj, RootOutput& out, const std::string& prefix)> write;
   std::function<void(void* obj, RootInput& in, const std::string& prefix)> read;
+  // resolve the branch `prefix.name` once (write / read plan); no string building or lookup per event
+  std::function<BoundWrite(RootOutput& out, const std::string& prefix)> bind_write;
+  std::function<BoundRead(RootInput& in, const std::string& prefix)> bind_read;
 };
 
 template <class T, class M>
@@ -32,12 +41,33 @@ FieldDesc field(std::string n, M T::*member) {
     x.*member = *buf;
   };
 
+  d.bind_write = [member, name_copy](RootOutput& out, const std::string& prefix) -> FieldDesc::BoundWrite {
+    using MT = std::decay_t<M>;
+    MT* buf = out.get_or_make_buffer<MT>(prefix + "." + name_copy);
+    return [member, buf](const void* obj) { *buf = static_cast<const T*>(obj)->*member; };
+  };
+
+  d.bind_read = [member, name_copy](RootInput& in, const std::string& prefix) -> FieldDesc::BoundRead {
+    using MT = std::decay_t<M>;
+    const MT* buf = in.get_or_make_address<MT>(prefix + "." + name_copy);
+    return [member, buf](void* obj) { static_cast<T*>(obj)->*member = *buf; };
+  };
+
   return d;
 }
 
 struct FieldDescVector {
+  // copies the field of objs[0..n) (contiguous, e.g. std::vector<T>::data()) into a branch buffer resolved beforehand
+  using BoundWrite = std::function<void(const void* objs, std::size_t n)>;
+  // entry size / copy of the branch into the field of objs[0..n) (contiguous), resolved beforehand
+  using BoundSize = std::function<std::size_t()>;
+  using BoundRead = std::function<void(void* objs, std::size_t n)>;
+
   std::string name;
   std::function<void(const std::vector<const void*>& objs, RootOutput& out, const std::string& prefix)> write;
+  std::function<BoundWrite(RootOutput& out, const std::string& prefix)> bind_write;
+  std::function<BoundSize(RootInput& in, const std::string& prefix)> bind_size;
+  std::function<BoundRead(RootInput& in, const std::string& prefix)> bind_read;
 
   std::function<std::size_t(RootInput& in, const std::string& prefix)> size;
   std::function<void(const std::vector<void*>& objs, RootInput& in, const std::string& prefix)> read;
@@ -79,5 +109,32 @@ FieldDescVector field_vector(std::string n, M T::*member) {
       }
     };
 
+  d.bind_write = [member, name_copy](RootOutput& out, const std::string& prefix) -> FieldDescVector::BoundWrite {
+    using MT = std::decay_t<M>;
+    auto* buf = out.get_or_make_buffer<std::vector<MT>>(prefix + "." + name_copy);
+    return [member, buf](const void* objs, std::size_t n) {
+      const T* xs = static_cast<const T*>(objs);
+      buf->clear(); // keeps the capacity of the branch buffer
+      buf->reserve(n);
+      for (std::size_t i = 0; i < n; ++i) buf->push_back(xs[i].*member);
+    };
+  };
+
+  d.bind_size = [name_copy](RootInput& in, const std::string& prefix) -> FieldDescVector::BoundSize {
+    using MT = std::decay_t<M>;
+    const auto* buf = in.get_or_make_address<std::vector<MT>>(prefix + "." + name_copy);
+    return [buf]() { return buf->size(); };
+  };
+
+  d.bind_read = [member, name_copy](RootInput& in, const std::string& prefix) -> FieldDescVector::BoundRead {
+    using MT = std::decay_t<M>;
+    const auto* buf = in.get_or_make_address<std::vector<MT>>(prefix + "." + name_copy);
+    return [member, buf](void* objs, std::size_t n) {
+      T* xs = static_cast<T*>(objs);
+      n = std::min(n, buf->size());
+      for (std::size_t i = 0; i < n; ++i) xs[i].*member = (*buf)[i];
+    };
+  };
+
   return d;
 }
\ No newline at end of file
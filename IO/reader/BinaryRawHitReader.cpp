@@ -3,8 +3,14 @@
 #include "EventFormats/AHCALDataFragment.hpp"
 #include "EventFormats/DAQFormats.hpp"
 #include "common/Logger.hpp"
+#include "common/TaskPool.hpp"
 #include <iostream>
 #include <cstdint>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
 typedef unsigned char uchar_t;
 namespace tlu{
   class fmctludata{
@@ -88,8 +94,19 @@ AHCALRawHit convert(int index, const AHCALHit& hit){
     return rawhit;
 }
 
-BinaryRawHitReader::BinaryRawHitReader(std::string filename)
+BinaryRawHitReader::BinaryRawHitReader(std::string filename, bool mmap)
+    : m_filename(filename)
 {
+    m_source = open_compressed_source(filename);
+    if (m_source) {
+        if (mmap) LOG_INFO("mmap does not apply to compressed input, reading through the decompression thread");
+        return;
+    }
+    if (mmap) {
+        m_map = std::make_unique<MappedFile>(filename);
+        LOG_INFO("Mapped binary raw hit file: {} ({} bytes)", filename, m_map->size());
+        return;
+    }
     m_ifs = std::make_unique<std::ifstream>(filename,  std::ios::binary);
     if(!m_ifs->is_open()) {
         LOG_ERROR("Failed to open file: {}", filename);
@@ -100,18 +117,234 @@ BinaryRawHitReader::BinaryRawHitReader(std::string filename)
 
 BinaryRawHitReader::~BinaryRawHitReader()
 {
+    m_pool.reset(); // finish the chunks in flight
     if(m_ifs && m_ifs->is_open()) {
         m_ifs->close();
         LOG_INFO("Closed binary raw hit file.");
     }
 }
 
+void BinaryRawHitReader::decode_tlu_(const uint32_t* payload, AHCALTLURawData& out_tlu) {
+    tlu::fmctludata data(payload[0], payload[1], payload[2], payload[3], payload[4], 0);
+    out_tlu.TriggerID = data.eventnumber;
+    out_tlu.Timestamp = data.timestamp;
+    out_tlu.BCID_TLU = static_cast<int>(out_tlu.Timestamp & 0xFFFF);
+
+    out_tlu.Inputs.resize(6);
+    out_tlu.Inputs[0] = static_cast<int>(data.input0);
+    out_tlu.Inputs[1] = static_cast<int>(data.input1);
+    out_tlu.Inputs[2] = static_cast<int>(data.input2);
+    out_tlu.Inputs[3] = static_cast<int>(data.input3);
+    out_tlu.Inputs[4] = static_cast<int>(data.input4);
+    out_tlu.Inputs[5] = static_cast<int>(data.input5);
+
+    out_tlu.FineTimestamps.resize(6);
+    out_tlu.FineTimestamps[0] = static_cast<int>(data.sc0);
+    out_tlu.FineTimestamps[1] = static_cast<int>(data.sc1);
+    out_tlu.FineTimestamps[2] = static_cast<int>(data.sc2);
+    out_tlu.FineTimestamps[3] = static_cast<int>(data.sc3);
+    out_tlu.FineTimestamps[4] = static_cast<int>(data.sc4);
+    out_tlu.FineTimestamps[5] = static_cast<int>(data.sc5);
+}
+
+void BinaryRawHitReader::apply_fine_timestamps_(AHCALTLURawData& out_tlu) {
+    for (int i = 0; i < 6; ++i) {
+        const int current = out_tlu.FineTimestamps[i];
+        if (current == last_timestamp[i] && out_tlu.Inputs[i] == 0) {
+            out_tlu.FineTimestamps[i] = -1;
+        } else {
+            last_timestamp[i] = current;
+        }
+    }
+}
+
+void BinaryRawHitReader::decode_ahcal_(const uint8_t* payload, std::size_t size, std::vector<uint8_t>& buffer,
+                                       std::vector<AHCALRawHit>& out_hits, AHCALTLURawData& out_tlu) {
+    buffer.assign(payload, payload + size);
+    AHCALDataFragment ahcalFrag(buffer);
+    const auto& hits = ahcalFrag.hits();
+    out_tlu.CycleID = static_cast<int>(ahcalFrag.cycleID());
+    out_tlu.Event_Time = static_cast<int>(ahcalFrag.timestamp());
+    out_hits.reserve(out_hits.size() + hits.size());
+    int i = 0;
+    for (const AHCALHit& hit : hits){
+        out_hits.push_back(convert(i, hit));
+        ++i;
+    }
+}
+
+bool BinaryRawHitReader::decode_event_(const RawEvent::EventView& event, long long entry, std::vector<uint8_t>& payload,
+                                       std::vector<AHCALRawHit>& out_hits, AHCALTLURawData& out_tlu,
+                                       bool& out_has_tlu, bool& out_has_ahcal) {
+    out_hits.clear();
+    out_tlu.clear();
+    out_has_tlu = out_has_ahcal = false;
+    out_tlu.RunNo = static_cast<int>(event.run_number());
+    bool ok = true;
+    try {
+        const bool intact = event.for_each_fragment([&](const RawEvent::FragmentView& frag) {
+            if (!ok) return;
+            if (frag.source_id == DAQFormats::SourceIDs::TLUSourceID) {
+                if (frag.payload_size != 20) {
+                    LOG_WARN("Unexpected payload size: {} bytes. Expected 20 bytes.", frag.payload_size);
+                    ok = false;
+                    return;
+                }
+                std::uint32_t words[5];
+                std::memcpy(words, frag.payload, sizeof(words)); // the payload is not 4-byte aligned in the file
+                decode_tlu_(words, out_tlu);
+                out_has_tlu = true;
+            } else if (frag.source_id == DAQFormats::SourceIDs::AHCALSourceID) {
+                decode_ahcal_(frag.payload, frag.payload_size, payload, out_hits, out_tlu);
+                out_has_ahcal = true;
+            }
+        });
+        if (!intact) {
+            LOG_ERROR("Error reading event at entry {}: corrupt fragment header", entry);
+            return false;
+        }
+    } catch (const std::exception& e) {
+        LOG_ERROR("Error reading event at entry {}: {}", entry, e.what());
+        return false;
+    }
+    return ok;
+}
+
+void BinaryRawHitReader::build_index(const std::string& sidecar) {
+    if (m_source) {
+        LOG_ERROR("BinaryRawHitReader: {} is compressed, the event index needs an uncompressed file", m_filename);
+        throw std::runtime_error("BinaryRawHitReader: no event index for compressed input");
+    }
+    if (!sidecar.empty() && m_index.load(sidecar, m_filename)) {
+        LOG_INFO("Loaded event index {} ({} events)", sidecar, m_index.size());
+    } else {
+        // scanned through a mapping: only the pages of the event headers are touched
+        if (m_map) {
+            m_index.build(m_map->data(), m_map->size());
+        } else {
+            const MappedFile map(m_filename);
+            m_index.build(map.data(), map.size());
+        }
+        LOG_INFO("Indexed {} events in {}", m_index.size(), m_filename);
+        if (!sidecar.empty()) m_index.save(sidecar, m_filename);
+    }
+    m_indexed = true;
+}
+
+std::string BinaryRawHitReader::sidecar_path(const std::string& index_file, const std::string& input) {
+    if (index_file.empty()) return "";
+    if (index_file.find('/') == std::string::npos) return input + index_file;
+    const std::filesystem::path dir(index_file);
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    if (ec) LOG_WARN("BinaryRawHitReader: cannot create index directory {}: {}", index_file, ec.message());
+    return (dir / (std::filesystem::path(input).filename().string() + ".idx")).string();
+}
+
+void BinaryRawHitReader::seek(long long i) {
+    if (!m_indexed) throw std::runtime_error("BinaryRawHitReader::seek needs the event index (build_index)");
+    if (i < 0 || i > entries()) {
+        LOG_ERROR("BinaryRawHitReader: cannot seek to event {} (entries={})", i, entries());
+        throw std::out_of_range("BinaryRawHitReader::seek: event out of range");
+    }
+    const std::uint64_t offset = i < entries() ? m_index.offset(static_cast<std::size_t>(i)) : m_index.end_offset();
+    if (m_pool) {
+        drain_chunks_();
+        m_submit_entry = i;
+    }
+    if (m_map) {
+        m_offset = static_cast<std::size_t>(offset);
+    } else {
+        m_ifs->clear();
+        m_ifs->seekg(static_cast<std::streamoff>(offset));
+    }
+    m_entry = i - 1;
+    last_timestamp.assign(6, -1);
+}
+
+void BinaryRawHitReader::set_range(long long begin, long long end) {
+    if (!m_indexed) throw std::runtime_error("BinaryRawHitReader::set_range needs the event index (build_index)");
+    end = std::min(end, entries());
+    if (begin < 0 || begin > end) {
+        LOG_ERROR("BinaryRawHitReader: invalid event range [{}, {}) (entries={})", begin, end, entries());
+        throw std::out_of_range("BinaryRawHitReader::set_range: invalid range");
+    }
+    seek(begin);
+    m_end_entry = end;
+    LOG_INFO("Reading events [{}, {}) of {}", begin, end, entries());
+}
+
+void BinaryRawHitReader::enable_parallel(std::size_t nThreads, std::size_t chunkEvents) {
+    if (nThreads == 0) return;
+    if (m_source) {
+        LOG_ERROR("BinaryRawHitReader: {} is compressed, parallel decoding needs an uncompressed file", m_filename);
+        throw std::runtime_error("BinaryRawHitReader: no parallel decoding for compressed input");
+    }
+    if (!m_map) {
+        m_map = std::make_unique<MappedFile>(m_filename);
+        m_offset = 0;
+    }
+    if (!m_indexed) build_index();
+    m_pool.reset();
+    m_chunk_events = std::max<std::size_t>(chunkEvents, 1);
+    m_chunks.clear();
+    for (std::size_t i = 0; i < 2 * nThreads; ++i) m_chunks.push_back(std::make_unique<Chunk>());
+    m_submitted = m_delivered = 0;
+    m_current = nullptr;
+    m_submit_entry = m_entry + 1;
+    m_pool = std::make_unique<TaskPool>(nThreads);
+    LOG_INFO("Decoding {} events per chunk on {} threads", m_chunk_events, nThreads);
+}
+
+// Keep every free chunk slot busy with the next events.
+void BinaryRawHitReader::submit_chunks_() {
+    const long long end = m_end_entry >= 0 ? m_end_entry : entries();
+    while (m_submitted - m_delivered < m_chunks.size() && m_submit_entry < end) {
+        Chunk* c = m_chunks[m_submitted % m_chunks.size()].get();
+        c->first = m_submit_entry;
+        c->n = std::min<long long>(static_cast<long long>(m_chunk_events), end - m_submit_entry);
+        c->done = false;
+        if (c->events.size() < static_cast<std::size_t>(c->n)) c->events.resize(static_cast<std::size_t>(c->n));
+        m_submit_entry += c->n;
+        ++m_submitted;
+        m_pool->submit([this, c] {
+            for (long long k = 0; k < c->n; ++k) {
+                Decoded& ev = c->events[static_cast<std::size_t>(k)];
+                const long long entry = c->first + k;
+                const std::uint64_t begin = m_index.offset(static_cast<std::size_t>(entry));
+                const RawEvent::EventView event(m_map->data() + begin,
+                                                m_index.end(static_cast<std::size_t>(entry)) - begin);
+                ev.ok = decode_event_(event, entry, c->payload, ev.hits, ev.tlu, ev.has_tlu, ev.has_ahcal);
+            }
+            {
+                std::lock_guard<std::mutex> lk(c->mtx);
+                c->done = true;
+            }
+            c->cv.notify_one();
+        });
+    }
+}
+
+void BinaryRawHitReader::drain_chunks_() {
+    for (; m_delivered < m_submitted; ++m_delivered) {
+        Chunk* c = m_chunks[m_delivered % m_chunks.size()].get();
+        std::unique_lock<std::mutex> lk(c->mtx);
+        c->cv.wait(lk, [c] { return c->done; });
+    }
+    m_submitted = m_delivered = 0;
+    m_current = nullptr;
+}
+
 bool BinaryRawHitReader::next(std::vector<AHCALRawHit>& out_hits, AHCALTLURawData& out_tlu) {
+    if (m_end_entry >= 0 && m_entry + 1 >= m_end_entry) return false;
+    if (m_pool) return next_parallel_(out_hits, out_tlu);
+    if (m_map) return next_mapped_(out_hits, out_tlu);
+    if (m_source) return next_compressed_(out_hits, out_tlu);
     ++m_entry;
     m_eof_good = m_ifs->good() and m_ifs->peek()!=EOF;
     if (!m_eof_good) return false;
     out_hits.clear();
-    out_tlu = AHCALTLURawData();
+    out_tlu.clear();
     try {
         DAQFormats::EventFull event(*m_ifs);
         out_tlu.RunNo = event.run_number();
@@ -124,45 +357,12 @@ bool BinaryRawHitReader::next(std::vector<AHCALRawHit>& out_hits, AHCALTLURawDat
                     LOG_WARN("TLU Fragment payload is null.");
                     return false;
                 }
-                const uint32_t* payload = reinterpret_cast<const uint32_t*>(payload_8bit);
                 if (frag->payload_size() != 20) {
                     LOG_WARN("Unexpected payload size: {} bytes. Expected 20 bytes.", frag->payload_size());
                     return false;
                 }
-                
-                // Stack allocation instead of new/delete
-                tlu::fmctludata data(payload[0], payload[1], payload[2], payload[3], payload[4], 0);
-                out_tlu.TriggerID = data.eventnumber;
-                out_tlu.Timestamp = data.timestamp;
-                out_tlu.BCID_TLU = static_cast<int>(out_tlu.Timestamp & 0xFFFF);
-                
-                out_tlu.Inputs.clear();
-                out_tlu.Inputs.reserve(6);
-                out_tlu.Inputs.push_back(static_cast<int>(data.input0));
-                out_tlu.Inputs.push_back(static_cast<int>(data.input1));
-                out_tlu.Inputs.push_back(static_cast<int>(data.input2));
-                out_tlu.Inputs.push_back(static_cast<int>(data.input3));
-                out_tlu.Inputs.push_back(static_cast<int>(data.input4));
-                out_tlu.Inputs.push_back(static_cast<int>(data.input5));
-                
-                out_tlu.FineTimestamps.clear();
-                out_tlu.FineTimestamps.reserve(6);
-                std::vector<int> current_timestamps(6);
-                current_timestamps[0] = static_cast<int>(data.sc0);
-                current_timestamps[1] = static_cast<int>(data.sc1);
-                current_timestamps[2] = static_cast<int>(data.sc2);
-                current_timestamps[3] = static_cast<int>(data.sc3);
-                current_timestamps[4] = static_cast<int>(data.sc4);
-                current_timestamps[5] = static_cast<int>(data.sc5);
-                
-                for (int i = 0; i < 6; ++i) {
-                    if (current_timestamps[i] == last_timestamp[i] && out_tlu.Inputs[i] == 0) {
-                        out_tlu.FineTimestamps.push_back(-1);
-                    } else {
-                        out_tlu.FineTimestamps.push_back(current_timestamps[i]);
-                        last_timestamp[i] = current_timestamps[i];
-                    }
-                }
+                decode_tlu_(reinterpret_cast<const uint32_t*>(payload_8bit), out_tlu);
+                apply_fine_timestamps_(out_tlu);
                 has_tlu = true;
             }else if (frag->source_id() == DAQFormats::SourceIDs::AHCALSourceID){
                 const uint8_t* payload_8bit = frag->payload<const uint8_t*>();
@@ -170,17 +370,8 @@ bool BinaryRawHitReader::next(std::vector<AHCALRawHit>& out_hits, AHCALTLURawDat
                     LOG_WARN("AHCAL Fragment payload is null.");
                     return false;
                 }
-                const std::vector<uint8_t> payload(payload_8bit, payload_8bit + frag->payload_size());
-                AHCALDataFragment ahcalFrag(payload);
-                const auto& hits = ahcalFrag.hits();
-                out_tlu.CycleID = static_cast<int>(ahcalFrag.cycleID());
-                out_tlu.Event_Time = static_cast<int>(ahcalFrag.timestamp());
-                int i = 0;
-                for (AHCALHit hit : hits){
-                    out_hits.push_back(convert(i, hit));
-                    ++i;
-                }
-                has_ahcal = true; 
+                decode_ahcal_(payload_8bit, frag->payload_size(), m_payload, out_hits, out_tlu);
+                has_ahcal = true;
             }                
         }
     } catch (const std::exception& e) {
@@ -189,3 +380,95 @@ bool BinaryRawHitReader::next(std::vector<AHCALRawHit>& out_hits, AHCALTLURawDat
     }
     return has_tlu || has_ahcal;
 }
+
+bool BinaryRawHitReader::next_mapped_(std::vector<AHCALRawHit>& out_hits, AHCALTLURawData& out_tlu) {
+    ++m_entry;
+    const std::size_t avail = m_map->size() - m_offset;
+    if (avail == 0) return false;
+    const std::uint8_t* p = m_map->data() + m_offset;
+    const std::size_t size = RawEvent::EventView::size_at(p, avail);
+    if (size == 0 || size > avail) {
+        LOG_ERROR("Error reading event at entry {}: corrupt or truncated event header at byte {}", m_entry, m_offset);
+        return false;
+    }
+    m_offset += size;
+    return deliver_event_(p, size, out_hits, out_tlu);
+}
+
+bool BinaryRawHitReader::deliver_event_(const std::uint8_t* p, std::size_t size, std::vector<AHCALRawHit>& out_hits,
+                                        AHCALTLURawData& out_tlu) {
+    bool event_tlu = false;
+    bool event_ahcal = false;
+    if (!decode_event_(RawEvent::EventView(p, size), m_entry, m_payload, out_hits, out_tlu, event_tlu, event_ahcal)) {
+        return false;
+    }
+    if (event_tlu) apply_fine_timestamps_(out_tlu);
+    has_tlu = has_tlu || event_tlu;
+    has_ahcal = has_ahcal || event_ahcal;
+    return has_tlu || has_ahcal;
+}
+
+bool BinaryRawHitReader::fill_stream_buffer_(std::size_t need) {
+    if (m_buf_pos > 0) { // keep the undecoded tail at the front
+        std::memmove(m_stream_buf.data(), m_stream_buf.data() + m_buf_pos, m_buf_end - m_buf_pos);
+        m_buf_end -= m_buf_pos;
+        m_buf_pos = 0;
+    }
+    if (m_stream_buf.size() < need) m_stream_buf.resize(std::max<std::size_t>({need, 2 * m_stream_buf.size(), 1 << 20}));
+    while (m_buf_end < need) {
+        const std::size_t got = m_source->read(m_stream_buf.data() + m_buf_end, m_stream_buf.size() - m_buf_end);
+        if (got == 0) return false;
+        m_buf_end += got;
+    }
+    return true;
+}
+
+bool BinaryRawHitReader::next_compressed_(std::vector<AHCALRawHit>& out_hits, AHCALTLURawData& out_tlu) {
+    ++m_entry;
+    try {
+        std::size_t size = 0;
+        for (;;) {
+            const std::size_t avail = m_buf_end - m_buf_pos;
+            size = RawEvent::EventView::size_at(m_stream_buf.data() + m_buf_pos, avail);
+            if (size == 0 && avail >= RawEvent::kEventHeaderBytes) {
+                LOG_ERROR("Error reading event at entry {}: corrupt event header", m_entry);
+                return false;
+            }
+            if (size > 0 && size <= avail) break;
+            if (!fill_stream_buffer_(size > 0 ? size : RawEvent::kEventHeaderBytes)) {
+                if (m_buf_end > m_buf_pos) LOG_ERROR("Error reading event at entry {}: truncated event", m_entry);
+                return false;
+            }
+        }
+        const std::uint8_t* p = m_stream_buf.data() + m_buf_pos;
+        m_buf_pos += size;
+        return deliver_event_(p, size, out_hits, out_tlu);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Error reading event at entry {}: {}", m_entry, e.what());
+        return false;
+    }
+}
+
+bool BinaryRawHitReader::next_parallel_(std::vector<AHCALRawHit>& out_hits, AHCALTLURawData& out_tlu) {
+    const long long i = m_entry + 1;
+    if (!m_current || i >= m_current->first + m_current->n) {
+        if (m_current) ++m_delivered; // its slot can take the next chunk
+        m_current = nullptr;
+        submit_chunks_();
+        if (m_delivered == m_submitted) return false; // end of file / range
+        Chunk* c = m_chunks[m_delivered % m_chunks.size()].get();
+        std::unique_lock<std::mutex> lk(c->mtx);
+        c->cv.wait(lk, [c] { return c->done; });
+        m_current = c;
+    }
+    m_entry = i;
+    Decoded& ev = m_current->events[static_cast<std::size_t>(i - m_current->first)];
+    if (!ev.ok) return false;
+    if (ev.has_tlu) apply_fine_timestamps_(ev.tlu);
+    has_tlu = has_tlu || ev.has_tlu;
+    has_ahcal = has_ahcal || ev.has_ahcal;
+    // swapped: the chunk slot keeps the caller's old buffers for a later event
+    out_hits.swap(ev.hits);
+    std::swap(out_tlu, ev.tlu);
+    return has_tlu || has_ahcal;
+}
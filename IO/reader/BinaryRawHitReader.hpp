@@ -1,21 +1,126 @@
 #pragma once 
 #include "common/edm/RawHit.hpp"
 #include "common/edm/RawData.hpp"
+#include "ByteSource.hpp"
+#include "MappedFile.hpp"
+#include "RawEventIndex.hpp"
+#include "RawEventView.hpp"
 
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class TaskPool;
+
+// Reads FASER DAQ raw files (TLU + AHCAL fragments).
+// - Default: events are read from an std::ifstream into DAQFormats::EventFull.
+// - mmap: the file is mapped (madvise SEQUENTIAL) and events are walked in place with RawEvent::EventView;
+//   the TLU fragment is decoded from the mapped pages and the AHCAL payload is handed to the decoder
+//   through one reused buffer.
+// - build_index pre-scans the event headers (optionally persisted as a sidecar file); with the index,
+//   entries(), seek() and set_range() allow random access and splitting a file across jobs.
+//   The fine-timestamp state restarts at every seek: FineTimestamps of the first event after a seek
+//   are never -1.
+// - enable_parallel decodes chunks of consecutive events on a thread pool (needs the index, implies mmap)
+//   and delivers them in order. Workers only do the stateless decoding; the fine-timestamp state machine
+//   is applied when an event is delivered, so the results are identical to the sequential modes.
+// - gzip / zstd files (recognized by their magic bytes) are decompressed on a background thread and the
+//   events are walked in place in the decompressed stream; index, seek and parallel decoding need an
+//   uncompressed file.
 class BinaryRawHitReader{
 public:
-    BinaryRawHitReader(std::string filename);
+    BinaryRawHitReader(std::string filename, bool mmap = false);
     ~BinaryRawHitReader();
 
     bool next(std::vector<AHCALRawHit>& out_hits, AHCALTLURawData& out_tlu);
 
     long long entry() const { return m_entry; }
 
+    // sidecar: index file to load, or to write after the scan ("" = keep the index in memory only)
+    void build_index(const std::string& sidecar = "");
+    // Sidecar of `input` for the drivers' index_file option: "" = none (memory only); a value containing '/' is a
+    // directory (created if needed) holding <input file name>.idx; anything else is a suffix appended to the input path.
+    static std::string sidecar_path(const std::string& index_file, const std::string& input);
+    bool has_index() const { return m_indexed; }
+    // number of events (-1 without index)
+    long long entries() const { return m_indexed ? static_cast<long long>(m_index.size()) : -1; }
+    // the next call of next() returns event i (needs the index)
+    void seek(long long i);
+    // read only the events [begin, end) (needs the index)
+    void set_range(long long begin, long long end);
+    // decode chunks of chunkEvents events on nThreads threads, up to 2 x nThreads chunks ahead
+    void enable_parallel(std::size_t nThreads, std::size_t chunkEvents = 256);
+
 private:
+    // One event decoded by a worker; tlu.FineTimestamps holds the raw fine timestamps until delivery.
+    struct Decoded {
+        std::vector<AHCALRawHit> hits;
+        AHCALTLURawData tlu;
+        bool ok = false;
+        bool has_tlu = false;
+        bool has_ahcal = false;
+    };
+    // Events [first, first + n) of the parallel mode; slots are reused round-robin.
+    struct Chunk {
+        long long first = 0;
+        long long n = 0;
+        std::vector<Decoded> events;
+        std::vector<std::uint8_t> payload;
+        bool done = false;
+        std::mutex mtx;
+        std::condition_variable cv;
+    };
+
+    bool next_mapped_(std::vector<AHCALRawHit>& out_hits, AHCALTLURawData& out_tlu);
+    bool next_parallel_(std::vector<AHCALRawHit>& out_hits, AHCALTLURawData& out_tlu);
+    bool next_compressed_(std::vector<AHCALRawHit>& out_hits, AHCALTLURawData& out_tlu);
+    // decode the event at p in the sequential modes and apply the fine-timestamp state
+    bool deliver_event_(const std::uint8_t* p, std::size_t size, std::vector<AHCALRawHit>& out_hits,
+                        AHCALTLURawData& out_tlu);
+    // compressed input: make at least `need` bytes available after m_buf_pos; false at the end of the stream
+    bool fill_stream_buffer_(std::size_t need);
+    // Stateless decoding of one mapped event (safe on any thread); false on a corrupt event.
+    static bool decode_event_(const RawEvent::EventView& event, long long entry, std::vector<std::uint8_t>& payload,
+                              std::vector<AHCALRawHit>& out_hits, AHCALTLURawData& out_tlu, bool& out_has_tlu,
+                              bool& out_has_ahcal);
+    // the 5-word TLU payload; FineTimestamps are the raw values (see apply_fine_timestamps_)
+    static void decode_tlu_(const std::uint32_t* payload, AHCALTLURawData& out_tlu);
+    static void decode_ahcal_(const std::uint8_t* payload, std::size_t size, std::vector<std::uint8_t>& buffer,
+                              std::vector<AHCALRawHit>& out_hits, AHCALTLURawData& out_tlu);
+    // -1 for a fine timestamp that repeats the previous one on an input without signal (last_timestamp)
+    void apply_fine_timestamps_(AHCALTLURawData& out_tlu);
+    void submit_chunks_();
+    void drain_chunks_();
+
+    std::string m_filename;
     std::unique_ptr<std::ifstream> m_ifs;
-    long long m_entry;
+    std::unique_ptr<MappedFile> m_map;
+    std::size_t m_offset = 0; // mmap: offset of the next event
+    std::unique_ptr<ByteSource> m_source; // compressed input
+    std::vector<std::uint8_t> m_stream_buf; // decompressed bytes [m_buf_pos, m_buf_end) not yet decoded
+    std::size_t m_buf_pos = 0;
+    std::size_t m_buf_end = 0;
+    std::vector<std::uint8_t> m_payload; // AHCAL payload handed to AHCALDataFragment, reused
+    long long m_entry = -1;
+    long long m_end_entry = -1; // set_range end (-1: end of file)
+    RawEventIndex m_index;
+    bool m_indexed = false;
     bool m_eof_good = true;
     bool has_tlu = false;
     bool has_ahcal = false;
     std::vector<int> last_timestamp = std::vector<int>(6, -1);
-};
\ No newline at end of file
+
+    // parallel mode
+    std::size_t m_chunk_events = 0;
+    std::vector<std::unique_ptr<Chunk>> m_chunks;
+    unsigned long long m_submitted = 0; // chunks submitted / delivered so far; chunk k uses m_chunks[k % size]
+    unsigned long long m_delivered = 0;
+    long long m_submit_entry = 0;       // first event of the next chunk to submit
+    Chunk* m_current = nullptr;
+    std::unique_ptr<TaskPool> m_pool;   // declared last: joined before the chunks are destroyed
+};
@@ -0,0 +1,231 @@
+#pragma once
+#include <zlib.h>
+#ifdef FAIR_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/Logger.hpp"
+
+// Sequential byte streams for compressed raw files (BinaryRawHitReader).
+// read() fills up to n bytes and returns how many it wrote; 0 means end of stream. Errors throw.
+class ByteSource {
+public:
+  virtual ~ByteSource() = default;
+  virtual std::size_t read(std::uint8_t* dst, std::size_t n) = 0;
+};
+
+// gzip (also concatenated members) through zlib.
+class GzipSource final : public ByteSource {
+public:
+  explicit GzipSource(const std::string& filename) : m_file(gzopen(filename.c_str(), "rb")) {
+    if (!m_file) throw std::runtime_error("Failed to open gzip file: " + filename);
+    gzbuffer(m_file, 1 << 20);
+  }
+  ~GzipSource() override { gzclose(m_file); }
+
+  std::size_t read(std::uint8_t* dst, std::size_t n) override {
+    const int chunk = static_cast<int>(std::min<std::size_t>(n, 1u << 30));
+    const int got = gzread(m_file, dst, static_cast<unsigned>(chunk));
+    if (got < 0) {
+      int err = 0;
+      const char* msg = gzerror(m_file, &err);
+      throw std::runtime_error(std::string("gzip read error: ") + (msg ? msg : "unknown"));
+    }
+    return static_cast<std::size_t>(got);
+  }
+
+private:
+  gzFile m_file;
+};
+
+#ifdef FAIR_WITH_ZSTD
+// zstd frames (also concatenated) through the streaming decompression API.
+class ZstdSource final : public ByteSource {
+public:
+  explicit ZstdSource(const std::string& filename)
+    : m_file(std::fopen(filename.c_str(), "rb")), m_ctx(ZSTD_createDCtx()), m_in(ZSTD_DStreamInSize()) {
+    if (!m_file || !m_ctx) {
+      ZSTD_freeDCtx(m_ctx);
+      if (m_file) std::fclose(m_file);
+      throw std::runtime_error("Failed to open zstd file: " + filename);
+    }
+  }
+  ~ZstdSource() override {
+    ZSTD_freeDCtx(m_ctx);
+    if (m_file) std::fclose(m_file);
+  }
+
+  std::size_t read(std::uint8_t* dst, std::size_t n) override {
+    ZSTD_outBuffer out{dst, n, 0};
+    while (out.pos < out.size) {
+      if (m_input.pos == m_input.size && !m_input_eof) {
+        const std::size_t got = std::fread(m_in.data(), 1, m_in.size(), m_file);
+        if (got == 0) {
+          if (std::ferror(m_file)) throw std::runtime_error("zstd input read error");
+          m_input_eof = true;
+        }
+        m_input = ZSTD_inBuffer{m_in.data(), got, 0};
+      }
+      const std::size_t in_before = m_input.pos;
+      const std::size_t out_before = out.pos;
+      const std::size_t ret = ZSTD_decompressStream(m_ctx, &out, &m_input);
+      if (ZSTD_isError(ret)) throw std::runtime_error(std::string("zstd error: ") + ZSTD_getErrorName(ret));
+      if (m_input.pos != in_before || out.pos != out_before) {
+        m_last = ret;
+      } else if (m_input_eof) {
+        if (m_last != 0) throw std::runtime_error("zstd stream is truncated");
+        break;
+      }
+    }
+    return out.pos;
+  }
+
+private:
+  std::FILE* m_file;
+  ZSTD_DCtx* m_ctx;
+  std::vector<std::uint8_t> m_in;
+  ZSTD_inBuffer m_input{nullptr, 0, 0};
+  bool m_input_eof = false;
+  std::size_t m_last = 0; // result of the last call that made progress: 0 once a frame is complete and flushed
+};
+#endif
+
+// Runs another source on a background thread, `depth` blocks of `block_bytes` ahead of the reader,
+// so decompression overlaps with decoding. Blocks are recycled; errors are rethrown by read().
+class PrefetchSource final : public ByteSource {
+public:
+  explicit PrefetchSource(std::unique_ptr<ByteSource> inner, std::size_t block_bytes = 4 << 20, std::size_t depth = 4)
+    : m_inner(std::move(inner)), m_block_bytes(block_bytes), m_free(depth) {
+    m_thread = std::thread([this] { run(); });
+  }
+  ~PrefetchSource() override {
+    {
+      std::lock_guard<std::mutex> lk(m_mtx);
+      m_stop = true;
+    }
+    m_cv.notify_all();
+    m_thread.join();
+  }
+
+  std::size_t read(std::uint8_t* dst, std::size_t n) override {
+    std::size_t done = 0;
+    while (done < n) {
+      if (m_pos == m_cur.size() && !take_block()) break;
+      const std::size_t k = std::min(n - done, m_cur.size() - m_pos);
+      std::memcpy(dst + done, m_cur.data() + m_pos, k);
+      m_pos += k;
+      done += k;
+    }
+    return done;
+  }
+
+private:
+  // swap the consumed block for the next filled one; false at the end of the stream
+  bool take_block() {
+    std::unique_lock<std::mutex> lk(m_mtx);
+    m_cv.wait(lk, [this] { return !m_full.empty() || m_eof; });
+    if (m_full.empty()) {
+      if (m_error) std::rethrow_exception(m_error);
+      return false;
+    }
+    m_free.push_back(std::move(m_cur));
+    m_cur = std::move(m_full.front());
+    m_full.erase(m_full.begin());
+    m_pos = 0;
+    lk.unlock();
+    m_cv.notify_all();
+    return true;
+  }
+
+  void run() {
+    try {
+      for (;;) {
+        std::vector<std::uint8_t> block;
+        {
+          std::unique_lock<std::mutex> lk(m_mtx);
+          m_cv.wait(lk, [this] { return m_stop || !m_free.empty(); });
+          if (m_stop) return;
+          block = std::move(m_free.back());
+          m_free.pop_back();
+        }
+        block.resize(m_block_bytes);
+        std::size_t got = 0;
+        while (got < block.size()) {
+          const std::size_t k = m_inner->read(block.data() + got, block.size() - got);
+          if (k == 0) break;
+          got += k;
+        }
+        block.resize(got);
+        {
+          std::lock_guard<std::mutex> lk(m_mtx);
+          if (got > 0) m_full.push_back(std::move(block));
+          if (got < m_block_bytes) m_eof = true;
+        }
+        m_cv.notify_all();
+        if (got < m_block_bytes) return;
+      }
+    } catch (...) {
+      {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        m_error = std::current_exception();
+        m_eof = true;
+      }
+      m_cv.notify_all();
+    }
+  }
+
+  std::unique_ptr<ByteSource> m_inner;
+  const std::size_t m_block_bytes;
+  std::vector<std::uint8_t> m_cur; // block being consumed by read()
+  std::size_t m_pos = 0;
+
+  std::mutex m_mtx;
+  std::condition_variable m_cv;
+  std::vector<std::vector<std::uint8_t>> m_free; // empty blocks for the decompression thread
+  std::vector<std::vector<std::uint8_t>> m_full; // decompressed blocks, in order
+  bool m_eof = false;
+  bool m_stop = false;
+  std::exception_ptr m_error;
+  std::thread m_thread;
+};
+
+// Decompressing source for a gzip or zstd file (detected from the magic bytes, not the extension),
+// nullptr for anything else (plain raw files are mapped or streamed directly).
+inline std::unique_ptr<ByteSource> open_compressed_source(const std::string& filename) {
+  std::uint8_t magic[4] = {0, 0, 0, 0};
+  if (std::FILE* f = std::fopen(filename.c_str(), "rb")) {
+    const std::size_t got = std::fread(magic, 1, sizeof(magic), f);
+    std::fclose(f);
+    if (got < 2) return nullptr;
+  } else {
+    return nullptr;
+  }
+  if (magic[0] == 0x1f && magic[1] == 0x8b) {
+    LOG_INFO("{}: gzip compressed, decompressing on a background thread", filename);
+    return std::make_unique<PrefetchSource>(std::make_unique<GzipSource>(filename));
+  }
+  if (magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) {
+#ifdef FAIR_WITH_ZSTD
+    LOG_INFO("{}: zstd compressed, decompressing on a background thread", filename);
+    return std::make_unique<PrefetchSource>(std::make_unique<ZstdSource>(filename));
+#else
+    LOG_ERROR("{} is zstd compressed, but this build has no zstd support (FAIR_WITH_ZSTD)", filename);
+    throw std::runtime_error("zstd input not supported by this build: " + filename);
+#endif
+  }
+  return nullptr;
+}
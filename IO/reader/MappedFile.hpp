@@ -0,0 +1,54 @@
+#pragma once
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include "common/Logger.hpp"
+
+// Read-only mapping of a whole file, advised for sequential access (aggressive read-ahead, pages behind
+// the reader are reclaimed first). Readers decode straight from the mapped pages.
+class MappedFile {
+public:
+  explicit MappedFile(const std::string& filename) {
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+      LOG_ERROR("Failed to open file: {}", filename);
+      throw std::runtime_error("Failed to open file: " + filename);
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) {
+      ::close(fd);
+      throw std::runtime_error("Cannot stat file: " + filename);
+    }
+    m_size = static_cast<std::size_t>(st.st_size);
+    if (m_size > 0) {
+      void* addr = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr == MAP_FAILED) {
+        ::close(fd);
+        LOG_ERROR("Failed to map file: {}", filename);
+        throw std::runtime_error("Failed to map file: " + filename);
+      }
+      m_data = static_cast<const std::uint8_t*>(addr);
+      ::madvise(addr, m_size, MADV_SEQUENTIAL);
+    }
+    ::close(fd);
+  }
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  ~MappedFile() {
+    if (m_data) ::munmap(const_cast<std::uint8_t*>(m_data), m_size);
+  }
+
+  const std::uint8_t* data() const { return m_data; }
+  std::size_t size() const { return m_size; }
+
+private:
+  const std::uint8_t* m_data = nullptr;
+  std::size_t m_size = 0;
+};
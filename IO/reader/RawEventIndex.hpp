@@ -0,0 +1,127 @@
+#pragma once
+#include "RawEventView.hpp"
+#include "common/Logger.hpp"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Byte offsets of the events of a raw file, found by hopping from event header to event header
+// (only the headers are touched). Persisted as a sidecar file:
+//   40-byte header (magic, version, count, raw file size, raw file mtime) | count x uint64 offset | uint64 end
+// A sidecar whose size/mtime do not match the raw file is ignored and rebuilt.
+class RawEventIndex {
+public:
+  static constexpr char kMagic[8] = {'F', 'A', 'I', 'R', 'I', 'D', 'X', '\0'};
+  static constexpr std::uint32_t kVersion = 1;
+
+  // Scan `size` bytes; stops at the first corrupt or truncated event (logged), indexing the events before it.
+  void build(const std::uint8_t* data, std::size_t size) {
+    m_offsets.clear();
+    std::size_t pos = 0;
+    while (pos < size) {
+      const std::size_t n = RawEvent::EventView::size_at(data + pos, size - pos);
+      if (n == 0 || n > size - pos) {
+        LOG_WARN("RawEventIndex: corrupt or truncated event at byte {}, indexed {} events", pos, m_offsets.size());
+        break;
+      }
+      m_offsets.push_back(pos);
+      pos += n;
+    }
+    m_end = pos;
+  }
+
+  std::size_t size() const { return m_offsets.size(); }
+  bool empty() const { return m_offsets.empty(); }
+  std::uint64_t offset(std::size_t i) const { return m_offsets[i]; }
+  // offset just past event i
+  std::uint64_t end(std::size_t i) const { return i + 1 < m_offsets.size() ? m_offsets[i + 1] : m_end; }
+  // offset just past the last event
+  std::uint64_t end_offset() const { return m_end; }
+
+  bool load(const std::string& path, const std::string& raw_file) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    Header h{};
+    Stamp st{};
+    if (!in.read(reinterpret_cast<char*>(&h), sizeof(h)) || std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0 ||
+        h.version != kVersion || !stamp(raw_file, st) || h.file_size != st.size || h.file_mtime != st.mtime) {
+      LOG_INFO("RawEventIndex: {} does not match {}, rebuilding", path, raw_file);
+      return false;
+    }
+    m_offsets.resize(h.count);
+    in.read(reinterpret_cast<char*>(m_offsets.data()), static_cast<std::streamsize>(h.count * sizeof(std::uint64_t)));
+    in.read(reinterpret_cast<char*>(&m_end), sizeof(m_end));
+    if (!in) {
+      LOG_WARN("RawEventIndex: {} is truncated, rebuilding", path);
+      m_offsets.clear();
+      return false;
+    }
+    return true;
+  }
+
+  // Written next to its final path and renamed into place, so concurrent jobs never see a partial file.
+  bool save(const std::string& path, const std::string& raw_file) const {
+    Header h{};
+    Stamp st{};
+    if (!stamp(raw_file, st)) return false;
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.version = kVersion;
+    h.count = m_offsets.size();
+    h.file_size = st.size;
+    h.file_mtime = st.mtime;
+
+    const std::string tmp = path + ".tmp." + std::to_string(::getpid());
+    {
+      std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+      out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+      out.write(reinterpret_cast<const char*>(m_offsets.data()),
+                static_cast<std::streamsize>(m_offsets.size() * sizeof(std::uint64_t)));
+      out.write(reinterpret_cast<const char*>(&m_end), sizeof(m_end));
+      if (!out) {
+        LOG_WARN("RawEventIndex: cannot write {}", tmp);
+        std::remove(tmp.c_str());
+        return false;
+      }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+      LOG_WARN("RawEventIndex: cannot move index into place: {}", path);
+      std::remove(tmp.c_str());
+      return false;
+    }
+    LOG_INFO("RawEventIndex: wrote {} ({} events)", path, m_offsets.size());
+    return true;
+  }
+
+private:
+  struct Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t reserved;
+    std::uint64_t count;
+    std::uint64_t file_size;
+    std::int64_t file_mtime;
+  };
+
+  struct Stamp {
+    std::uint64_t size;
+    std::int64_t mtime; // ns
+  };
+
+  static bool stamp(const std::string& raw_file, Stamp& st) {
+    struct stat s {};
+    if (::stat(raw_file.c_str(), &s) != 0) return false;
+    st.size = static_cast<std::uint64_t>(s.st_size);
+    st.mtime = static_cast<std::int64_t>(s.st_mtim.tv_sec) * 1000000000LL + s.st_mtim.tv_nsec;
+    return true;
+  }
+
+  std::vector<std::uint64_t> m_offsets;
+  std::uint64_t m_end = 0;
+};
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// In-place view of the FASER DAQ event format (faser-common EventFormats/DAQFormats.hpp):
+//   event    = EventHeader (header_size bytes) | fragment_count x fragment      (total header_size + payload_size)
+//   fragment = EventFragmentHeader (header_size bytes) | payload                (total header_size + payload_size)
+// Both headers are packed little-endian structs; only the fields the readers need are decoded, by offset,
+// so events can be walked directly in a mapped file without building DAQFormats::EventFull.
+namespace RawEvent {
+    constexpr std::uint8_t kEventMarker = 0xBB;
+    constexpr std::uint8_t kFragmentMarker = 0xAA;
+
+    // fixed part of DAQFormats::EventHeader: marker(1) tag(1) trigger_bits(2) version(2) header_size(2)
+    // payload_size(4) fragment_count(1) run_number(3) event_id(8) event_counter(8) bc_id(2) status(2) timestamp(8)
+    constexpr std::size_t kEventHeaderBytes = 44;
+    // fixed part of DAQFormats::EventFragmentHeader: marker(1) tag(1) trigger_bits(2) version(2) header_size(2)
+    // payload_size(4) source_id(4) event_id(8) bc_id(2) status(2) timestamp(8)
+    constexpr std::size_t kFragmentHeaderBytes = 36;
+
+    template <class T>
+    inline T load(const std::uint8_t* p) {
+        T v;
+        std::memcpy(&v, p, sizeof(T));
+        return v;
+    }
+
+    struct FragmentView {
+        std::uint32_t source_id = 0;
+        const std::uint8_t* payload = nullptr;
+        std::uint32_t payload_size = 0;
+    };
+
+    class EventView {
+    public:
+        // Bytes of the event starting at `p` (0 if `avail` does not hold a valid event header).
+        static std::size_t size_at(const std::uint8_t* p, std::size_t avail) {
+            if (avail < kEventHeaderBytes || p[0] != kEventMarker) return 0;
+            const std::size_t header = load<std::uint16_t>(p + 6);
+            if (header < kEventHeaderBytes) return 0;
+            return header + load<std::uint32_t>(p + 8);
+        }
+
+        EventView(const std::uint8_t* data, std::size_t size) : m_data(data), m_size(size) {}
+
+        const std::uint8_t* data() const { return m_data; }
+        std::size_t size() const { return m_size; }
+        std::uint8_t fragment_count() const { return m_data[12]; }
+        std::uint32_t run_number() const {
+            return static_cast<std::uint32_t>(m_data[13]) | (static_cast<std::uint32_t>(m_data[14]) << 8) |
+                   (static_cast<std::uint32_t>(m_data[15]) << 16);
+        }
+        std::uint64_t event_id() const { return load<std::uint64_t>(m_data + 16); }
+
+        // Calls fn(const FragmentView&) for every fragment; false if a fragment header is corrupt or truncated.
+        template <class Fn>
+        bool for_each_fragment(Fn&& fn) const {
+            std::size_t pos = load<std::uint16_t>(m_data + 6);
+            for (unsigned i = 0; i < fragment_count(); ++i) {
+                if (pos + kFragmentHeaderBytes > m_size || m_data[pos] != kFragmentMarker) return false;
+                const std::uint8_t* f = m_data + pos;
+                const std::size_t header = load<std::uint16_t>(f + 6);
+                const std::uint32_t payload = load<std::uint32_t>(f + 8);
+                if (header < kFragmentHeaderBytes || pos + header + payload > m_size) return false;
+                fn(FragmentView{load<std::uint32_t>(f + 12), f + header, payload});
+                pos += header + payload;
+            }
+            return true;
+        }
+
+    private:
+        const std::uint8_t* m_data;
+        std::size_t m_size;
+    };
+}
@@ -1,19 +1,32 @@
 #pragma once
 #include <any>
 #include <functional>
+#include <stdexcept>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "IO/Descriptor.hpp"
 #include "IO/reader/RootInput.hpp"
+#include "common/EventStore.hpp"
 
 class ReaderRegistry {
 public:
   using ReaderFn = std::function<std::any(const std::string& prefix, RootInput& in)>;
+  // Read plan: a reader bound to the branches of one key, filling the EventStore slot in place.
+  using BoundReaderFn = std::function<void(EventStore& store)>;
+  using BindFn = std::function<BoundReaderFn(const std::string& prefix, EventKey key, RootInput& in)>;
 
   template <class T>
   void register_struct(std::string type_name) {
+    m_binders.emplace(type_name, [](const std::string& prefix, EventKey key, RootInput& in) -> BoundReaderFn {
+      std::vector<FieldDesc::BoundRead> fields;
+      for (const auto& f : describe((const T*)nullptr)) fields.push_back(f.bind_read(in, prefix));
+      return [fields = std::move(fields), key](EventStore& store) {
+        T& obj = store.make<T>(key);
+        for (const auto& r : fields) r(&obj);
+      };
+    });
     m_readers.emplace(std::move(type_name),
       [](const std::string& prefix, RootInput& in) -> std::any {
         T obj{};
@@ -25,6 +38,18 @@ public:
 
   template <class T>
   void register_vector_struct(std::string type_name) {
+    m_binders.emplace(type_name, [](const std::string& prefix, EventKey key, RootInput& in) -> BoundReaderFn {
+      const auto& desc = describe_vector((const T*)nullptr);
+      if (desc.empty()) return [key](EventStore& store) { store.make<std::vector<T>>(key); };
+      auto size = desc.front().bind_size(in, prefix);
+      std::vector<FieldDescVector::BoundRead> fields;
+      for (const auto& f : desc) fields.push_back(f.bind_read(in, prefix));
+      return [size = std::move(size), fields = std::move(fields), key](EventStore& store) {
+        auto& vec = store.make<std::vector<T>>(key); // recycled: keeps its capacity
+        vec.resize(size());
+        for (const auto& r : fields) r(vec.data(), vec.size());
+      };
+    });
     m_readers.emplace(std::move(type_name),
       [](const std::string& prefix, RootInput& in) -> std::any {
         std::vector<T> vec;
@@ -52,6 +77,34 @@ public:
     return std::any_cast<T>(any);
   }
 
+  // Resolve the branches `prefix.*` of a `type_name` object once; the returned reader stores the
+  // current entry under `key`.
+  BoundReaderFn bind(const std::string& type_name, const std::string& prefix, EventKey key, RootInput& in) const {
+    auto it = m_binders.find(type_name);
+    if (it == m_binders.end()) {
+      LOG_ERROR("ReaderRegistry: no reader registered for type '{}'", type_name);
+      throw std::runtime_error("ReaderRegistry: no reader for type: " + type_name);
+    }
+    return it->second(prefix, key, in);
+  }
+
 private:
   std::unordered_map<std::string, ReaderFn> m_readers;
+  std::unordered_map<std::string, BindFn> m_binders;
+};
+
+// Bind-once reader of a RootInput `inputlist`: branch addresses are resolved when the plan is built,
+// read() materializes the current entry straight into the (recycled) EventStore slots.
+class ReadPlan {
+public:
+  void add(ReaderRegistry::BoundReaderFn step) { m_steps.push_back(std::move(step)); }
+
+  void read(EventStore& store) const {
+    for (const auto& step : m_steps) step(store);
+  }
+
+  std::size_t size() const { return m_steps.size(); }
+
+private:
+  std::vector<ReaderRegistry::BoundReaderFn> m_steps;
 };
\ No newline at end of file
@@ -2,7 +2,9 @@
 #include <TFile.h>
 #include <TTree.h>
 #include <TBranch.h>
+#include <TTreeCache.h>
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <typeindex>
@@ -13,8 +15,27 @@
 
 #include "common/Logger.hpp"
 
+// Reads the flat branches written by RootWriterAlg.
+// - Every branch starts disabled; get_or_make_address enables the branches it binds, so only the
+//   products listed in the inputlist are read and decompressed.
+// - configure_cache sets up a TTreeCache for the active branches with the learning phase skipped
+//   (call it once the read plan is bound; branches bound later are added to the cache as well).
 class RootInput {
 public:
+  // I/O counters of the input file, see stats().
+  struct Stats {
+    Long64_t bytes_read = 0;        // bytes read from the file
+    Int_t read_calls = 0;           // read requests to the file
+    Long64_t cache_size = 0;        // TTreeCache buffer size (0 = no cache)
+    Long64_t cache_bytes_read = 0;  // bytes prefetched by the cache
+    Int_t cache_read_calls = 0;     // vectored reads issued by the cache
+    Long64_t miss_bytes_read = 0;   // bytes read outside the cache (cache misses)
+    Int_t miss_read_calls = 0;
+    double efficiency = 0.0;        // used / prefetched baskets
+    double efficiency_rel = 0.0;    // used / prefetched baskets, relative to the baskets read
+    std::size_t active_branches = 0;
+  };
+
   RootInput(const std::string& filename, const std::string& treename = "events")
     : m_file(TFile::Open(filename.c_str(), "READ")) {
     if (!m_file || m_file->IsZombie()) {
@@ -24,6 +45,7 @@ public:
     m_tree = dynamic_cast<TTree*>(m_file->Get(treename.c_str()));
     if (!m_tree) throw std::runtime_error("TTree not found: " + treename);
     m_entries = m_tree->GetEntries();
+    m_tree->SetBranchStatus("*", 0);
   }
 
   ~RootInput() { if (m_file) m_file->Close(); }
@@ -46,6 +68,51 @@ public:
     return true;
   }
 
+  // Size the tree cache for the active branches (bytes <= 0: about one cluster of them), register
+  // the branches and stop the learning phase.
+  void configure_cache(Long64_t bytes = 0) {
+    if (bytes <= 0) bytes = estimate_cache_size();
+    if (m_tree->SetCacheSize(bytes) < 0) {
+      LOG_WARN("RootInput: cannot create a tree cache of {} bytes, reading without cache", bytes);
+      return;
+    }
+    m_cache_size = bytes;
+    for (const auto& kv : m_buffers) m_tree->AddBranchToCache(kv.first.c_str(), true);
+    m_tree->StopCacheLearningPhase();
+    LOG_INFO("RootInput: tree cache {:.1f} MB for {} active branches", bytes / 1048576.0, m_buffers.size());
+  }
+
+  Stats stats() const {
+    Stats s;
+    s.bytes_read = m_file->GetBytesRead();
+    s.read_calls = m_file->GetReadCalls();
+    s.active_branches = m_buffers.size();
+    if (auto* cache = m_file->GetCacheRead(m_tree)) {
+      s.cache_size = cache->GetBufferSize();
+      s.cache_bytes_read = cache->GetBytesRead();
+      s.cache_read_calls = cache->GetReadCalls();
+      s.miss_bytes_read = cache->GetNoCacheBytesRead();
+      s.miss_read_calls = cache->GetNoCacheReadCalls();
+      if (auto* tc = dynamic_cast<TTreeCache*>(cache)) {
+        s.efficiency = tc->GetEfficiency();
+        s.efficiency_rel = tc->GetEfficiencyRel();
+      }
+    }
+    return s;
+  }
+
+  void log_stats() const {
+    const Stats s = stats();
+    LOG_INFO("RootInput: read {:.1f} MB in {} calls, {} active branches", s.bytes_read / 1048576.0, s.read_calls,
+             s.active_branches);
+    if (s.cache_size > 0) {
+      LOG_INFO("RootInput: cache {:.1f} MB, prefetched {:.1f} MB in {} calls, missed {:.1f} MB in {} calls, "
+               "efficiency {:.3f} (rel {:.3f})",
+               s.cache_size / 1048576.0, s.cache_bytes_read / 1048576.0, s.cache_read_calls,
+               s.miss_bytes_read / 1048576.0, s.miss_read_calls, s.efficiency, s.efficiency_rel);
+    }
+  }
+
   template <class T>
   T* get_or_make_address(const std::string& branch_name) {
     const std::type_index want(typeid(T));
@@ -65,6 +132,7 @@ public:
       T* raw = holder->ptr();
       m_branch_types.emplace(branch_name, want);
       m_buffers.emplace(branch_name, std::move(holder));
+      if (m_cache_size > 0) m_tree->AddBranchToCache(branch_name.c_str(), true);
       if (m_entry > 0) {
         const Long64_t nb = m_tree->GetEntry(m_entry - 1);
         LOG_DEBUG("Reload entry {} after binding '{}': bytes={}", m_entry - 1, branch_name, nb);
@@ -76,6 +144,21 @@ public:
   }
 
 private:
+  // Zipped bytes of one cluster of the active branches plus some headroom, within [1, 256] MB.
+  Long64_t estimate_cache_size() const {
+    constexpr Long64_t kMin = 1LL << 20;
+    constexpr Long64_t kMax = 256LL << 20;
+    if (m_entries <= 0) return kMin;
+    Long64_t zip = 0;
+    for (const auto& kv : m_buffers) {
+      if (auto* b = m_tree->GetBranch(kv.first.c_str())) zip += b->GetZipBytes("*");
+    }
+    const Long64_t flush = m_tree->GetAutoFlush();
+    const Long64_t cluster = flush > 0 ? std::min(flush, m_entries) : std::min<Long64_t>(1000, m_entries);
+    const Long64_t want = static_cast<Long64_t>(1.5 * static_cast<double>(zip) * cluster / m_entries);
+    return std::clamp(want, kMin, kMax);
+  }
+
   template <typename>
   struct is_std_vector : std::false_type {};
   template <typename U, typename A>
@@ -96,6 +179,7 @@ private:
         throw std::runtime_error("Branch not found: " + bn);
       }
 
+      t->SetBranchStatus(bn.c_str(), 1);
       int rc = 0;
       if constexpr (is_std_vector<T>::value) {
         if (!vec_ptr) vec_ptr = new T();
@@ -129,6 +213,7 @@ private:
   TTree* m_tree = nullptr;
   Long64_t m_entries = 0;
   Long64_t m_entry = 0;
+  Long64_t m_cache_size = 0;
 
   std::unordered_map<std::string, std::unique_ptr<IHolder>> m_buffers;
   std::unordered_map<std::string, std::type_index> m_branch_types;
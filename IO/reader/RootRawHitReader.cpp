@@ -1,12 +1,24 @@
 #include "RootRawHitReader.hpp"
 
+#include <algorithm>
 #include <stdexcept>
+#include <utility>
 
+#include "TBranch.h"
 #include "TFile.h"
 #include "TTree.h"
 
+#include "common/Logger.hpp"
+
+namespace {
+  // upper bound of one bulk read, for files written without (or with very large) clusters
+  constexpr long long kMaxClusterEntries = 10000;
+}
+
 RootRawHitReader::RootRawHitReader(std::string filename,
-                                   std::string treename)
+                                   std::string treename,
+                                   bool bulk)
+  : m_bulk(bulk)
 {
   m_file.reset(TFile::Open(filename.c_str(), "READ"));
   if (!m_file || m_file->IsZombie()) {
@@ -22,6 +34,16 @@ RootRawHitReader::RootRawHitReader(std::string filename,
   bind_branches_();
   // Read first branch to initialize the enviromental variables
   m_tree->GetEntry(0);
+  if (m_bulk) {
+    // the cache holds exactly the branches read below, no learning phase
+    m_tree->SetCacheSize(-1);
+    for (TBranch* br : {m_br_timestamp, m_br_bcid_tlu, m_br_inputs, m_br_fine_timestamps, m_br_runNo, m_br_cycleID,
+                        m_br_triggerID, m_br_event_time, m_br_cellID, m_br_hg, m_br_lg, m_br_bcid, m_br_hitTag}) {
+      m_tree->AddBranchToCache(br->GetName(), true);
+    }
+    m_tree->StopCacheLearningPhase();
+    LOG_INFO("RootRawHitReader: bulk mode, reading up to {} entries per cluster", kMaxClusterEntries);
+  }
 }
 RootRawHitReader::~RootRawHitReader() {
     cleanup_buffers_();
@@ -78,11 +100,115 @@ void RootRawHitReader::bind_branches_() {
     m_tree->SetBranchAddress("HitTag", &b_hitTag);
     m_tree->SetBranchAddress("HG_Charge", &b_hg);
     m_tree->SetBranchAddress("LG_Charge", &b_lg);
+
+    auto branch = [this](const char* name) {
+      TBranch* br = m_tree->GetBranch(name);
+      if (!br) throw std::runtime_error(std::string("RootRawHitReader: cannot find branch: ") + name);
+      return br;
+    };
+    m_br_timestamp = branch("Timestamp");
+    m_br_bcid_tlu = branch("BCID_TLU");
+    m_br_inputs = branch("Inputs");
+    m_br_fine_timestamps = branch("FineTimestamps");
+    m_br_runNo = branch("Run_No");
+    m_br_cycleID = branch("CycleID");
+    m_br_triggerID = m_tree->GetBranch("TriggerID_TLU") ? branch("TriggerID_TLU") : branch("TriggerID");
+    m_br_event_time = branch("Event_Time");
+    m_br_cellID = branch("CellID");
+    m_br_hg = branch("HG_Charge");
+    m_br_lg = branch("LG_Charge");
+    m_br_bcid = branch("BCID");
+    m_br_hitTag = branch("HitTag");
+}
+
+void RootRawHitReader::fill_tlu_(AHCALTLURawData& out_tlu_data) const {
+  out_tlu_data.Timestamp = b_timestamp;
+  out_tlu_data.BCID_TLU = b_bc_id_tlu;
+  out_tlu_data.Inputs.resize(6);
+  out_tlu_data.FineTimestamps.resize(6);
+  for (int i = 0; i < 6; ++i) {
+      out_tlu_data.Inputs[i] = (b_inputs && b_inputs->size() > static_cast<size_t>(i)) ? (*b_inputs)[i] : 0;
+      out_tlu_data.FineTimestamps[i] = (b_fine_timestamps && b_fine_timestamps->size() > static_cast<size_t>(i)) ? (*b_fine_timestamps)[i] : 0;
+  }
+  out_tlu_data.RunNo = b_runNo;
+  out_tlu_data.CycleID = b_cycleID;
+  out_tlu_data.TriggerID = b_triggerID;
+  out_tlu_data.Event_Time = b_Event_Time;
+}
+
+template <class Fn>
+void RootRawHitReader::read_branch_(TBranch* br, Fn&& take) {
+  for (long long k = 0; k < m_cluster.n; ++k) {
+    if (br->GetEntry(m_cluster.first + k) < 0) {
+      throw std::runtime_error(std::string("RootRawHitReader: cannot read branch: ") + br->GetName());
+    }
+    take(static_cast<std::size_t>(k));
+  }
+}
+
+bool RootRawHitReader::load_cluster_() {
+  Cluster& c = m_cluster;
+  if (m_entry >= c.first && m_entry < c.first + c.n) return true;
+  if (m_entry >= m_entries) return false;
+
+  // from the current entry to the end of its cluster: the baskets of all entries are read once
+  auto it = m_tree->GetClusterIterator(m_entry);
+  it.Next();
+  const long long end = std::min({it.GetNextEntry(), m_entries, m_entry + kMaxClusterEntries});
+  c.first = m_entry;
+  c.n = std::max(end - m_entry, 1LL);
+  // slots are only added: their buffers circulate between the cluster and the events
+  const auto n = static_cast<std::size_t>(c.n);
+  if (c.hits.size() < n) c.hits.resize(n);
+  if (c.tlu.size() < n) c.tlu.resize(n);
+
+  read_branch_(m_br_timestamp, [&](std::size_t k) { c.tlu[k].Timestamp = b_timestamp; });
+  read_branch_(m_br_bcid_tlu, [&](std::size_t k) { c.tlu[k].BCID_TLU = b_bc_id_tlu; });
+  read_branch_(m_br_runNo, [&](std::size_t k) { c.tlu[k].RunNo = b_runNo; });
+  read_branch_(m_br_cycleID, [&](std::size_t k) { c.tlu[k].CycleID = b_cycleID; });
+  read_branch_(m_br_triggerID, [&](std::size_t k) { c.tlu[k].TriggerID = b_triggerID; });
+  read_branch_(m_br_event_time, [&](std::size_t k) { c.tlu[k].Event_Time = static_cast<int>(b_Event_Time); });
+  auto first6 = [](const std::vector<int>* in, std::vector<int>& out) {
+    out.resize(6);
+    for (std::size_t i = 0; i < 6; ++i) out[i] = (in && in->size() > i) ? (*in)[i] : 0;
+  };
+  read_branch_(m_br_inputs, [&](std::size_t k) { first6(b_inputs, c.tlu[k].Inputs); });
+  read_branch_(m_br_fine_timestamps, [&](std::size_t k) { first6(b_fine_timestamps, c.tlu[k].FineTimestamps); });
+
+  // CellID has the column type already: ROOT fills the branch vector, which is swapped into the slot
+  // (the slot's old buffer becomes the branch vector of the next entry)
+  read_branch_(m_br_cellID, [&](std::size_t k) {
+    c.hits[k].cellID.swap(*b_cellID);
+    b_cellID->clear();
+  });
+  // the unsigned short branches are widened into the int columns, the only copy of a hit
+  auto column = [&](TBranch* br, const std::vector<unsigned short>* buf, std::vector<int> AHCALRawHitColumns::*col) {
+    read_branch_(br, [&](std::size_t k) {
+      AHCALRawHitColumns& hits = c.hits[k];
+      if (buf->size() != hits.cellID.size()) {
+        throw std::runtime_error("RootRawHitReader: branch vector size mismatch");
+      }
+      (hits.*col).assign(buf->begin(), buf->end());
+    });
+  };
+  column(m_br_hg, b_hg, &AHCALRawHitColumns::hg_adc);
+  column(m_br_lg, b_lg, &AHCALRawHitColumns::lg_adc);
+  column(m_br_bcid, b_bcid, &AHCALRawHitColumns::bcid);
+  column(m_br_hitTag, b_hitTag, &AHCALRawHitColumns::hittag);
+  LOG_DEBUG("RootRawHitReader: read entries [{}, {})", c.first, c.first + c.n);
+  return true;
 }
 
 bool RootRawHitReader::next(std::vector<AHCALRawHit>& out_hits, AHCALTLURawData& out_tlu_data) {
   ++m_entry;
   if (m_entry >= m_entries) return false;
+  if (m_bulk) {
+    if (!load_cluster_()) return false;
+    const auto k = static_cast<std::size_t>(m_entry - m_cluster.first);
+    out_tlu_data = m_cluster.tlu[k];
+    m_cluster.hits[k].to_hits(out_hits);
+    return true;
+  }
   clear_vectors_();
   m_tree->GetEntry(m_entry);
 
@@ -95,16 +221,7 @@ bool RootRawHitReader::next(std::vector<AHCALRawHit>& out_hits, AHCALTLURawData&
 
   out_hits.clear();
   out_hits.reserve(b_cellID->size());
-  out_tlu_data.Timestamp = b_timestamp;
-  out_tlu_data.BCID_TLU = b_bc_id_tlu;
-  for (int i = 0; i < 6; ++i) {
-      out_tlu_data.Inputs[i] = (b_inputs && b_inputs->size() > static_cast<size_t>(i)) ? (*b_inputs)[i] : 0;
-      out_tlu_data.FineTimestamps[i] = (b_fine_timestamps && b_fine_timestamps->size() > static_cast<size_t>(i)) ? (*b_fine_timestamps)[i] : 0;
-  }
-  out_tlu_data.RunNo = b_runNo;
-  out_tlu_data.CycleID = b_cycleID;
-  out_tlu_data.TriggerID = b_triggerID;
-  out_tlu_data.Event_Time = b_Event_Time;
+  fill_tlu_(out_tlu_data);
   for (size_t i = 0; i < b_cellID->size(); ++i) {
     AHCALRawHit h;
     h.index = static_cast<int>(i);
@@ -117,3 +234,30 @@ bool RootRawHitReader::next(std::vector<AHCALRawHit>& out_hits, AHCALTLURawData&
   }
   return true;
 }
+
+bool RootRawHitReader::next(AHCALRawHitColumns& out_hits, AHCALTLURawData& out_tlu_data) {
+  ++m_entry;
+  if (m_entry >= m_entries) return false;
+  if (m_bulk) {
+    if (!load_cluster_()) return false;
+    // hand the entry's columns over; the caller's buffers go back into the slot for a later cluster
+    const auto k = static_cast<std::size_t>(m_entry - m_cluster.first);
+    std::swap(out_hits, m_cluster.hits[k]);
+    std::swap(out_tlu_data, m_cluster.tlu[k]);
+    return true;
+  }
+  clear_vectors_();
+  m_tree->GetEntry(m_entry);
+
+  const std::size_t n = b_cellID->size();
+  if (b_hg->size() != n || b_lg->size() != n || b_bcid->size() != n || b_hitTag->size() != n) {
+    throw std::runtime_error("RootRawHitReader: branch vector size mismatch");
+  }
+  fill_tlu_(out_tlu_data);
+  out_hits.cellID.swap(*b_cellID); // refilled by the next GetEntry
+  out_hits.hg_adc.assign(b_hg->begin(), b_hg->end());
+  out_hits.lg_adc.assign(b_lg->begin(), b_lg->end());
+  out_hits.bcid.assign(b_bcid->begin(), b_bcid->end());
+  out_hits.hittag.assign(b_hitTag->begin(), b_hitTag->end());
+  return true;
+}
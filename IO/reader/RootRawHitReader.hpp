@@ -8,14 +8,26 @@
 
 class TFile;
 class TTree;
+class TBranch;
 
+// Reads the Raw_Hit tree.
+// - Default: one GetEntry per event.
+// - bulk: the entries of one TTree cluster are read branch by branch (each branch's baskets decompressed
+//   back to back through the tree cache) straight into one AHCALRawHitColumns per entry; next() then
+//   swaps those columns into the caller's, so an event's hits are never copied after the branch read.
 class RootRawHitReader {
 public:
     RootRawHitReader(std::string filename,
-                    std::string treename = "Raw_Hit");
+                    std::string treename = "Raw_Hit",
+                    bool bulk = false);
     ~RootRawHitReader();
     // returns false when no more events
     bool next(std::vector<AHCALRawHit>& out_hits, AHCALTLURawData& out_tlu_data);
+    // same entry as columns, no AHCALRawHit objects are built. The buffers of out_hits are taken over
+    // and reused for later entries (swap), so pass the event's recycled columns (EventStore::make).
+    bool next(AHCALRawHitColumns& out_hits, AHCALTLURawData& out_tlu_data);
+
+    bool bulk() const { return m_bulk; }
 
     // optional
     long long entry() const { return m_entry; }
@@ -27,6 +39,7 @@ private:
 
     long long m_entry = -1;
     long long m_entries = 0;
+    bool m_bulk = false;
     // branch buffers (simple branches) 
     int                     b_runNo;
     int                     b_triggerID;
@@ -44,9 +57,39 @@ private:
     std::vector<unsigned short>* b_hitTag = nullptr; 
     // erase no meaning data
 
+    // branches in the order the bulk mode reads them
+    TBranch* m_br_timestamp = nullptr;
+    TBranch* m_br_bcid_tlu = nullptr;
+    TBranch* m_br_inputs = nullptr;
+    TBranch* m_br_fine_timestamps = nullptr;
+    TBranch* m_br_runNo = nullptr;
+    TBranch* m_br_cycleID = nullptr;
+    TBranch* m_br_triggerID = nullptr;
+    TBranch* m_br_event_time = nullptr;
+    TBranch* m_br_cellID = nullptr;
+    TBranch* m_br_hg = nullptr;
+    TBranch* m_br_lg = nullptr;
+    TBranch* m_br_bcid = nullptr;
+    TBranch* m_br_hitTag = nullptr;
+
+    // Entries [first, first + n) of the current cluster (bulk mode), one slot per entry. A slot is
+    // swapped out by next() and gets the caller's previous buffers back, which the next cluster refills.
+    struct Cluster {
+        long long first = 0;
+        long long n = 0;
+        std::vector<AHCALRawHitColumns> hits;
+        std::vector<AHCALTLURawData> tlu;
+    };
+    Cluster m_cluster;
+
   void bind_branches_();
   void cleanup_buffers_();
   void clear_vectors_();
+  void fill_tlu_(AHCALTLURawData& out_tlu_data) const;
+  // bulk mode: make m_entry part of m_cluster; false at the end of the tree
+  bool load_cluster_();
+  template <class Fn>
+  void read_branch_(TBranch* br, Fn&& take);
 };
 
 #endif // RootRawHitReader_HPP
\ No newline at end of file
@@ -4,32 +4,90 @@
 #include "common/IAlg.hpp"
 #include "IO/writer/WriterRegistry.hpp"
 #include "common/Logger.hpp"
+#include "common/RunContext.hpp"
+#include <algorithm>
+#include <memory>
+#include <vector>
 
 class RootWriterAlg final : public IAlg {
 public:
   RootWriterAlg(RunContext& ctx, std::string name, std::string filename, WriterRegistry reg)
-    : IAlg(ctx, std::move(name)), m_out(std::move(filename)), m_reg(std::move(reg)) {}
+    : IAlg(ctx, std::move(name)), m_filename(std::move(filename)), m_reg(std::move(reg)) {}
 
+  // Re-target the output when the job moved on to an input with its own output file
+  // (MultiInOut); inputs sharing one output (MultiInOneOut) keep appending to the open file.
+  void beginInput() override {
+    if (m_out && ctx().config.output == m_filename) return;
+    m_filename = ctx().config.output;
+    open();
+  }
+
+  void finalize() override { m_out.reset(); }
+
+  // Runs the write plan: per key a slot lookup and bound copies into the branch buffers.
+  // A key missing from an event keeps the values of the previous entry, as before.
   void execute(EventStore& evt) override {
-    for (const auto& key : evt.keys()) {
-      LOG_DEBUG("Processing key='{}'", key);
-      const auto& a = evt.any(key);
-      if (!m_reg.can_write(a)) {
-        LOG_DEBUG("Skip key='{}' (type={})", key, a.type().name());
-        continue;
-      }
-      LOG_DEBUG("Writing key='{}' (type={})", key, a.type().name());
-      m_reg.write_any(key, a, m_out);
+    if (!m_out) open();
+    std::size_t present = 0;
+    for (const auto& step : m_plan) {
+      const std::any* a = evt.find_any(step.key);
+      if (!a) continue;
+      ++present;
+      if (step.write) step.write(*a);
+    }
+    if (present != evt.size()) {
+      extend_plan(evt); // first event, or keys never seen before
     }
-    m_out.fill();
+    m_out->fill();
+    ++m_entries;
   }
   void parse_cfg(const YAML::Node& n) override {
     // No specific config for RootWriterAlg
     // suppress unused parameter warning
     (void)n;
   }
+  // one output file per job: all events go through this single instance
+  bool cloneable() const override { return false; }
 
 private:
-  RootOutput m_out;
+  void open() {
+    m_plan.clear(); // bound to the buffers of the previous file
+    m_entries = 0;
+    m_out.reset(); // write and close the previous file first
+    m_out = std::make_unique<RootOutput>(m_filename);
+    LOG_INFO("RootWriterAlg: writing to {}", m_filename);
+  }
+
+  // Compile the plan steps of the keys of `evt` not planned yet and write them for this event.
+  void extend_plan(const EventStore& evt) {
+    const auto& keys = EventKeyRegistry::instance();
+    for (const auto handle : evt.handles()) {
+      const bool planned = std::any_of(m_plan.begin(), m_plan.end(), [&](const PlanStep& s) { return s.key == handle; });
+      if (planned) continue;
+      const std::string& key = keys.name(handle);
+      const std::any& a = evt.any(handle);
+      PlanStep step{handle, m_reg.bind(key, a, *m_out)};
+      if (!step.write) {
+        LOG_DEBUG("Skip key='{}' (type={})", key, a.type().name());
+      } else {
+        if (m_entries > 0) {
+          LOG_WARN("RootWriterAlg: key '{}' first appears at entry {}; its branches start there", key, m_entries);
+        }
+        LOG_DEBUG("Writing key='{}' (type={})", key, a.type().name());
+        step.write(a);
+      }
+      m_plan.push_back(std::move(step));
+    }
+  }
+
+  struct PlanStep {
+    EventKey key;
+    WriterRegistry::BoundWriterFn write; // empty: type without writer, skipped
+  };
+
+  std::string m_filename;
+  std::unique_ptr<RootOutput> m_out;
   WriterRegistry m_reg;
+  std::vector<PlanStep> m_plan;
+  long long m_entries = 0;
 };
@@ -4,7 +4,9 @@
 #include <typeindex>
 #include <unordered_map>
 #include <functional>
+#include <stdexcept>
 #include <string>
+#include <vector>
 #include "IO/writer/RootOutput.hpp"
 #include "IO/Descriptor.hpp"
 #include "common/Logger.hpp"
@@ -12,6 +14,9 @@
 class WriterRegistry {
 public:
     using WriterFn = std::function<void(const std::string& key, const std::any& a, RootOutput& out)>;
+    // Write plan: a writer bound to the branch buffers of one key in one RootOutput.
+    using BoundWriterFn = std::function<void(const std::any& a)>;
+    using BindFn = std::function<BoundWriterFn(const std::string& key, RootOutput& out)>;
 
     template <class T>
     void register_struct() {
@@ -21,6 +26,15 @@ public:
             const auto& desc = describe((const T*)nullptr);
             for (const auto& f : desc) f.write(&obj, out, key);
         };
+        m_binders[ti] = [](const std::string& key, RootOutput& out) -> BoundWriterFn {
+            std::vector<FieldDesc::BoundWrite> fields;
+            for (const auto& f : describe((const T*)nullptr)) fields.push_back(f.bind_write(out, key));
+            return [fields = std::move(fields), key](const std::any& a) {
+                const T* obj = std::any_cast<T>(&a);
+                if (!obj) throw_type_changed(key, a);
+                for (const auto& w : fields) w(obj);
+            };
+        };
         LOG_DEBUG("Registered writer for type '{}'", ti.name());
     }
 
@@ -40,6 +54,15 @@ public:
 
             for (const auto& f : desc) f.write(ptrs, out, key);
         };
+        m_binders[ti] = [](const std::string& key, RootOutput& out) -> BoundWriterFn {
+            std::vector<FieldDescVector::BoundWrite> fields;
+            for (const auto& f : describe_vector((const T*)nullptr)) fields.push_back(f.bind_write(out, key));
+            return [fields = std::move(fields), key](const std::any& a) {
+                const auto* vec = std::any_cast<std::vector<T>>(&a);
+                if (!vec) throw_type_changed(key, a);
+                for (const auto& w : fields) w(vec->data(), vec->size());
+            };
+        };
     }
 
     bool can_write(const std::any& a) const {
@@ -50,8 +73,21 @@ public:
         m_writers.at(std::type_index(a.type()))(key, a, out);
     }
 
+    // Resolve the branches of `key` (typed like `a`) once; empty if the type has no writer.
+    BoundWriterFn bind(const std::string& key, const std::any& a, RootOutput& out) const {
+        auto it = m_binders.find(std::type_index(a.type()));
+        if (it == m_binders.end()) return {};
+        return it->second(key, out);
+    }
+
 private:
+    [[noreturn]] static void throw_type_changed(const std::string& key, const std::any& a) {
+        LOG_ERROR("WriterRegistry: key '{}' changed type to {} after its branches were created", key, a.type().name());
+        throw std::runtime_error("WriterRegistry: type of key '" + key + "' changed");
+    }
+
     std::unordered_map<std::type_index, WriterFn> m_writers;
+    std::unordered_map<std::type_index, BindFn> m_binders;
 };
 
 // inline WriterRegistry& global_registry() {
@@ -0,0 +1,152 @@
+#include "AdcToEnergyKernel.hpp"
+
+#include "calibration/RefValues.hpp"
+#include "common/Logger.hpp"
+
+#include <cstddef>
+#include <stdexcept>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define FAIR_HAVE_AVX2_KERNEL 1
+#include <immintrin.h>
+#endif
+
+namespace AHCALRecoAlg {
+
+namespace {
+
+inline void convert_one(const AHCALCalib::CalibTable& calib, int cell_index, int hg_adc, int lg_adc,
+                        double& nmip, double& edep) {
+  if (cell_index < 0) {
+    nmip = 0.0;
+    edep = 0.0;
+    return;
+  }
+  const AHCALCalib::CellCalib& c = calib[cell_index];
+  const double hg = static_cast<double>(hg_adc);
+  const double lg = static_cast<double>(lg_adc);
+  const double dhg = hg - c.hg_ped;
+  if (dhg < (static_cast<double>(c.gain_plat) - AHCALRefValues::SwitchPoint)) {
+    nmip = dhg / c.mip;
+    edep = dhg * AHCALRefValues::MIP_E / c.mip;
+  } else {
+    const double dlg = (lg - c.lg_ped) * c.gain_ratio;
+    nmip = dlg / c.mip;
+    edep = dlg * AHCALRefValues::MIP_E / c.mip;
+  }
+  if (edep < 0) {
+    edep = 0.0;
+    nmip = 0.0;
+  }
+}
+
+} // namespace
+
+void adc_to_energy_scalar(const AHCALCalib::CalibTable& calib, const AdcHitsSoA& hits, double* nmip, double* edep) {
+  for (std::size_t i = 0; i < hits.n; ++i) {
+    convert_one(calib, hits.cell_index[i], hits.hg_adc[i], hits.lg_adc[i], nmip[i], edep[i]);
+  }
+}
+
+#ifdef FAIR_HAVE_AVX2_KERNEL
+
+static_assert(sizeof(AHCALCalib::CellCalib) == 64, "AVX2 gather strides assume one 64-byte CellCalib per cell");
+
+// 4 hits per iteration: gather the constants of 4 cells, compute HG and LG candidates, blend by the
+// gain-switch mask, clamp negative energies and zero cells outside the detector.
+__attribute__((target("avx2")))
+void adc_to_energy_avx2(const AHCALCalib::CalibTable& calib, const AdcHitsSoA& hits, double* nmip, double* edep) {
+  using AHCALCalib::CellCalib;
+  const double* base = reinterpret_cast<const double*>(&calib[0]);
+  const int* base_i = reinterpret_cast<const int*>(&calib[0]);
+  constexpr int kStrideD = sizeof(CellCalib) / sizeof(double);
+  constexpr int kStrideI = sizeof(CellCalib) / sizeof(int);
+
+  const __m256d mip_e = _mm256_set1_pd(AHCALRefValues::MIP_E);
+  const __m256d switch_point = _mm256_set1_pd(AHCALRefValues::SwitchPoint);
+  const __m256d zero = _mm256_setzero_pd();
+  const __m128i izero = _mm_setzero_si128();
+  const __m128i ineg = _mm_set1_epi32(-1);
+
+  std::size_t i = 0;
+  for (; i + 4 <= hits.n; i += 4) {
+    const __m128i idx = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hits.cell_index + i));
+    const __m128i valid_i = _mm_cmpgt_epi32(idx, ineg);
+    const __m256d valid = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(valid_i));
+    const __m128i off_d = _mm_mullo_epi32(idx, _mm_set1_epi32(kStrideD));
+    const __m128i off_i = _mm_mullo_epi32(idx, _mm_set1_epi32(kStrideI));
+
+    // masked gathers: lanes of cells outside the detector are not loaded (read as 0, zeroed below)
+    const __m256d mip = _mm256_mask_i32gather_pd(zero, base + offsetof(CellCalib, mip) / sizeof(double), off_d, valid, 8);
+    const __m256d hg_ped = _mm256_mask_i32gather_pd(zero, base + offsetof(CellCalib, hg_ped) / sizeof(double), off_d, valid, 8);
+    const __m256d lg_ped = _mm256_mask_i32gather_pd(zero, base + offsetof(CellCalib, lg_ped) / sizeof(double), off_d, valid, 8);
+    const __m256d ratio = _mm256_mask_i32gather_pd(zero, base + offsetof(CellCalib, gain_ratio) / sizeof(double), off_d, valid, 8);
+    const __m128i plat_i = _mm_mask_i32gather_epi32(izero, base_i + offsetof(CellCalib, gain_plat) / sizeof(int), off_i, valid_i, 4);
+
+    const __m256d hg = _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(hits.hg_adc + i)));
+    const __m256d lg = _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(hits.lg_adc + i)));
+
+    const __m256d dhg = _mm256_sub_pd(hg, hg_ped);
+    const __m256d use_hg = _mm256_cmp_pd(dhg, _mm256_sub_pd(_mm256_cvtepi32_pd(plat_i), switch_point), _CMP_LT_OQ);
+    const __m256d dlg = _mm256_mul_pd(_mm256_sub_pd(lg, lg_ped), ratio);
+
+    const __m256d d = _mm256_blendv_pd(dlg, dhg, use_hg);
+    __m256d n = _mm256_div_pd(d, mip);
+    __m256d e = _mm256_div_pd(_mm256_mul_pd(d, mip_e), mip);
+
+    const __m256d neg = _mm256_cmp_pd(e, zero, _CMP_LT_OQ);
+    const __m256d keep = _mm256_andnot_pd(neg, valid);
+    n = _mm256_and_pd(keep, n);
+    e = _mm256_and_pd(keep, e);
+
+    _mm256_storeu_pd(nmip + i, n);
+    _mm256_storeu_pd(edep + i, e);
+  }
+  for (; i < hits.n; ++i) {
+    convert_one(calib, hits.cell_index[i], hits.hg_adc[i], hits.lg_adc[i], nmip[i], edep[i]);
+  }
+}
+
+bool avx2_supported() {
+  return __builtin_cpu_supports("avx2");
+}
+
+#else
+
+void adc_to_energy_avx2(const AHCALCalib::CalibTable& calib, const AdcHitsSoA& hits, double* nmip, double* edep) {
+  adc_to_energy_scalar(calib, hits, nmip, edep);
+}
+
+bool avx2_supported() {
+  return false;
+}
+
+#endif
+
+AdcToEnergyKernel parse_adc_kernel(const std::string& name) {
+  if (name == "auto") return AdcToEnergyKernel::Auto;
+  if (name == "scalar") return AdcToEnergyKernel::Scalar;
+  if (name == "avx2") return AdcToEnergyKernel::AVX2;
+  LOG_ERROR("AdcToEnergy: unknown kernel '{}' (expected auto, scalar or avx2)", name);
+  throw std::runtime_error("AdcToEnergy: unknown kernel: " + name);
+}
+
+AdcToEnergyKernelFn select_adc_kernel(AdcToEnergyKernel kind) {
+  switch (kind) {
+    case AdcToEnergyKernel::Scalar:
+      return &adc_to_energy_scalar;
+    case AdcToEnergyKernel::AVX2:
+      if (avx2_supported()) return &adc_to_energy_avx2;
+      LOG_WARN("AdcToEnergy: AVX2 kernel requested but not supported by this CPU, using scalar");
+      return &adc_to_energy_scalar;
+    case AdcToEnergyKernel::Auto:
+    default:
+      return avx2_supported() ? &adc_to_energy_avx2 : &adc_to_energy_scalar;
+  }
+}
+
+const char* adc_kernel_name(AdcToEnergyKernelFn fn) {
+  return fn == &adc_to_energy_avx2 ? "avx2" : "scalar";
+}
+
+} // namespace AHCALRecoAlg
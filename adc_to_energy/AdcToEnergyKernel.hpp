@@ -0,0 +1,35 @@
+#ifndef ADC_TO_ENERGY_KERNEL_HPP
+#define ADC_TO_ENERGY_KERNEL_HPP
+#include "calibration/CalibTable.hpp"
+#include <cstddef>
+#include <string>
+
+namespace AHCALRecoAlg {
+    // Hits of one event in SoA form. cell_index is AHCALGeometry::CellIndex(cellID) (-1: outside the detector).
+    struct AdcHitsSoA {
+        const int* cell_index = nullptr;
+        const int* hg_adc = nullptr;
+        const int* lg_adc = nullptr;
+        std::size_t n = 0;
+    };
+
+    // Per-hit outputs; hits outside the detector get 0.
+    // HG is used while (hg - hg_ped) < gain_plat - SwitchPoint, LG * gain_ratio above; negative energies are clamped to 0.
+    // Every implementation evaluates the same expressions in the same order, so results are bitwise identical.
+    using AdcToEnergyKernelFn = void (*)(const AHCALCalib::CalibTable& calib, const AdcHitsSoA& hits,
+                                         double* nmip, double* edep);
+
+    enum class AdcToEnergyKernel { Auto, Scalar, AVX2 };
+
+    void adc_to_energy_scalar(const AHCALCalib::CalibTable& calib, const AdcHitsSoA& hits, double* nmip, double* edep);
+    // Only call when avx2_supported(); built with a target attribute, no global -mavx2 needed.
+    void adc_to_energy_avx2(const AHCALCalib::CalibTable& calib, const AdcHitsSoA& hits, double* nmip, double* edep);
+
+    bool avx2_supported();
+    // "auto" | "scalar" | "avx2" (throws on anything else)
+    AdcToEnergyKernel parse_adc_kernel(const std::string& name);
+    // Runtime dispatch: Auto picks AVX2 when the CPU has it; AVX2 falls back to scalar (with a warning) when not.
+    AdcToEnergyKernelFn select_adc_kernel(AdcToEnergyKernel kind);
+    const char* adc_kernel_name(AdcToEnergyKernelFn fn);
+}
+#endif // ADC_TO_ENERGY_KERNEL_HPP
@@ -1,5 +1,6 @@
 #include "AdcToEnergyReadTTreeAlg.hpp"
 
+#include "calibration/CalibSnapshot.hpp"
 #include "calibration/RefValues.hpp"
 #include "common/edm/EDM.hpp"
 #include "common/Logger.hpp"
@@ -9,12 +10,14 @@
 #include <TFile.h>
 #include <TTree.h>
 
+#include <algorithm>
+#include <stdexcept>
 #include <utility>
 #include <vector>
 AHCAL_REGISTER_ALG(AHCALRecoAlg::AdcToEnergyReadTTreeAlg, "AdcToEnergyReadTTreeAlg")
 namespace AHCALRecoAlg {
 
-bool AdcToEnergyReadTTreeAlg::initialize_mip(){
+bool AdcToEnergyReadTTreeAlg::initialize_mip(AHCALCalib::CalibTable& calib){
   std::string mip_file_name = m_cfg.mip_file;
   std::string cut_string = m_cfg.mip_cut_string;
   file_cellid_version = m_cfg.mip_cellid_version;
@@ -52,35 +55,47 @@ bool AdcToEnergyReadTTreeAlg::initialize_mip(){
     return false;
   }
 
+  std::vector<char> loaded(AHCALGeometry::cell_No, 0);
+  std::size_t nskipped = 0;
   for (size_t i = 0; i < cellids.size(); ++i) {
     const int conv_cellid = cellid_conversion(cellids[i]);
-    mip_map[conv_cellid] = mpvs[i];
+    const int idx = AHCALGeometry::CellIndex(conv_cellid);
+    if (idx < 0) {
+      LOG_DEBUG("MIP entry for cellID={} outside the detector ignored", conv_cellid);
+      ++nskipped;
+      continue;
+    }
+    calib[idx].mip = mpvs[i];
+    loaded[idx] = 1;
   }
 
-  const int nonref = static_cast<int>(mip_map.size());
-  LOG_INFO("Loaded {} MIP entries from {}", mip_map.size(), mip_file_name);
+  LOG_INFO("Loaded MIP values for {} cells from {}", std::count(loaded.begin(), loaded.end(), 1), mip_file_name);
+  if (nskipped > 0) LOG_WARN("Skipped {} of {} MIP entries with a cellID outside the detector", nskipped, cellids.size());
 
+  int nref = 0;
   for (int layer = 0; layer < AHCALGeometry::Layer_No; ++layer) {
     for (int chip = 0; chip < AHCALGeometry::chip_No; ++chip) {
       for (int channel = 0; channel < AHCALGeometry::channel_No; ++channel) {
         const int cellid = layer * 100000 + chip * 10000 + channel;
-        if (mip_map.find(cellid) == mip_map.end()) {
-          mip_map[cellid] = AHCALRefValues::ref_MIP;
-        }else if (mip_map[cellid]<=100.0){
-          LOG_DEBUG("Low MIP value detected: cellID={} MPV={}", cellid, mip_map[cellid]);
-          mip_map[cellid] = AHCALRefValues::ref_MIP;
+        const int idx = AHCALGeometry::CellIndex(cellid);
+        auto& c = calib[idx];
+        if (!loaded[idx]) {
+          c.mip = AHCALRefValues::ref_MIP;
+          ++nref;
+        }else if (c.mip<=100.0){
+          LOG_DEBUG("Low MIP value detected: cellID={} MPV={}", cellid, c.mip);
+          c.mip = AHCALRefValues::ref_MIP;
         }
       }
     }
   }
 
   LOG_INFO("Reference MIP values assigned for cut channels.");
-  LOG_INFO("Total channels with reference MIP: {}",
-           static_cast<int>(mip_map.size()) - nonref);
+  LOG_INFO("Total channels with reference MIP: {}", nref);
   return true;
 }
 
-bool AdcToEnergyReadTTreeAlg::initialize_ped( ){
+bool AdcToEnergyReadTTreeAlg::initialize_ped(AHCALCalib::CalibTable& calib){
   std::string ped_file_name = m_cfg.ped_file;
   std::string cut_string = m_cfg.ped_cut_string;
   file_cellid_version = m_cfg.ped_cellid_version;
@@ -120,37 +135,39 @@ bool AdcToEnergyReadTTreeAlg::initialize_ped( ){
     return false;
   }
 
+  std::vector<char> loaded(AHCALGeometry::cell_No, 0);
+  std::size_t nskipped = 0;
   for (size_t i = 0; i < cellids.size(); ++i) {
     const int conv_cellid = cellid_conversion(cellids[i]);
-    hg_ped_map[conv_cellid] = hg[i];
-    lg_ped_map[conv_cellid] = lg[i];
+    const int idx = AHCALGeometry::CellIndex(conv_cellid);
+    if (idx < 0) {
+      LOG_DEBUG("Pedestal entry for cellID={} outside the detector ignored", conv_cellid);
+      ++nskipped;
+      continue;
+    }
+    calib[idx].hg_ped = hg[i];
+    calib[idx].lg_ped = lg[i];
+    loaded[idx] = 1;
   }
 
-  const int nonref = static_cast<int>(hg_ped_map.size());
-  LOG_INFO("Loaded {} pedestal entries from {}", hg_ped_map.size(), ped_file_name);
+  LOG_INFO("Loaded pedestals for {} cells from {}", std::count(loaded.begin(), loaded.end(), 1), ped_file_name);
+  if (nskipped > 0) LOG_WARN("Skipped {} of {} pedestal entries with a cellID outside the detector", nskipped, cellids.size());
 
-  for (int layer = 0; layer < AHCALGeometry::Layer_No; ++layer) {
-    for (int chip = 0; chip < AHCALGeometry::chip_No; ++chip) {
-      for (int channel = 0; channel < AHCALGeometry::channel_No; ++channel) {
-        const int cellid = layer * 100000 + chip * 10000 + channel;
-        if (hg_ped_map.find(cellid) == hg_ped_map.end()) {
-          hg_ped_map[cellid] = AHCALRefValues::ref_ped_highgain;
-        }
-        if (lg_ped_map.find(cellid) == lg_ped_map.end()) {
-          lg_ped_map[cellid] = AHCALRefValues::ref_ped_lowgain;
-        }
-      }
-    }
+  int nref = 0;
+  for (int idx = 0; idx < calib.size(); ++idx) {
+    if (loaded[idx]) continue;
+    calib[idx].hg_ped = AHCALRefValues::ref_ped_highgain;
+    calib[idx].lg_ped = AHCALRefValues::ref_ped_lowgain;
+    ++nref;
   }
 
   LOG_INFO("Reference pedestal values assigned for cut channels.");
-  LOG_INFO("Total channels with reference pedestal: {}",
-           static_cast<int>(hg_ped_map.size()) - nonref);
+  LOG_INFO("Total channels with reference pedestal: {}", nref);
 
   return true;
 }
 
-bool AdcToEnergyReadTTreeAlg::initialize_dac( ){
+bool AdcToEnergyReadTTreeAlg::initialize_dac(AHCALCalib::CalibTable& calib){
   std::string dac_file_name = m_cfg.dac_file;
   std::string cut_string = m_cfg.dac_cut_string;
   file_cellid_version = m_cfg.dac_cellid_version;
@@ -190,36 +207,93 @@ bool AdcToEnergyReadTTreeAlg::initialize_dac( ){
     return false;
   }
 
+  std::vector<char> loaded(AHCALGeometry::cell_No, 0);
+  std::size_t nskipped = 0;
   for (size_t i = 0; i < cellids.size(); ++i) {
     const int conv_cellid = cellid_conversion(cellids[i]);
-    gainratio_map[conv_cellid] = slopes[i];
-    gainplat_map[conv_cellid] = static_cast<int>(plats[i]);
+    const int idx = AHCALGeometry::CellIndex(conv_cellid);
+    if (idx < 0) {
+      LOG_DEBUG("DAC entry for cellID={} outside the detector ignored", conv_cellid);
+      ++nskipped;
+      continue;
+    }
+    calib[idx].gain_ratio = slopes[i];
+    calib[idx].gain_plat = static_cast<int>(plats[i]);
+    loaded[idx] = 1;
   }
 
-  const int nonref = static_cast<int>(gainratio_map.size());
-  LOG_INFO("Loaded {} DAC entries from {}", gainratio_map.size(), dac_file_name);
+  LOG_INFO("Loaded DAC values for {} cells from {}", std::count(loaded.begin(), loaded.end(), 1), dac_file_name);
+  if (nskipped > 0) LOG_WARN("Skipped {} of {} DAC entries with a cellID outside the detector", nskipped, cellids.size());
 
-  for (int layer = 0; layer < AHCALGeometry::Layer_No; ++layer) {
-    for (int chip = 0; chip < AHCALGeometry::chip_No; ++chip) {
-      for (int channel = 0; channel < AHCALGeometry::channel_No; ++channel) {
-        const int cellid = layer * 100000 + chip * 10000 + channel;
-        if (gainratio_map.find(cellid) == gainratio_map.end()) {
-          gainratio_map[cellid] = AHCALRefValues::ref_gain_ratio;
-        }
-        if (gainplat_map.find(cellid) == gainplat_map.end()) {
-          gainplat_map[cellid] = AHCALRefValues::lowgain_plat;
-        }
-      }
-    }
+  int nref = 0;
+  for (int idx = 0; idx < calib.size(); ++idx) {
+    if (loaded[idx]) continue;
+    calib[idx].gain_ratio = AHCALRefValues::ref_gain_ratio;
+    calib[idx].gain_plat = AHCALRefValues::lowgain_plat;
+    ++nref;
   }
 
   LOG_INFO("Reference DAC values assigned for cut channels.");
-  LOG_INFO("Total channels with reference DAC: {}",
-           static_cast<int>(gainratio_map.size()) - nonref);
+  LOG_INFO("Total channels with reference DAC: {}", nref);
 
   return true;
 }
 
+void AdcToEnergyReadTTreeAlg::initialize() {
+  auto calib = std::make_shared<AHCALCalib::CalibTable>();
+  std::uint64_t key = 0;
+  if (!m_cfg.snapshot.empty()) {
+    key = snapshot_key();
+    if (AHCALCalib::load_snapshot(m_cfg.snapshot, key, *calib)) {
+      LOG_INFO("Calibration loaded from snapshot {}", m_cfg.snapshot);
+      m_calib = std::move(calib);
+      return;
+    }
+  }
+  const bool ok_mip = initialize_mip(*calib);
+  const bool ok_ped = initialize_ped(*calib);
+  const bool ok_dac = initialize_dac(*calib);
+  if (!m_cfg.snapshot.empty()) {
+    if (ok_mip && ok_ped && ok_dac) {
+      AHCALCalib::save_snapshot(m_cfg.snapshot, key, *calib);
+    } else {
+      LOG_WARN("Calibration incomplete, snapshot {} not written", m_cfg.snapshot);
+    }
+  }
+  m_calib = std::move(calib);
+}
+
+// Worker copies use the table of the first instance: the calibration is read once per job, not per worker.
+void AdcToEnergyReadTTreeAlg::initialize_clone(const IAlg& first) {
+  const auto* src = dynamic_cast<const AdcToEnergyReadTTreeAlg*>(&first);
+  if (!src || !src->m_calib) {
+    initialize();
+    return;
+  }
+  m_calib = src->m_calib;
+  LOG_DEBUG("{}: sharing the calibration table of {}", name(), src->name());
+}
+
+// Everything the calibration table is built from: if any of it changes, the snapshot is rebuilt.
+std::uint64_t AdcToEnergyReadTTreeAlg::snapshot_key() const {
+  AHCALCalib::SnapshotKey k;
+  k.add_file(m_cfg.mip_file);
+  k.add_string(m_cfg.mip_cut_string);
+  k.add_value(m_cfg.mip_cellid_version);
+  k.add_file(m_cfg.ped_file);
+  k.add_string(m_cfg.ped_cut_string);
+  k.add_value(m_cfg.ped_cellid_version);
+  k.add_file(m_cfg.dac_file);
+  k.add_string(m_cfg.dac_cut_string);
+  k.add_value(m_cfg.dac_cellid_version);
+  for (const double v : {AHCALRefValues::ref_MIP, AHCALRefValues::ref_ped_highgain, AHCALRefValues::ref_ped_lowgain,
+                         AHCALRefValues::ref_gain_ratio}) {
+    k.add_value(v);
+  }
+  k.add_value(AHCALRefValues::lowgain_plat);
+  return k.value();
+}
+
 AdcToEnergyReadTTreeAlg::~AdcToEnergyReadTTreeAlg() {
   if (m_in_file) {
     m_in_file->Close();
@@ -242,50 +316,102 @@ int AdcToEnergyReadTTreeAlg::cellid_conversion(int input_cellid) {
 }
 
 void AdcToEnergyReadTTreeAlg::execute(EventStore &evt) { 
-  auto raw_hits = evt.get<std::vector<AHCALRawHit>>(m_in_rawhit_key);
-
-  std::vector<AHCALRecoHit> reco_hits;
-  reco_hits.reserve(raw_hits.size());
-
-  const int SwitchPoint = AHCALRefValues::SwitchPoint;
-
-  for (const auto &raw_hit : raw_hits) {
-    AHCALRecoHit reco_hit;
+  if (m_in_rawhit_columns.valid()) {
+    execute_columns(evt);
+    return;
+  }
+  const auto raw_hits = evt.view<AHCALRawHit>(m_in_rawhit);
+  const std::size_t n = raw_hits.size();
+
+  m_cell_index.resize(n);
+  m_hg_adc.resize(n);
+  m_lg_adc.resize(n);
+  m_nmip.resize(n);
+  m_edep.resize(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    const int idx = AHCALGeometry::CellIndex(raw_hits[i].cellID);
+    if (idx < 0) {
+      LOG_DEBUG("Hit with cellID={} outside the detector: no calibration, zero energy", raw_hits[i].cellID);
+    }
+    m_cell_index[i] = idx;
+    m_hg_adc[i] = raw_hits[i].hg_adc;
+    m_lg_adc[i] = raw_hits[i].lg_adc;
+  }
+  m_kernel(*m_calib, AdcHitsSoA{m_cell_index.data(), m_hg_adc.data(), m_lg_adc.data(), n},
+           m_nmip.data(), m_edep.data());
+
+  // filled in place: the output vector of the previous event is recycled with its capacity
+  auto& reco_hits = evt.make<std::vector<AHCALRecoHit>>(m_out_recohit);
+  reco_hits.resize(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    const auto &raw_hit = raw_hits[i];
+    AHCALRecoHit& reco_hit = reco_hits[i];
     reco_hit.cellID = raw_hit.cellID;
     reco_hit.index = raw_hit.index;
-    const double mpv        = mip_map[raw_hit.cellID];
-    const double hg_ped     = hg_ped_map[raw_hit.cellID];
-    const double lg_ped     = lg_ped_map[raw_hit.cellID];
-    const double gain_ratio = gainratio_map[raw_hit.cellID];
-    const int gain_plat     = gainplat_map[raw_hit.cellID];
-
-    const double hg = static_cast<double>(raw_hit.hg_adc);
-    const double lg = static_cast<double>(raw_hit.lg_adc);
-
-    if ((hg - hg_ped) < (static_cast<double>(gain_plat) - SwitchPoint)) {
-      reco_hit.Nmip = (hg - hg_ped) / mpv;
-      reco_hit.Edep = (hg - hg_ped) * AHCALRefValues::MIP_E / mpv;
-    } else {
-      reco_hit.Nmip = (lg - lg_ped) * gain_ratio / mpv;
-      reco_hit.Edep = (lg - lg_ped) * gain_ratio * AHCALRefValues::MIP_E / mpv;
-    }
-    if (reco_hit.Edep < 0) {
-      reco_hit.Edep = 0;
-      reco_hit.Nmip = 0;
-    }
+    reco_hit.Nmip = m_nmip[i];
+    reco_hit.Edep = m_edep[i];
     if (reco_hit.Nmip >1e6){
+      const auto& c = (*m_calib)[m_cell_index[i]];
       LOG_DEBUG("Large Nmip detected: cellID={} Nmip={}", reco_hit.cellID, reco_hit.Nmip);
       LOG_DEBUG("  raw HG={} LG={} HG_ped={} LG_ped={} gain_ratio={} gain_plat={} mpv={}",
-                hg, lg, hg_ped, lg_ped, gain_ratio, gain_plat, mpv);
+                raw_hit.hg_adc, raw_hit.lg_adc, c.hg_ped, c.lg_ped, c.gain_ratio, c.gain_plat, c.mip);
     }
-    reco_hits.push_back(reco_hit);
   }
+  if (m_out_hitcollection.valid()) put_hit_collection(evt, reco_hits, m_hg_adc.data(), m_lg_adc.data());
   LOG_DEBUG("Converted {} raw hits to reco hits.", reco_hits.size());
-  evt.put(m_out_recohit_key, std::move(reco_hits));
+}
+
+// Same conversion on AHCALRawHitColumns: the ADC columns go to the kernel as they are.
+void AdcToEnergyReadTTreeAlg::execute_columns(EventStore &evt) {
+  const auto& raw = evt.read<AHCALRawHitColumns>(m_in_rawhit_columns);
+  const std::size_t n = raw.size();
+  if (raw.hg_adc.size() != n || raw.lg_adc.size() != n) {
+    LOG_ERROR("AdcToEnergy: raw hit columns of different length (cellID={} hg={} lg={})", n, raw.hg_adc.size(),
+              raw.lg_adc.size());
+    throw std::runtime_error("AdcToEnergy: raw hit column size mismatch");
+  }
+
+  m_cell_index.resize(n);
+  m_nmip.resize(n);
+  m_edep.resize(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    m_cell_index[i] = AHCALGeometry::CellIndex(raw.cellID[i]);
+  }
+  m_kernel(*m_calib, AdcHitsSoA{m_cell_index.data(), raw.hg_adc.data(), raw.lg_adc.data(), n},
+           m_nmip.data(), m_edep.data());
+
+  auto& reco_hits = evt.make<std::vector<AHCALRecoHit>>(m_out_recohit);
+  reco_hits.resize(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    AHCALRecoHit& reco_hit = reco_hits[i];
+    reco_hit.cellID = raw.cellID[i];
+    reco_hit.index = static_cast<int>(i);
+    reco_hit.Nmip = m_nmip[i];
+    reco_hit.Edep = m_edep[i];
+  }
+  if (m_out_hitcollection.valid()) put_hit_collection(evt, reco_hits, raw.hg_adc.data(), raw.lg_adc.data());
+  LOG_DEBUG("Converted {} raw hit columns to reco hits.", n);
+}
+
+// The converted hits also as a HitCollection: ADCs and energies side by side, geometry decoded once.
+void AdcToEnergyReadTTreeAlg::put_hit_collection(EventStore &evt, const std::vector<AHCALRecoHit>& reco_hits,
+                                                 const int* hg_adc, const int* lg_adc) {
+  const std::size_t n = reco_hits.size();
+  auto& hits = evt.make<HitCollection>(m_out_hitcollection);
+  hits.resize(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    hits.set_cell(i, reco_hits[i].cellID);
+    hits.hg_adc[i] = hg_adc[i];
+    hits.lg_adc[i] = lg_adc[i];
+    hits.Edep[i] = reco_hits[i].Edep;
+    hits.Nmip[i] = reco_hits[i].Nmip;
+  }
 }
 void AdcToEnergyReadTTreeAlg::parse_cfg(const YAML::Node& n) {
     m_cfg.in_rawhit_key = get_or<std::string>(n, "in_rawhit_key", m_cfg.in_rawhit_key);
+    m_cfg.in_rawhit_columns_key = get_or<std::string>(n, "in_rawhit_columns_key", m_cfg.in_rawhit_columns_key);
     m_cfg.out_recohit_key = get_or<std::string>(n, "out_recohit_key", m_cfg.out_recohit_key);
+    m_cfg.out_hitcollection_key = get_or<std::string>(n, "out_hitcollection_key", m_cfg.out_hitcollection_key);
     const YAML::Node mip_node = n["mip"];
     if (mip_node) {
         m_cfg.mip_file = get_or<std::string>(mip_node, "file", m_cfg.mip_file);
@@ -304,7 +430,19 @@ void AdcToEnergyReadTTreeAlg::parse_cfg(const YAML::Node& n) {
         m_cfg.dac_cut_string = get_or<std::string>(dac_node, "cut", m_cfg.dac_cut_string);
         m_cfg.dac_cellid_version = get_or<int>(dac_node, "cellid_version", m_cfg.dac_cellid_version);
     }
+    m_cfg.kernel = get_or<std::string>(n, "kernel", m_cfg.kernel);
+    m_cfg.snapshot = get_or<std::string>(n, "snapshot", m_cfg.snapshot);
+    m_kernel = select_adc_kernel(parse_adc_kernel(m_cfg.kernel));
+    LOG_INFO("AdcToEnergyReadTTreeAlg: using {} ADC-to-energy kernel", adc_kernel_name(m_kernel));
     m_in_rawhit_key = m_cfg.in_rawhit_key;
     m_out_recohit_key = m_cfg.out_recohit_key;
+    m_in_rawhit = EventKeyRegistry::instance().intern(m_in_rawhit_key);
+    m_out_recohit = EventKeyRegistry::instance().intern(m_out_recohit_key);
+    if (!m_cfg.in_rawhit_columns_key.empty()) {
+      m_in_rawhit_columns = EventKeyRegistry::instance().intern(m_cfg.in_rawhit_columns_key);
+    }
+    if (!m_cfg.out_hitcollection_key.empty()) {
+      m_out_hitcollection = EventKeyRegistry::instance().intern(m_cfg.out_hitcollection_key);
+    }
   }
 } // namespace AHCALRecoAlg
\ No newline at end of file
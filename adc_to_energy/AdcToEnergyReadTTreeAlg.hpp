@@ -2,18 +2,23 @@
 #define ADC_TO_ENERGY_READ_TTree_HPP
 #include "common/EventStore.hpp"
 #include "common/IAlg.hpp"
+#include "calibration/CalibTable.hpp"
+#include "AdcToEnergyKernel.hpp"
+#include "common/edm/RecoHit.hpp"
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <memory>
 #include <TFile.h>
 #include <TTree.h>
-#include <map>
 #include <tuple>
 
 namespace AHCALRecoAlg {
     struct AdcToEnergyReadTTreeAlgCfg{
         std::string in_rawhit_key = "RawHits";
+        std::string in_rawhit_columns_key = ""; // AHCALRawHitColumns input, used instead of in_rawhit_key when set
         std::string out_recohit_key = "RecoHits";
+        std::string out_hitcollection_key = ""; // HitCollection output in addition to the RecoHits (empty: none)
         int mip_cellid_version = 1;
         int ped_cellid_version = 1;
         int dac_cellid_version = 1;
@@ -23,34 +28,49 @@ namespace AHCALRecoAlg {
         std::string mip_cut_string = "";
         std::string ped_cut_string = "";
         std::string dac_cut_string = "";
+        std::string kernel = "auto"; // auto | scalar | avx2
+        std::string snapshot = "";   // binary calibration snapshot (empty: always read the ROOT files)
     };
     class AdcToEnergyReadTTreeAlg final : public IAlg {
     public:
         AdcToEnergyReadTTreeAlg(RunContext& ctx, std::string name)
             : IAlg(ctx, name){ }
         ~AdcToEnergyReadTTreeAlg();
-        bool initialize_mip();
-        bool initialize_ped();
-        bool initialize_dac();
+        bool initialize_mip(AHCALCalib::CalibTable& calib);
+        bool initialize_ped(AHCALCalib::CalibTable& calib);
+        bool initialize_dac(AHCALCalib::CalibTable& calib);
         void execute(EventStore& evt) override;
         void parse_cfg(const YAML::Node& n);
-        void initialize() override {
-            initialize_mip();
-            initialize_ped();
-            initialize_dac();
+        void initialize() override;
+        void initialize_clone(const IAlg& first) override;
+        std::vector<std::string> inputs() const override {
+            return {m_cfg.in_rawhit_columns_key.empty() ? m_in_rawhit_key : m_cfg.in_rawhit_columns_key};
+        }
+        std::vector<std::string> outputs() const override {
+            if (m_cfg.out_hitcollection_key.empty()) return {m_out_recohit_key};
+            return {m_out_recohit_key, m_cfg.out_hitcollection_key};
         }
     private:
         std::string m_in_rawhit_key;
         std::string m_out_recohit_key;
+        EventKey m_in_rawhit; // handles of the keys above, resolved in parse_cfg
+        EventKey m_out_recohit;
+        EventKey m_in_rawhit_columns;
+        EventKey m_out_hitcollection;
         std::unique_ptr<TFile> m_in_file;
         int file_cellid_version = 1; 
         TTree* m_in_tree = nullptr;
-        std::map<int, double> mip_map; // cellID to MPV
-        std::map<int, double> hg_ped_map; // cellID to pedestal
-        std::map<int, double> lg_ped_map; // cellID to pedestal
-        std::map<int, double> gainratio_map; // cellID to gain ratio
-        std::map<int, int> gainplat_map; // cellID to gain plat
+        // MIP / pedestal / DAC constants per cell; built once per job, shared by the per-worker clones
+        std::shared_ptr<const AHCALCalib::CalibTable> m_calib;
+        AdcToEnergyKernelFn m_kernel = &adc_to_energy_scalar;
+        // per-event SoA scratch for the kernel, reused across events
+        std::vector<int> m_cell_index, m_hg_adc, m_lg_adc;
+        std::vector<double> m_nmip, m_edep;
+        void execute_columns(EventStore& evt);
+        void put_hit_collection(EventStore& evt, const std::vector<AHCALRecoHit>& reco_hits, const int* hg_adc,
+                                const int* lg_adc);
         int cellid_conversion(int input_cellid);
+        std::uint64_t snapshot_key() const;
         AdcToEnergyReadTTreeAlgCfg m_cfg;
     };
 }
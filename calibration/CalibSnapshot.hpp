@@ -0,0 +1,144 @@
+#ifndef CALIB_SNAPSHOT_HPP
+#define CALIB_SNAPSHOT_HPP
+#include "calibration/CalibTable.hpp"
+#include "common/Logger.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+
+// Binary snapshot of a fully built CalibTable (cuts applied, reference values filled):
+//   64-byte header | cell_No x CellCalib (64 bytes each)
+// The header carries a key over everything the table was built from (source file contents, cut
+// strings, cellid versions, reference values); a snapshot whose key does not match is ignored.
+// Loading maps the file copy-on-write, so no parsing and no copy happen at startup.
+namespace AHCALCalib {
+    constexpr char kSnapshotMagic[8] = {'F', 'A', 'I', 'R', 'C', 'A', 'L', '\0'};
+    constexpr std::uint32_t kSnapshotVersion = 1;
+
+    struct alignas(64) SnapshotHeader {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t cell_size;
+        std::uint32_t n_cells;
+        std::uint32_t reserved;
+        std::uint64_t key;
+    };
+    static_assert(sizeof(SnapshotHeader) == 64, "snapshot header must keep the cells 64-byte aligned");
+
+    // 64-bit FNV-1a, used to build snapshot keys.
+    class SnapshotKey {
+    public:
+        void add(const void* data, std::size_t n) {
+            const auto* p = static_cast<const unsigned char*>(data);
+            for (std::size_t i = 0; i < n; ++i) {
+                m_hash ^= p[i];
+                m_hash *= 1099511628211ull;
+            }
+        }
+        template <class T>
+        void add_value(const T& v) { add(&v, sizeof(v)); }
+        void add_string(const std::string& s) {
+            add_value(static_cast<std::uint64_t>(s.size()));
+            add(s.data(), s.size());
+        }
+        // Hashes the file contents; a missing file is hashed as such (and will not match a real one).
+        bool add_file(const std::string& path) {
+            add_string(path);
+            std::ifstream in(path, std::ios::binary);
+            if (!in) {
+                add_value(std::uint64_t{0});
+                return false;
+            }
+            char buf[1 << 16];
+            std::uint64_t size = 0;
+            while (in.read(buf, sizeof(buf)) || in.gcount() > 0) {
+                add(buf, static_cast<std::size_t>(in.gcount()));
+                size += static_cast<std::uint64_t>(in.gcount());
+            }
+            add_value(size);
+            return true;
+        }
+        std::uint64_t value() const { return m_hash; }
+
+    private:
+        std::uint64_t m_hash = 1469598103934665603ull;
+    };
+
+    // Map `path` into `table` if it is a valid snapshot for `key`. Returns false (table untouched) otherwise.
+    inline bool load_snapshot(const std::string& path, std::uint64_t key, CalibTable& table) {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            LOG_INFO("CalibSnapshot: no snapshot at {}", path);
+            return false;
+        }
+        struct stat st {};
+        const std::size_t want = sizeof(SnapshotHeader) + sizeof(CellCalib) * AHCALGeometry::cell_No;
+        if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) != want) {
+            LOG_WARN("CalibSnapshot: {} has unexpected size, ignored", path);
+            ::close(fd);
+            return false;
+        }
+        void* addr = ::mmap(nullptr, want, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED) {
+            LOG_WARN("CalibSnapshot: cannot map {}", path);
+            return false;
+        }
+        std::shared_ptr<void> mapping(addr, [want](void* p) { ::munmap(p, want); });
+
+        const auto* h = static_cast<const SnapshotHeader*>(addr);
+        if (std::memcmp(h->magic, kSnapshotMagic, sizeof(kSnapshotMagic)) != 0 || h->version != kSnapshotVersion ||
+            h->cell_size != sizeof(CellCalib) || h->n_cells != static_cast<std::uint32_t>(AHCALGeometry::cell_No)) {
+            LOG_WARN("CalibSnapshot: {} is not a compatible snapshot (format version {}), ignored", path, kSnapshotVersion);
+            return false;
+        }
+        if (h->key != key) {
+            LOG_INFO("CalibSnapshot: {} was built from different inputs, rebuilding", path);
+            return false;
+        }
+        auto* cells = reinterpret_cast<CellCalib*>(static_cast<char*>(addr) + sizeof(SnapshotHeader));
+        table.adopt(std::move(mapping), cells);
+        return true;
+    }
+
+    // Write the snapshot next to its final path and rename it into place, so concurrent jobs
+    // never see a partial file.
+    inline bool save_snapshot(const std::string& path, std::uint64_t key, const CalibTable& table) {
+        SnapshotHeader h{};
+        std::memcpy(h.magic, kSnapshotMagic, sizeof(kSnapshotMagic));
+        h.version = kSnapshotVersion;
+        h.cell_size = sizeof(CellCalib);
+        h.n_cells = static_cast<std::uint32_t>(AHCALGeometry::cell_No);
+        h.key = key;
+
+        const std::string tmp = path + ".tmp." + std::to_string(::getpid());
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+            out.write(reinterpret_cast<const char*>(table.data()),
+                      static_cast<std::streamsize>(sizeof(CellCalib) * AHCALGeometry::cell_No));
+            if (!out) {
+                LOG_WARN("CalibSnapshot: cannot write {}", tmp);
+                std::remove(tmp.c_str());
+                return false;
+            }
+        }
+        if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+            LOG_WARN("CalibSnapshot: cannot move snapshot into place: {}", path);
+            std::remove(tmp.c_str());
+            return false;
+        }
+        LOG_INFO("CalibSnapshot: wrote {}", path);
+        return true;
+    }
+}
+#endif
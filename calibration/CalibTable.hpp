@@ -0,0 +1,54 @@
+#ifndef CALIB_TABLE_HPP
+#define CALIB_TABLE_HPP
+#include "common/AHCALGeometry.hpp"
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace AHCALCalib {
+    // All constants needed to convert one hit, on a single cache line.
+    struct alignas(64) CellCalib {
+        double mip = 0.0;        // MIP MPV [ADC]
+        double hg_ped = 0.0;     // high gain pedestal [ADC]
+        double lg_ped = 0.0;     // low gain pedestal [ADC]
+        double gain_ratio = 0.0; // HG / LG
+        int gain_plat = 0;       // HG saturation plateau [ADC]
+    };
+
+    // Dense per-cell calibration table indexed by AHCALGeometry::CellIndex (40 x 9 x 36 cells).
+    // The cells live either in owned storage or in an adopted mapping (e.g. an mmap'ed snapshot file).
+    class CalibTable {
+    public:
+        CalibTable() : m_storage(AHCALGeometry::cell_No), m_cells(m_storage.data()) {}
+        CalibTable(const CalibTable&) = delete;
+        CalibTable& operator=(const CalibTable&) = delete;
+
+        // nullptr if the cellID is outside the detector
+        const CellCalib* find(int cellID) const {
+            const int idx = AHCALGeometry::CellIndex(cellID);
+            return idx < 0 ? nullptr : &m_cells[idx];
+        }
+        CellCalib* find(int cellID) {
+            const int idx = AHCALGeometry::CellIndex(cellID);
+            return idx < 0 ? nullptr : &m_cells[idx];
+        }
+
+        CellCalib& operator[](int index) { return m_cells[index]; }
+        const CellCalib& operator[](int index) const { return m_cells[index]; }
+        int size() const { return AHCALGeometry::cell_No; }
+        const CellCalib* data() const { return m_cells; }
+
+        // Use cell_No cells owned by `mapping` instead of the own storage.
+        void adopt(std::shared_ptr<void> mapping, CellCalib* cells) {
+            m_mapping = std::move(mapping);
+            m_cells = cells;
+            std::vector<CellCalib>().swap(m_storage);
+        }
+
+    private:
+        std::vector<CellCalib> m_storage;
+        std::shared_ptr<void> m_mapping;
+        CellCalib* m_cells = nullptr;
+    };
+}
+#endif
@@ -374,14 +374,14 @@ PedestalAlg::~PedestalAlg() {
 void PedestalAlg::execute(EventStore& evt) {
   if (!impl_) impl_.reset(new Impl(cfg_));
 
-  auto raw_hits = evt.get<std::vector<AHCALRawHit>>(cfg_.in_rawhit_key);
-  for (const auto& h : raw_hits) {
+  for (const auto& h : evt.view<AHCALRawHit>(in_rawhit_)) {
     impl_->fill(h);
   }
 }
 
 void PedestalAlg::parse_cfg(const YAML::Node& n) {
   cfg_.in_rawhit_key = get_or<std::string>(n, "in_rawhit_key", cfg_.in_rawhit_key);
+  in_rawhit_ = EventKeyRegistry::instance().intern(cfg_.in_rawhit_key);
 
   cfg_.pedestal_to_file = get_or<bool>(n, "pedestal_to_file", cfg_.pedestal_to_file);
   cfg_.out_pedestal_filename = get_or<std::string>(n, "out_pedestal_filename", cfg_.out_pedestal_filename);
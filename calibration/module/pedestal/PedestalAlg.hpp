@@ -39,9 +39,13 @@ namespace AHCALRecoAlg{
 
         void execute(EventStore& evt) override;
         void parse_cfg(const YAML::Node& cfg) override;
+        // histograms are accumulated over the whole job
+        bool cloneable() const override { return false; }
+        std::vector<std::string> inputs() const override { return {cfg_.in_rawhit_key}; }
 
     private:
         PedestalAlgCfg cfg_;
+        EventKey in_rawhit_; // handle of cfg_.in_rawhit_key, resolved in parse_cfg
 
         struct Impl;
 
@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include <vector>
 // #include "EventFormats/AHCALDataFragment.hpp"
 
@@ -8,8 +9,9 @@ namespace AHCALGeometry {
     const int chip_No = 9;
     const int channel_No = 36;
     const int Layer_No = 40;
-    const double _Pos_X[channel_No]={100.2411,100.2411,100.2411,59.94146,59.94146,59.94146,19.64182,19.64182,19.64182,19.64182,59.94146,100.2411,100.2411,59.94146,19.64182,100.2411,59.94146,19.64182,-20.65782,-60.95746,-101.2571,-20.65782,-60.95746,-101.2571,-101.2571,-60.95746,-20.65782,-20.65782,-20.65782,-20.65782,-60.95746,-60.95746,-60.95746,-101.2571,-101.2571,-101.2571};
-    const double _Pos_Y[channel_No]={141.04874,181.34838,221.64802,141.04874,181.34838,221.64802,141.04874,181.34838,221.64802,261.94766,261.94766,261.94766,302.2473,302.2473,302.2473,342.54694,342.54694,342.54694,342.54694,342.54694,342.54694,302.2473,302.2473,302.2473,261.94766,261.94766,261.94766,221.64802,181.34838,141.04874,221.64802,181.34838,141.04874,221.64802,181.34838,141.04874};
+    const int cell_No = Layer_No*chip_No*channel_No; // 12960
+    constexpr double _Pos_X[channel_No]={100.2411,100.2411,100.2411,59.94146,59.94146,59.94146,19.64182,19.64182,19.64182,19.64182,59.94146,100.2411,100.2411,59.94146,19.64182,100.2411,59.94146,19.64182,-20.65782,-60.95746,-101.2571,-20.65782,-60.95746,-101.2571,-101.2571,-60.95746,-20.65782,-20.65782,-20.65782,-20.65782,-60.95746,-60.95746,-60.95746,-101.2571,-101.2571,-101.2571};
+    constexpr double _Pos_Y[channel_No]={141.04874,181.34838,221.64802,141.04874,181.34838,221.64802,141.04874,181.34838,221.64802,261.94766,261.94766,261.94766,302.2473,302.2473,302.2473,342.54694,342.54694,342.54694,342.54694,342.54694,342.54694,302.2473,302.2473,302.2473,261.94766,261.94766,261.94766,221.64802,181.34838,141.04874,221.64802,181.34838,141.04874,221.64802,181.34838,141.04874};
     const int _Channel[6][6]={  { 0, 1, 2,11,12,15},
                                 { 3, 4, 5,10,13,16},
                                 { 6, 7, 8, 9,14,17},
@@ -20,15 +22,15 @@ namespace AHCALGeometry {
                             {5,4,3},
                             {8,7,6}};
                             
-    const double chip_dis_X=239.3;
-    const double chip_dis_Y=241.8;
-    const double HBU_X=239.3;
-    const double HBU_Y=725.4;
+    constexpr double chip_dis_X=239.3;
+    constexpr double chip_dis_Y=241.8;
+    constexpr double HBU_X=239.3;
+    constexpr double HBU_Y=725.4;
     const double x_max = 40.3*18/2;
     const double y_max = 40.3*18/2;
     const double xy_size = 40.;
     const double z_size = 3.;
-    inline double Pos_X(int channel_ID,int chip_ID){
+    constexpr double Pos_X(int channel_ID,int chip_ID){
         // int HBU_ID=chip_ID/3;
         chip_ID=chip_ID%3;
         if(chip_ID!=0){
@@ -39,11 +41,11 @@ namespace AHCALGeometry {
         }
         return (_Pos_Y[channel_ID]-chip_ID*chip_dis_Y);
     }
-    inline double Pos_Y(int channel_ID,int chip_ID,int HBU_ID=0){
+    constexpr double Pos_Y(int channel_ID,int chip_ID,int HBU_ID=0){
         HBU_ID=chip_ID/3;
         return -(-_Pos_X[channel_ID]+(HBU_ID-1)*HBU_X);
     }
-    inline double Pos_Z(int layer_ID){
+    constexpr double Pos_Z(int layer_ID){
         return layer_ID*29.63 + 1.5; // start from first layer scintillator front face // TEMPORARY 
         // TODO : read the geometry file
     }
@@ -61,5 +63,51 @@ namespace AHCALGeometry {
         }
         return -1; // not found
     }
+    // Compact cell index in [0, cell_No) from cellID = layer*100000 + chip*10000 + channel,
+    // -1 if the cellID is outside the detector. Used to index dense per-cell tables.
+    inline int CellIndex(int cellID){
+        const int layer = cellID/100000;
+        const int chip = cellID/10000%10;
+        const int channel = cellID%10000;
+        if (cellID < 0 || layer >= Layer_No || chip >= chip_No || channel >= channel_No) return -1;
+        return (layer*chip_No + chip)*channel_No + channel;
+    }
+
+    // Position of a cell, as given by Pos_X/Pos_Y/Pos_Z, and its tile index on the 18x18 grid
+    // (xIndex = int(x/40.3 + 9), the same as AHCALRecoHit::Xindex()).
+    struct CellPosition {
+        double x = 0.0;
+        double y = 0.0;
+        double z = 0.0;
+        int xIndex = 0;
+        int yIndex = 0;
+    };
+    constexpr CellPosition ComputeCellPosition(int layer, int chip, int channel){
+        CellPosition p;
+        p.x = Pos_X(channel, chip);
+        p.y = Pos_Y(channel, chip);
+        p.z = Pos_Z(layer);
+        p.xIndex = static_cast<int>(p.x / 40.3 + 9.0);
+        p.yIndex = static_cast<int>(p.y / 40.3 + 9.0);
+        return p;
+    }
+    constexpr std::array<CellPosition, cell_No> MakeCellTable(){
+        std::array<CellPosition, cell_No> table{};
+        for (int layer = 0; layer < Layer_No; ++layer)
+            for (int chip = 0; chip < chip_No; ++chip)
+                for (int channel = 0; channel < channel_No; ++channel)
+                    table[(layer*chip_No + chip)*channel_No + channel] = ComputeCellPosition(layer, chip, channel);
+        return table;
+    }
+    // All cells, indexed by CellIndex(); built at compile time, so lookups skip the cellID decoding
+    // and the chip channel swap of Pos_X.
+    inline constexpr std::array<CellPosition, cell_No> CellTable = MakeCellTable();
+
+    // Position of the cell `cellID` from the table; cellIDs outside the detector are computed directly.
+    inline CellPosition CellPos(int cellID){
+        const int idx = CellIndex(cellID);
+        if (idx >= 0) return CellTable[idx];
+        return ComputeCellPosition(cellID/100000, cellID/10000%10, cellID%10000);
+    }
 }
 
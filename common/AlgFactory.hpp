@@ -4,12 +4,14 @@
 #include <string>
 #include <vector>
 #include <stdexcept>
+#include <algorithm>
 
 #include "common/config/YAMLUtil.hpp"
 #include "common/RunContext.hpp"
 #include "common/IAlg.hpp"
 #include "common/config/ParseRunConfig.hpp"
 #include "common/AlgRegistry.hpp"
+#include "common/EventLoop.hpp"
 // ---- calibration structs ----
 #include "calibration/module/pedestal/PedestalAlg.hpp"
 // ---- your alg headers ----
@@ -56,10 +58,9 @@ inline ReaderRegistry parse_reader_registry(const YAML::Node& n) {
       throw std::runtime_error("Invalid inputlist entry size");
     }
     const auto& type = type_array[0];
-    const auto& key  = type_array[1];
 
     if (auto fn = IOTypeRegistry::instance().get_reader(type)) {
-      fn(reg, key);
+      fn(reg, type); // readers are looked up by type name (readandput / make_read_plan)
       continue;
     }
 
@@ -95,6 +96,28 @@ inline void readandput(const YAML::Node& n, EventStore& store, ReaderRegistry& r
   }
 }
 
+// Bind every [type, key] of `inputlist` against `in` once; plan.read(store) then fills one event.
+inline ReadPlan make_read_plan(const YAML::Node& n, const ReaderRegistry& rr, RootInput& in) {
+  const auto out = require_node(n, "inputlist");
+  if (!out.IsSequence()) throw std::runtime_error("RootInput.cfg.inputlist must be a sequence");
+
+  ReadPlan plan;
+  for (const auto& x : out) {
+    const auto type_array = x.as<std::vector<std::string>>();
+    if (type_array.size() != 2) {
+      LOG_ERROR("AlgFactory::make_read_plan: Each inputlist entry must be a pair of [type, key]");
+      throw std::runtime_error("Invalid inputlist entry size");
+    }
+    const auto& type = type_array[0];
+    const auto& key  = type_array[1];
+    plan.add(rr.bind(type, key, EventKeyRegistry::instance().intern(key), in));
+    LOG_DEBUG("AlgFactory::make_read_plan: bound '{}' as {}", key, type);
+  }
+  // only the bound branches are active now; cacheSizeMB <= 0 sizes the cache from them
+  in.configure_cache(static_cast<Long64_t>(get_or<double>(n, "cacheSizeMB", 0.0) * 1024 * 1024));
+  return plan;
+}
+
 inline std::unique_ptr<IAlg> make_alg(RunContext& ctx, const YAML::Node& alg_node) {
   const std::string type = require_string(alg_node, "type");
   const YAML::Node cfg = alg_node["cfg"] ? alg_node["cfg"] : YAML::Node(YAML::NodeType::Map);
@@ -128,4 +151,68 @@ inline std::vector<std::unique_ptr<IAlg>> build_pipeline(RunContext& ctx, const
   return v;
 }
 
+// The output stage runs the non-cloneable algs after every cloned alg of the event. Reject sequences in which
+// that moves a producer behind its consumer: a cloned alg reading a key written by a non-cloneable alg
+// before it would run fine serially but fail with "missing key" in the pipelined loop.
+inline void check_output_stage_order(const std::vector<IAlg*>& seq) {
+  for (std::size_t i = 0; i < seq.size(); ++i) {
+    if (seq[i]->cloneable()) continue;
+    const auto out = seq[i]->outputs();
+    for (std::size_t j = i + 1; j < seq.size(); ++j) {
+      if (!seq[j]->cloneable()) continue;
+      for (const auto& key : seq[j]->inputs()) {
+        if (std::find(out.begin(), out.end(), key) == out.end()) continue;
+        LOG_ERROR("AlgFactory: '{}' reads '{}', written by '{}' which is not cloneable and runs on the output stage,"
+                  " after all cloned algs", seq[j]->name(), key, seq[i]->name());
+        throw std::runtime_error("AlgFactory: cloned alg '" + seq[j]->name() + "' reads '" + key +
+                                 "' from output-stage alg '" + seq[i]->name() + "'");
+      }
+    }
+  }
+}
+
+// Build the per-job PipelineStages for nThreads worker threads.
+// The full sequence is built once; cloneable algorithms are then re-created from their YAML node for
+// every additional worker, so non-cloneable ones (e.g. RootWriterAlg opening the output) exist once.
+// nAlgThreads > 1 adds a task pool shared by all workers to run independent algs of an event in parallel.
+inline PipelineStages build_pipeline_stages(RunContext& ctx, const YAML::Node& root, int nThreads, int nAlgThreads = 1) {
+  const auto& algs = require_node(root, "algs");
+  if (!algs.IsSequence()) throw std::runtime_error("algs must be a YAML sequence");
+
+  PipelineStages st;
+  st.workers.resize(static_cast<std::size_t>(std::max(1, nThreads)));
+  std::vector<std::size_t> cloned;
+  for (std::size_t i = 0; i < algs.size(); ++i) {
+    auto alg = make_alg(ctx, algs[i]);
+    st.sequence.push_back(alg.get());
+    if (alg->cloneable()) {
+      cloned.push_back(i);
+      st.workers[0].emplace_back(std::move(alg));
+    } else {
+      st.sink.emplace_back(std::move(alg));
+    }
+  }
+  check_output_stage_order(st.sequence);
+  for (std::size_t iw = 1; iw < st.workers.size(); ++iw) {
+    st.workers[iw].reserve(cloned.size());
+    for (const auto i : cloned) st.workers[iw].emplace_back(make_alg(ctx, algs[i]));
+  }
+  if (st.workers.size() > 1) {
+    LOG_INFO("AlgFactory: {} workers x {} cloned algs, {} serial algs on the output stage",
+             st.workers.size(), cloned.size(), st.sink.size());
+  }
 
+  if (nAlgThreads > 1) st.pool = std::make_unique<TaskPool>(static_cast<std::size_t>(nAlgThreads));
+  st.serial_graph = AlgScheduler(st.sequence, st.pool.get());
+  for (auto& chain : st.workers) {
+    std::vector<IAlg*> algs;
+    for (auto& alg : chain) algs.push_back(alg.get());
+    st.graphs.emplace_back(std::move(algs), st.pool.get());
+  }
+  if (st.pool) {
+    const auto& g = st.workers.size() > 1 ? st.graphs.front() : st.serial_graph;
+    LOG_INFO("AlgFactory: dependency graph of {} algs, {} levels, up to {} concurrent algs per event ({} task threads){}",
+             g.size(), g.depth(), g.width(), st.pool->size(), g.parallel() ? "" : " -> no parallelism, running serially");
+  }
+  return st;
+}
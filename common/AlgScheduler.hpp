@@ -0,0 +1,159 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common/EventStore.hpp"
+#include "common/IAlg.hpp"
+#include "common/Logger.hpp"
+#include "common/TaskPool.hpp"
+
+// Runs one algorithm sequence on an event as a dependency graph.
+// Edge i -> j (i before j in YAML order) when j reads a key written by i, writes a key read by i,
+// writes the same key as i, or when either alg declares no keys at all (barrier).
+// Independent algs of the same event then run concurrently on the shared TaskPool; the calling thread
+// takes part by running the first ready alg of every chain itself.
+// Without a pool, or when the graph is a plain chain, execute() is the historic serial YAML-order loop.
+class AlgScheduler {
+public:
+  AlgScheduler() = default;
+
+  AlgScheduler(std::vector<IAlg*> algs, TaskPool* pool)
+    : m_algs(std::move(algs)), m_pool(pool) {
+    const std::size_t n = m_algs.size();
+    m_succ.assign(n, {});
+    m_nparents.assign(n, 0);
+    std::vector<std::vector<std::string>> in(n), out(n);
+    std::vector<bool> barrier(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      in[i] = m_algs[i]->inputs();
+      out[i] = m_algs[i]->outputs();
+      barrier[i] = in[i].empty() && out[i].empty();
+      // slots of declared keys exist in every EventStore created from now on, so concurrent algs
+      // never grow the slot table (see EventStore)
+      for (const auto& k : in[i]) EventKeyRegistry::instance().intern(k);
+      for (const auto& k : out[i]) EventKeyRegistry::instance().intern(k);
+    }
+    auto overlap = [](const std::vector<std::string>& a, const std::vector<std::string>& b) {
+      for (const auto& x : a)
+        if (std::find(b.begin(), b.end(), x) != b.end()) return true;
+      return false;
+    };
+    std::vector<int> level(n, 0);
+    for (std::size_t j = 0; j < n; ++j) {
+      for (std::size_t i = 0; i < j; ++i) {
+        const bool dep = barrier[i] || barrier[j] || overlap(out[i], in[j]) || overlap(in[i], out[j]) ||
+                         overlap(out[i], out[j]);
+        if (!dep) continue;
+        m_succ[i].push_back(j);
+        ++m_nparents[j];
+        level[j] = std::max(level[j], level[i] + 1);
+      }
+      if (m_nparents[j] == 0) m_roots.push_back(j);
+    }
+
+    std::vector<std::size_t> width(n + 1, 0);
+    for (std::size_t i = 0; i < n; ++i) {
+      ++width[static_cast<std::size_t>(level[i])];
+      m_depth = std::max(m_depth, static_cast<std::size_t>(level[i]) + 1);
+      LOG_DEBUG("AlgScheduler: [{}] {} level={} parents={}", i, m_algs[i]->name(), level[i], m_nparents[i]);
+    }
+    m_width = n ? *std::max_element(width.begin(), width.end()) : 0;
+    if (m_pool && m_width > 1) m_state = std::make_unique<State>(n);
+  }
+
+  std::size_t size() const { return m_algs.size(); }
+  // length of the critical path (number of levels) and the widest level
+  std::size_t depth() const { return m_depth; }
+  std::size_t width() const { return m_width; }
+  bool parallel() const { return m_state != nullptr; }
+
+  void execute(EventStore& evt) {
+    if (!m_state) {
+      for (auto* alg : m_algs) alg->execute(evt);
+      return;
+    }
+    State& st = *m_state;
+    for (std::size_t i = 0; i < m_algs.size(); ++i) st.remaining[i].store(m_nparents[i], std::memory_order_relaxed);
+    st.left.store(m_algs.size(), std::memory_order_relaxed);
+    st.failed.store(false, std::memory_order_relaxed);
+    st.error = nullptr;
+
+    for (std::size_t r = 1; r < m_roots.size(); ++r) submit(m_roots[r], evt);
+    run_from(m_roots.front(), evt);
+
+    {
+      std::unique_lock<std::mutex> lk(st.mtx);
+      st.cv.wait(lk, [&] { return st.left.load(std::memory_order_acquire) == 0; });
+    }
+    if (st.error) std::rethrow_exception(st.error);
+  }
+
+private:
+  struct State {
+    explicit State(std::size_t n) : remaining(new std::atomic<int>[n]) {}
+    std::unique_ptr<std::atomic<int>[]> remaining;
+    std::atomic<std::size_t> left{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex mtx;
+    std::condition_variable cv;
+  };
+
+  void submit(std::size_t i, EventStore& evt) {
+    m_pool->submit([this, i, &evt] { run_from(i, evt); });
+  }
+
+  // Run alg i, then release its successors: the first one that becomes ready continues on this
+  // thread, the others go to the pool. After a failure the remaining algs are skipped but still counted.
+  // The last alg of the event is counted down under st.mtx and notifies before unlocking, so execute()
+  // cannot see left == 0 and return (next event, or destroying the scheduler) while it is still in here.
+  void run_from(std::size_t i, EventStore& evt) {
+    State& st = *m_state;
+    const std::size_t none = m_algs.size();
+    for (;;) {
+      if (!st.failed.load(std::memory_order_relaxed)) {
+        try {
+          m_algs[i]->execute(evt);
+        } catch (...) {
+          LOG_ERROR("AlgScheduler: {} aborted by exception", m_algs[i]->name());
+          std::lock_guard<std::mutex> lk(st.mtx);
+          if (!st.error) st.error = std::current_exception();
+          st.failed.store(true);
+        }
+      }
+      std::size_t next = none;
+      for (const auto s : m_succ[i]) {
+        if (st.remaining[s].fetch_sub(1, std::memory_order_acq_rel) != 1) continue;
+        if (next == none) next = s;
+        else submit(s, evt);
+      }
+      // lock-free while other algs are outstanding; left only decreases, so whoever sees 1 is the last
+      std::size_t left = st.left.load(std::memory_order_acquire);
+      while (left > 1 && !st.left.compare_exchange_weak(left, left - 1, std::memory_order_acq_rel)) {}
+      if (left == 1) {
+        std::lock_guard<std::mutex> lk(st.mtx);
+        st.left.store(0, std::memory_order_release);
+        st.cv.notify_all();
+        return;
+      }
+      if (next == none) return;
+      i = next;
+    }
+  }
+
+  std::vector<IAlg*> m_algs;
+  TaskPool* m_pool = nullptr;
+  std::vector<std::vector<std::size_t>> m_succ;
+  std::vector<int> m_nparents;
+  std::vector<std::size_t> m_roots;
+  std::size_t m_depth = 0;
+  std::size_t m_width = 0;
+  std::unique_ptr<State> m_state;
+};
@@ -0,0 +1,161 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// End-of-job counters of a BoundedQueue.
+struct BoundedQueueStats {
+  unsigned long long pushed = 0;
+  unsigned long long full_waits = 0;   // push() found the queue full (producer throttled)
+  unsigned long long empty_waits = 0;  // pop() found the queue empty (consumer starved)
+  unsigned long long depth_sum = 0;    // sum of depth seen at each push, for the mean
+  std::size_t max_depth = 0;
+  std::size_t capacity = 0;
+  double mean_depth() const { return pushed ? static_cast<double>(depth_sum) / pushed : 0.0; }
+};
+
+// Bounded lock-free multi-producer / multi-consumer queue (Vyukov ring buffer).
+// - capacity is rounded up to a power of two
+// - push() blocks (spin -> yield -> short sleep) while the queue is full: this is the back-pressure
+//   that keeps a fast producer from running ahead of its consumers
+// - pop() blocks while empty and returns false once the queue is close()d and drained,
+//   or immediately when the shared abort flag is raised
+// - counters are relaxed and only meant for end-of-job reporting
+template <class T>
+class BoundedQueue {
+public:
+  using Stats = BoundedQueueStats;
+
+  explicit BoundedQueue(std::size_t capacity, const std::atomic<bool>* abort = nullptr)
+    : m_abort(abort) {
+    std::size_t cap = 2;
+    while (cap < capacity) cap <<= 1;
+    m_mask = cap - 1;
+    m_cells = std::vector<Cell>(cap);
+    for (std::size_t i = 0; i < cap; ++i) m_cells[i].seq.store(i, std::memory_order_relaxed);
+  }
+
+  BoundedQueue(const BoundedQueue&) = delete;
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+  std::size_t capacity() const { return m_mask + 1; }
+
+  std::size_t depth() const {
+    const std::size_t e = m_enqueue.load(std::memory_order_relaxed);
+    const std::size_t d = m_dequeue.load(std::memory_order_relaxed);
+    return e > d ? e - d : 0;
+  }
+
+  bool try_push(T& v) {
+    std::size_t pos = m_enqueue.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& c = m_cells[pos & m_mask];
+      const std::size_t seq = c.seq.load(std::memory_order_acquire);
+      const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+      if (diff == 0) {
+        if (m_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          c.data = std::move(v);
+          c.seq.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false; // full
+      } else {
+        pos = m_enqueue.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool try_pop(T& out) {
+    std::size_t pos = m_dequeue.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& c = m_cells[pos & m_mask];
+      const std::size_t seq = c.seq.load(std::memory_order_acquire);
+      const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+      if (diff == 0) {
+        if (m_dequeue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          out = std::move(c.data);
+          c.seq.store(pos + m_mask + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false; // empty
+      } else {
+        pos = m_dequeue.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Blocking push. Returns false only if aborted.
+  bool push(T&& v) {
+    bool waited = false;
+    for (unsigned spin = 0; !try_push(v); ++spin) {
+      if (aborted()) return false;
+      if (!waited) { waited = true; m_full_waits.fetch_add(1, std::memory_order_relaxed); }
+      backoff(spin);
+    }
+    const std::size_t d = depth();
+    m_pushed.fetch_add(1, std::memory_order_relaxed);
+    m_depth_sum.fetch_add(d, std::memory_order_relaxed);
+    std::size_t m = m_max_depth.load(std::memory_order_relaxed);
+    while (d > m && !m_max_depth.compare_exchange_weak(m, d, std::memory_order_relaxed)) {}
+    return true;
+  }
+
+  // Blocking pop. Returns false when closed and drained, or aborted.
+  bool pop(T& out) {
+    bool waited = false;
+    for (unsigned spin = 0; !try_pop(out); ++spin) {
+      if (aborted()) return false;
+      if (m_closed.load(std::memory_order_acquire)) return try_pop(out);
+      if (!waited) { waited = true; m_empty_waits.fetch_add(1, std::memory_order_relaxed); }
+      backoff(spin);
+    }
+    return true;
+  }
+
+  // No more pushes will follow.
+  void close() { m_closed.store(true, std::memory_order_release); }
+
+  Stats stats() const {
+    Stats s;
+    s.pushed = m_pushed.load(std::memory_order_relaxed);
+    s.full_waits = m_full_waits.load(std::memory_order_relaxed);
+    s.empty_waits = m_empty_waits.load(std::memory_order_relaxed);
+    s.depth_sum = m_depth_sum.load(std::memory_order_relaxed);
+    s.max_depth = m_max_depth.load(std::memory_order_relaxed);
+    s.capacity = capacity();
+    return s;
+  }
+
+private:
+  struct Cell {
+    std::atomic<std::size_t> seq{0};
+    T data{};
+  };
+
+  bool aborted() const { return m_abort && m_abort->load(std::memory_order_relaxed); }
+
+  static void backoff(unsigned spin) {
+    if (spin < 64) return;
+    if (spin < 1024) { std::this_thread::yield(); return; }
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+  }
+
+  std::vector<Cell> m_cells;
+  std::size_t m_mask = 0;
+  const std::atomic<bool>* m_abort = nullptr;
+
+  alignas(64) std::atomic<std::size_t> m_enqueue{0};
+  alignas(64) std::atomic<std::size_t> m_dequeue{0};
+  alignas(64) std::atomic<bool> m_closed{false};
+
+  std::atomic<unsigned long long> m_pushed{0};
+  std::atomic<unsigned long long> m_full_waits{0};
+  std::atomic<unsigned long long> m_empty_waits{0};
+  std::atomic<unsigned long long> m_depth_sum{0};
+  std::atomic<std::size_t> m_max_depth{0};
+};
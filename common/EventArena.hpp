@@ -0,0 +1,92 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// Per-event scratch memory (std::pmr::memory_resource) owned by the EventStore: algorithms build their
+// temporaries as std::pmr containers on evt.arena() instead of the heap.
+// - Bump allocation from one block; deallocate() is a no-op and reset() (EventStore::clear) rewinds in O(1).
+// - An event that does not fit spills to the heap; the next reset() grows the block to the high-water mark,
+//   so steady-state processing does no malloc/free.
+// - Memory is only valid until the end of the event: never put arena-backed objects into the EventStore.
+// - Allocation is serialized, algorithms of the same event may share the arena (AlgScheduler).
+class EventArena final : public std::pmr::memory_resource {
+public:
+  explicit EventArena(std::size_t initial_bytes = 64 * 1024) { grow(initial_bytes); }
+  EventArena(const EventArena&) = delete;
+  EventArena& operator=(const EventArena&) = delete;
+  ~EventArena() override { release_spills(); }
+
+  void reset() {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    const std::size_t used = m_used + m_spilled;
+    m_high_water = std::max(m_high_water, used);
+    if (!m_spills.empty()) {
+      release_spills();
+      grow(m_high_water);
+    }
+    m_used = 0;
+    m_spilled = 0;
+  }
+
+  std::size_t capacity() const { return m_capacity; }
+  // Largest amount of memory one event has used.
+  std::size_t high_water() const {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    return std::max(m_high_water, m_used + m_spilled);
+  }
+
+private:
+  struct Spill {
+    void* p;
+    std::size_t bytes;
+    std::size_t align;
+  };
+
+  void* do_allocate(std::size_t bytes, std::size_t align) override {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    const std::size_t start = (m_used + align - 1) & ~(align - 1);
+    if (align <= kBlockAlign && start + bytes <= m_capacity) {
+      m_used = start + bytes;
+      return m_block.get() + start;
+    }
+    void* p = ::operator new(bytes, std::align_val_t(align));
+    m_spills.push_back(Spill{p, bytes, align});
+    m_spilled += bytes + align;
+    return p;
+  }
+
+  void do_deallocate(void*, std::size_t, std::size_t) override {}
+
+  bool do_is_equal(const std::pmr::memory_resource& o) const noexcept override { return this == &o; }
+
+  void grow(std::size_t bytes) {
+    std::size_t cap = 4096;
+    while (cap < bytes) cap *= 2;
+    if (cap <= m_capacity) return;
+    m_block.reset(static_cast<std::byte*>(::operator new(cap, std::align_val_t(kBlockAlign))));
+    m_capacity = cap;
+  }
+
+  void release_spills() {
+    for (const auto& s : m_spills) ::operator delete(s.p, s.bytes, std::align_val_t(s.align));
+    m_spills.clear();
+  }
+
+  static constexpr std::size_t kBlockAlign = 64;
+  struct BlockDeleter {
+    void operator()(std::byte* p) const { ::operator delete(p, std::align_val_t(kBlockAlign)); }
+  };
+
+  std::unique_ptr<std::byte, BlockDeleter> m_block;
+  std::size_t m_capacity = 0;
+  std::size_t m_used = 0;
+  std::size_t m_spilled = 0;
+  std::size_t m_high_water = 0;
+  std::vector<Spill> m_spills;
+  mutable std::mutex m_mtx;
+};
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Handle of an interned EventStore key: the index of its slot in every EventStore.
+// Resolve handles once at configure time (parse_cfg / before the event loop) and use them in execute();
+// a lookup by handle is an index and a type check, no string is built or hashed.
+struct EventKey {
+  static constexpr std::uint32_t npos = 0xffffffffu;
+  std::uint32_t id = npos;
+
+  bool valid() const { return id != npos; }
+  friend bool operator==(EventKey a, EventKey b) { return a.id == b.id; }
+  friend bool operator!=(EventKey a, EventKey b) { return a.id != b.id; }
+};
+
+// Process-wide key table: the same name always maps to the same handle, so handles resolved by
+// one algorithm instance are valid in every EventStore of the job. Keys are never removed.
+class EventKeyRegistry {
+public:
+  static EventKeyRegistry& instance() {
+    static EventKeyRegistry inst;
+    return inst;
+  }
+
+  // Handle for `name`, registering it on first use.
+  EventKey intern(std::string_view name) {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    auto it = m_ids.find(name);
+    if (it != m_ids.end()) return EventKey{it->second};
+    const auto id = static_cast<std::uint32_t>(m_names.size());
+    m_names.emplace_back(name);
+    m_ids.emplace(m_names.back(), id);  // the view points into m_names (stable in a deque)
+    return EventKey{id};
+  }
+
+  // Handle for `name` if it was ever registered (invalid otherwise); never registers.
+  EventKey find(std::string_view name) const {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    auto it = m_ids.find(name);
+    return it == m_ids.end() ? EventKey{} : EventKey{it->second};
+  }
+
+  // The reference stays valid for the lifetime of the process.
+  const std::string& name(EventKey key) const {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    return m_names.at(key.id);
+  }
+
+  std::size_t size() const {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    return m_names.size();
+  }
+
+private:
+  EventKeyRegistry() = default;
+
+  std::deque<std::string> m_names;
+  std::unordered_map<std::string_view, std::uint32_t> m_ids;
+  mutable std::mutex m_mtx;
+};
@@ -0,0 +1,242 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "common/AlgScheduler.hpp"
+#include "common/BoundedQueue.hpp"
+#include "common/EventStore.hpp"
+#include "common/IAlg.hpp"
+#include "common/Logger.hpp"
+
+using AlgSequence = std::vector<std::unique_ptr<IAlg>>;
+
+// Job-wide layout of the algorithm sequence for (optionally) parallel processing.
+// - workers : one instance of every cloneable algorithm per worker thread, YAML order
+// - sink    : non-cloneable algorithms (writers, job-wide accumulators), one instance,
+//             executed serially on every event after the worker chain
+// - sequence: all instances of worker 0 + sink in YAML order (used by the serial loop)
+// - graphs  : dependency-graph scheduler of every worker chain, serial_graph the one of `sequence`;
+//             with a TaskPool (run.nAlgThreads > 1) independent algs of one event run concurrently
+struct PipelineStages {
+  std::vector<AlgSequence> workers;
+  AlgSequence sink;
+  std::vector<IAlg*> sequence;
+  std::vector<AlgScheduler> graphs;
+  AlgScheduler serial_graph;
+  std::unique_ptr<TaskPool> pool; // declared last: its threads are joined before the graphs go away
+
+  // initialize() on worker 0 and the sink, initialize_clone() on the copies of the other workers
+  void initialize() {
+    for (std::size_t iw = 0; iw < workers.size(); ++iw) {
+      for (std::size_t i = 0; i < workers[iw].size(); ++i) {
+        if (iw == 0) workers[0][i]->initialize();
+        else workers[iw][i]->initialize_clone(*workers[0][i]);
+      }
+    }
+    for (auto& alg : sink) alg->initialize();
+  }
+
+  template <class Fn>
+  void for_each_alg(Fn&& fn) {
+    for (auto& chain : workers) for (auto& alg : chain) fn(*alg);
+    for (auto& alg : sink) fn(*alg);
+  }
+};
+
+struct EventLoopOptions {
+  bool ordered = true;          // keep input order at the output stage
+  bool pipelined = false;       // staged reader / workers / writer threads even with a single worker
+  std::size_t queueDepth = 0;   // capacity of each inter-stage queue (0: 4 x number of workers)
+};
+
+// Drives events from a source through PipelineStages.
+// serial   : nThreads <= 1 and not pipelined; plain loop in YAML order (identical to the historic drivers).
+// pipelined: reader thread -> N worker threads -> writer thread, connected by bounded lock-free queues.
+//            The reader blocks when the input queue is full and workers block when the output queue is
+//            full (back-pressure), so at most ~2 x queueDepth + N events are alive at any time.
+//            With `ordered` the writer re-sequences events before running the sink algorithms.
+class EventLoop {
+public:
+  // Fill the next event into the (empty) store. Return false at end of input.
+  using Source = std::function<bool(EventStore&)>;
+
+  struct QueueStats {
+    BoundedQueueStats input;
+    BoundedQueueStats output;
+    std::size_t max_reorder = 0;
+    std::size_t event_stores = 0; // EventStores allocated (the rest of the events reused them)
+  };
+
+  EventLoop(PipelineStages& stages, EventLoopOptions opt = {})
+    : m_stages(stages), m_opt(opt) {}
+
+  // Returns the number of events passed to the sink.
+  long long run(const Source& next_event) {
+    if (m_stages.workers.size() <= 1 && !m_opt.pipelined) return run_serial(next_event);
+    return run_pipelined(next_event);
+  }
+
+  // Queue-depth counters of the last pipelined run().
+  const QueueStats& stats() const { return m_stats; }
+
+private:
+  // Events travel as pointers into a pool of EventStores: a store goes back to the reader after the
+  // sink, so its slots, recycled payloads and arena are reused instead of reallocated per event.
+  struct Slot {
+    long long seq = -1;
+    std::unique_ptr<EventStore> evt;
+  };
+
+  long long run_serial(const Source& next_event) {
+    long long n = 0;
+    EventStore evt;
+    while (next_event(evt)) {
+      m_stages.serial_graph.execute(evt);
+      evt.clear();
+      ++n;
+    }
+    return n;
+  }
+
+  long long run_pipelined(const Source& next_event) {
+    const std::size_t nWorkers = m_stages.workers.size();
+    const std::size_t depth = m_opt.queueDepth > 0 ? m_opt.queueDepth : 4 * nWorkers;
+
+    std::atomic<bool> abort{false};
+    std::mutex err_mtx;
+    std::exception_ptr error;
+    auto fail = [&](const char* stage) {
+      LOG_ERROR("EventLoop: {} stage aborted by exception", stage);
+      std::lock_guard<std::mutex> lk(err_mtx);
+      if (!error) error = std::current_exception();
+      abort.store(true);
+    };
+
+    BoundedQueue<Slot> in_q(depth, &abort);
+    BoundedQueue<Slot> out_q(depth, &abort);
+    std::atomic<std::size_t> running_workers{nWorkers};
+    std::atomic<long long> sunk{0};
+    std::size_t max_reorder = 0;
+    // ordered output: never let the reader run further ahead of the writer than the queues can hold,
+    // otherwise one slow event lets the reorder buffer grow without limit
+    const long long maxInFlight = static_cast<long long>(2 * depth + nWorkers);
+    // every store in flight fits, so recycling never drops one
+    BoundedQueue<std::unique_ptr<EventStore>> free_q(in_q.capacity() + out_q.capacity() + nWorkers + 2, &abort);
+    std::size_t event_stores = 0;
+
+    std::thread reader([&] {
+      try {
+        long long seq = 0;
+        while (!abort.load(std::memory_order_relaxed)) {
+          Slot s;
+          if (!free_q.try_pop(s.evt)) {
+            s.evt = std::make_unique<EventStore>();
+            ++event_stores;
+          }
+          if (!next_event(*s.evt)) break;
+          s.seq = seq++;
+          for (unsigned spin = 0; m_opt.ordered && s.seq - sunk.load(std::memory_order_acquire) >= maxInFlight; ++spin) {
+            if (abort.load(std::memory_order_relaxed)) break;
+            std::this_thread::sleep_for(std::chrono::microseconds(spin < 16 ? 1 : 50));
+          }
+          if (!in_q.push(std::move(s))) break;
+        }
+      } catch (...) {
+        fail("reader");
+      }
+      in_q.close();
+    });
+
+    std::vector<std::thread> workers;
+    workers.reserve(nWorkers);
+    for (std::size_t iw = 0; iw < nWorkers; ++iw) {
+      workers.emplace_back([&, iw] {
+        auto& graph = m_stages.graphs[iw];
+        try {
+          Slot s;
+          while (in_q.pop(s)) {
+            graph.execute(*s.evt);
+            if (!out_q.push(std::move(s))) break;
+          }
+        } catch (...) {
+          fail("worker");
+        }
+        if (running_workers.fetch_sub(1) == 1) out_q.close();
+      });
+    }
+
+    std::thread writer([&] {
+      auto sink_one = [&](std::unique_ptr<EventStore>& evt) {
+        for (auto& alg : m_stages.sink) alg->execute(*evt);
+        evt->clear();
+        sunk.fetch_add(1, std::memory_order_release);
+        free_q.try_push(evt);
+        evt.reset();
+      };
+      try {
+        // reorder buffer: the reader throttle keeps every pending seq within [sunk, sunk + maxInFlight)
+        std::vector<std::unique_ptr<EventStore>> pending(m_opt.ordered ? maxInFlight : 0);
+        std::size_t npending = 0;
+        Slot s;
+        while (out_q.pop(s)) {
+          if (!m_opt.ordered) {
+            sink_one(s.evt);
+            continue;
+          }
+          pending[s.seq % maxInFlight] = std::move(s.evt);
+          max_reorder = std::max(max_reorder, ++npending);
+          for (;;) {
+            auto& next = pending[sunk.load(std::memory_order_relaxed) % maxInFlight];
+            if (!next) break;
+            sink_one(next);
+            --npending;
+          }
+        }
+        if (npending > 0 && !abort.load()) {
+          LOG_ERROR("EventLoop: {} events left in the reorder buffer", npending);
+          throw std::runtime_error("EventLoop: events left in the reorder buffer");
+        }
+      } catch (...) {
+        fail("writer");
+      }
+    });
+
+    reader.join();
+    for (auto& t : workers) t.join();
+    writer.join();
+
+    m_stats.input = in_q.stats();
+    m_stats.output = out_q.stats();
+    m_stats.max_reorder = max_reorder;
+    m_stats.event_stores = event_stores;
+    log_stats();
+
+    if (error) std::rethrow_exception(error);
+    return sunk.load();
+  }
+
+  void log_stats() const {
+    const auto& i = m_stats.input;
+    const auto& o = m_stats.output;
+    LOG_INFO("EventLoop: input  queue cap={} events={} mean depth={:.1f} max={} reader throttled={} workers starved={}",
+             i.capacity, i.pushed, i.mean_depth(), i.max_depth, i.full_waits, i.empty_waits);
+    LOG_INFO("EventLoop: output queue cap={} events={} mean depth={:.1f} max={} workers throttled={} writer starved={}",
+             o.capacity, o.pushed, o.mean_depth(), o.max_depth, o.full_waits, o.empty_waits);
+    if (m_opt.ordered) LOG_INFO("EventLoop: max reorder buffer = {}", m_stats.max_reorder);
+    LOG_INFO("EventLoop: {} event stores recycled over {} events", m_stats.event_stores, i.pushed);
+  }
+
+  PipelineStages& m_stages;
+  EventLoopOptions m_opt;
+  QueueStats m_stats;
+};
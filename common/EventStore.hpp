@@ -2,146 +2,343 @@
 #pragma once
 #include <any>
 #include <cstddef>
+#include <deque>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <typeindex>
-#include <unordered_map>
 #include <utility>
 #include <memory>
+#include <mutex>
 #include <vector>
+#include "common/EventArena.hpp"
+#include "common/EventKeys.hpp"
 #include "common/Logger.hpp"
 // A tiny, type-safe-ish event store: per-event key-value container.
 // - EventStore definition never changes when you add new RecoAlg outputs.
 // - Stores objects by value (inside std::any). Use move to avoid copies.
 // - Type mismatch / missing key throws with helpful error.
+// - Read-only consumers use read<T>() / view<T>(): a const reference / span into the stored object, no copy.
+// - Keys are interned to EventKey handles (EventKeyRegistry) and the store is a flat slot vector:
+//   resolve handles at configure time for the hot path; string keys still work (one registry lookup per call).
+// - The slot table is sized for every key registered when the store is created or cleared, i.e. after
+//   the algorithms resolved their keys in parse_cfg. Lookups (get/read/view/has/try_get) then are a plain
+//   index without locking. The mutex only guards the list of filled slots and the creation of slots for
+//   keys first registered during an event; AlgScheduler interns all declared keys up front and runs algs
+//   declaring no keys alone, so that never happens while other algs of the event run.
+//   References returned by get() stay valid until erase()/clear().
+// - clear() keeps the payload objects: make<T>() hands them back reset, with their buffers, on the next
+//   event (see recycle_payload), and arena() provides per-event scratch memory. A store reused across
+//   events (EventLoop) reaches a steady state without malloc/free.
+
+// Read-only view of a contiguous sequence stored in the EventStore (std::span-like, C++17).
+template <class T>
+class ConstSpan {
+public:
+  ConstSpan() = default;
+  ConstSpan(const T* data, std::size_t size) : m_data(data), m_size(size) {}
+
+  const T* begin() const { return m_data; }
+  const T* end() const { return m_data + m_size; }
+  const T* data() const { return m_data; }
+  std::size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+  const T& operator[](std::size_t i) const { return m_data[i]; }
+
+private:
+  const T* m_data = nullptr;
+  std::size_t m_size = 0;
+};
+
+// Reset a recycled payload for the next event: types with clear() keep their buffers, others are reassigned.
+template <class T>
+auto recycle_payload(T& obj, int) -> decltype(obj.clear(), void()) { obj.clear(); }
+template <class T>
+void recycle_payload(T& obj, long) { obj = T{}; }
 
 class EventStore {
 public:
-  // Put (copy)
+  EventStore() { reserve_slots(); }
+  EventStore(EventStore&& o) noexcept
+    : m_slots(std::move(o.m_slots)), m_filled(std::move(o.m_filled)), m_arena(std::move(o.m_arena)) {}
+  EventStore& operator=(EventStore&& o) noexcept {
+    if (this != &o) {
+      m_slots = std::move(o.m_slots);
+      m_filled = std::move(o.m_filled);
+      m_arena = std::move(o.m_arena);
+    }
+    return *this;
+  }
+
+  // Object stored under `key`, to be filled in place. The object left in the slot by a previous event is
+  // reused (reset by recycle_payload, capacity kept); a new T is constructed on first use or type change.
+  // Overwrites an entry already present in this event, like set().
   template <class T>
-  void put(std::string key, const T& value) {
-    Item item;
-    item.type = std::type_index(typeid(T));
-    item.payload = value;  // copy
-    m_map.emplace(std::move(key), std::move(item));
+  T& make(EventKey key) {
+    Slot& s = slot(key);
+    T* obj = s.type == std::type_index(typeid(T)) ? std::any_cast<T>(&s.payload) : nullptr;
+    if (obj) {
+      recycle_payload(*obj, 0);
+    } else {
+      obj = &s.payload.emplace<T>();
+      s.type = std::type_index(typeid(T));
+    }
+    mark_filled(key, s);
+    return *obj;
+  }
+
+  // Put (copy). Like the original map emplace, an existing entry is kept.
+  template <class T>
+  void put(EventKey key, const T& value) {
+    Slot& s = slot(key);
+    if (s.filled) return;
+    fill(key, s, std::type_index(typeid(T)), value);  // copy
   }
 
   // Put (move)
   template <class T>
-  void put(std::string key, T&& value) {
-    Item item;
-    item.type = std::type_index(typeid(T));
-    item.payload = std::forward<T>(value);  // move if possible
-    m_map.emplace(std::move(key), std::move(item));
+  void put(EventKey key, T&& value) {
+    Slot& s = slot(key);
+    if (s.filled) return;
+    fill(key, s, std::type_index(typeid(T)), std::forward<T>(value));  // move if possible
   }
 
   // Overwrite existing (copy/move)
   template <class T>
-  void set(std::string key, T&& value) {
-    Item item;
-    item.type = std::type_index(typeid(T));
-    item.payload = std::forward<T>(value);
-    m_map[std::move(key)] = std::move(item);
+  void set(EventKey key, T&& value) {
+    fill(key, slot(key), std::type_index(typeid(T)), std::forward<T>(value));
+  }
+
+  bool has(EventKey key) const {
+    return find(key) != nullptr;
   }
 
-  bool has(std::string_view key) const {
-    return m_map.find(std::string(key)) != m_map.end();
+  void erase(EventKey key) {
+    Slot* s = find(key);
+    if (!s) return;
+    s->payload.reset();
+    s->filled = false;
+    std::lock_guard<std::mutex> lk(m_mtx);
+    for (auto it = m_filled.begin(); it != m_filled.end(); ++it) {
+      if (*it == key) {
+        m_filled.erase(it);
+        break;
+      }
+    }
   }
 
-  void erase(std::string_view key) {
-    m_map.erase(std::string(key));
+  // Number of stored entries.
+  std::size_t size() const {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    return m_filled.size();
   }
-  // Return list of keys (copy). Cheap enough; typical keys count is small.
+
+  // Handles of the stored entries, in insertion order.
+  std::vector<EventKey> handles() const {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    return m_filled;
+  }
+
+  // Return list of keys (copy), in insertion order. Cheap enough; typical keys count is small.
   std::vector<std::string> keys() const {
+    std::lock_guard<std::mutex> lk(m_mtx);
     std::vector<std::string> ks;
-    ks.reserve(m_map.size());
-    for (const auto& kv : m_map){
-      ks.push_back(kv.first);
-      LOG_DEBUG("EventStore key: '{}'", kv.first);
+    ks.reserve(m_filled.size());
+    for (const auto key : m_filled) {
+      ks.push_back(key_name(key));
+      LOG_DEBUG("EventStore key: '{}'", ks.back());
     }
     return ks;
   }
 
   // Access stored payload as std::any (const)
-  const std::any& any(std::string_view key) const {
-    auto it = m_map.find(std::string(key));
-    if (it == m_map.end()) {
-      LOG_ERROR("EventStore::any: missing key '{}'", key);
-      throw std::runtime_error("EventStore::any: missing key '" + std::string(key) + "'");
-    }
-    return it->second.payload;
+  const std::any& any(EventKey key) const {
+    return checked(key, "any").payload;
+  }
+
+  // Payload of `key`, nullptr if missing.
+  const std::any* find_any(EventKey key) const {
+    const Slot* s = find(key);
+    return s ? &s->payload : nullptr;
   }
 
   // Optional: non-const any() (rarely needed, but symmetrical)
-  std::any& any(std::string_view key) {
-    auto it = m_map.find(std::string(key));
-    if (it == m_map.end()) {
-      LOG_ERROR("EventStore::any: missing key '{}'", key);
-      throw std::runtime_error("EventStore::any: missing key '" + std::string(key) + "'");
-    }
-    return it->second.payload;
+  std::any& any(EventKey key) {
+    return checked(key, "any").payload;
+  }
+
+  // Empties the store for the next event. Payload objects stay in their slots for make<T>() to recycle
+  // and the arena is rewound.
+  void clear() {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    for (const auto key : m_filled) m_slots[key.id].filled = false;
+    m_filled.clear();
+    if (m_arena) m_arena->reset();
+    grow_slots(EventKeyRegistry::instance().size());
+  }
+
+  // Creates the slots of every key registered so far (constructor and clear() do it). Not thread-safe:
+  // call it between events.
+  void reserve_slots() { grow_slots(EventKeyRegistry::instance().size()); }
+
+  // Scratch memory for the current event, released by clear(); created on first use.
+  EventArena& arena() {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    if (!m_arena) m_arena = std::make_unique<EventArena>();
+    return *m_arena;
   }
-  void clear() { m_map.clear(); }
 
   // Get mutable reference
   template <class T>
-  T& get(std::string_view key) {
-    auto it = m_map.find(std::string(key));
-    if (it == m_map.end()) {
-      LOG_ERROR("EventStore::get: missing key '{}'", key);
-      throw std::runtime_error("EventStore::get: missing key '" + std::string(key) + "'");
-    }
-    if (it->second.type != std::type_index(typeid(T))) {
-      LOG_ERROR(
-        "EventStore::get: type mismatch for key '{}' (stored={}, requested={})",
-        key, it->second.type.name(), typeid(T).name()
-      );
-      throw std::runtime_error(
-        "EventStore::get: type mismatch for key '" + std::string(key) +
-        "' (stored=" + std::string(it->second.type.name()) +
-        ", requested=" + std::string(typeid(T).name()) + ")"
-      );
-    }
-    return std::any_cast<T&>(it->second.payload);
+  T& get(EventKey key) {
+    Slot& s = checked(key, "get");
+    check_type<T>(key, s);
+    return *std::any_cast<T>(&s.payload);
   }
 
   // Get const reference
   template <class T>
-  const T& get(std::string_view key) const {
-    auto it = m_map.find(std::string(key));
-    if (it == m_map.end()) {
-      LOG_ERROR("EventStore::get: missing key '{}'", key);
-      throw std::runtime_error("EventStore::get: missing key '" + std::string(key) + "'");
+  const T& get(EventKey key) const {
+    const Slot& s = checked(key, "get");
+    check_type<T>(key, s);
+    return *std::any_cast<T>(&s.payload);
+  }
+
+  // Read-only access without copy; same checks as get(). The reference stays valid until erase()/clear().
+  template <class T>
+  const T& read(EventKey key) const {
+    return get<T>(key);
+  }
+
+  // Read-only view over a stored std::vector<T>.
+  template <class T>
+  ConstSpan<T> view(EventKey key) const {
+    const auto& v = read<std::vector<T>>(key);
+    return ConstSpan<T>(v.data(), v.size());
+  }
+
+  // Optional get (returns nullptr if missing or type mismatch)
+  template <class T>
+  T* try_get(EventKey key) {
+    Slot* s = find(key);
+    if (!s || s->type != std::type_index(typeid(T))) return nullptr;
+    return std::any_cast<T>(&s->payload);
+  }
+
+  // ---- string keys (compatibility layer): resolved through EventKeyRegistry on every call ----
+  template <class T>
+  void put(std::string_view key, const T& value) { put<T>(intern(key), value); }
+  template <class T>
+  void put(std::string_view key, T&& value) { put(intern(key), std::forward<T>(value)); }
+  template <class T>
+  void set(std::string_view key, T&& value) { set(intern(key), std::forward<T>(value)); }
+  template <class T>
+  T& make(std::string_view key) { return make<T>(intern(key)); }
+
+  bool has(std::string_view key) const { return has(lookup(key)); }
+  void erase(std::string_view key) { erase(lookup(key)); }
+  const std::any& any(std::string_view key) const { return any(lookup_or_throw(key, "any")); }
+  std::any& any(std::string_view key) { return any(lookup_or_throw(key, "any")); }
+
+  template <class T>
+  T& get(std::string_view key) { return get<T>(lookup_or_throw(key, "get")); }
+  template <class T>
+  const T& get(std::string_view key) const { return get<T>(lookup_or_throw(key, "get")); }
+  template <class T>
+  const T& read(std::string_view key) const { return read<T>(lookup_or_throw(key, "get")); }
+  template <class T>
+  ConstSpan<T> view(std::string_view key) const { return view<T>(lookup_or_throw(key, "get")); }
+  template <class T>
+  T* try_get(std::string_view key) { return try_get<T>(lookup(key)); }
+
+private:
+  struct Slot {
+    std::type_index type{typeid(void)};
+    std::any payload;
+    bool filled = false;
+  };
+
+  static EventKey intern(std::string_view key) { return EventKeyRegistry::instance().intern(key); }
+  static EventKey lookup(std::string_view key) { return EventKeyRegistry::instance().find(key); }
+  static const std::string& key_name(EventKey key) { return EventKeyRegistry::instance().name(key); }
+
+  static EventKey lookup_or_throw(std::string_view key, const char* what) {
+    const EventKey k = lookup(key);
+    if (!k.valid()) {
+      LOG_ERROR("EventStore::{}: missing key '{}'", what, key);
+      throw std::runtime_error(std::string("EventStore::") + what + ": missing key '" + std::string(key) + "'");
     }
-    if (it->second.type != std::type_index(typeid(T))) {
+    return k;
+  }
+
+  // Slot of `key`. Keys registered after the store was sized get their slot here, under the mutex;
+  // a deque never moves its elements when it grows, so references handed out for other keys stay valid.
+  Slot& slot(EventKey key) {
+    if (!key.valid()) {
+      LOG_ERROR("EventStore: invalid key handle");
+      throw std::runtime_error("EventStore: invalid key handle");
+    }
+    if (key.id < m_slots.size()) return m_slots[key.id];
+    std::lock_guard<std::mutex> lk(m_mtx);
+    grow_slots(std::size_t(key.id) + 1);
+    return m_slots[key.id];
+  }
+
+  void grow_slots(std::size_t n) {
+    if (n > m_slots.size()) m_slots.resize(n);
+  }
+
+  Slot* find(EventKey key) {
+    return key.id < m_slots.size() && m_slots[key.id].filled ? &m_slots[key.id] : nullptr;
+  }
+  const Slot* find(EventKey key) const {
+    return key.id < m_slots.size() && m_slots[key.id].filled ? &m_slots[key.id] : nullptr;
+  }
+
+  Slot& checked(EventKey key, const char* what) {
+    return const_cast<Slot&>(static_cast<const EventStore*>(this)->checked(key, what));
+  }
+  const Slot& checked(EventKey key, const char* what) const {
+    const Slot* s = find(key);
+    if (!s) {
+      const std::string name = key.valid() ? key_name(key) : std::string("<invalid>");
+      LOG_ERROR("EventStore::{}: missing key '{}'", what, name);
+      throw std::runtime_error(std::string("EventStore::") + what + ": missing key '" + name + "'");
+    }
+    return *s;
+  }
+
+  template <class T>
+  static void check_type(EventKey key, const Slot& s) {
+    if (s.type != std::type_index(typeid(T))) {
       LOG_ERROR(
         "EventStore::get: type mismatch for key '{}' (stored={}, requested={})",
-        key, it->second.type.name(), typeid(T).name()
+        key_name(key), s.type.name(), typeid(T).name()
       );
       throw std::runtime_error(
-        "EventStore::get: type mismatch for key '" + std::string(key) +
-        "' (stored=" + std::string(it->second.type.name()) +
+        "EventStore::get: type mismatch for key '" + key_name(key) +
+        "' (stored=" + std::string(s.type.name()) +
         ", requested=" + std::string(typeid(T).name()) + ")"
       );
     }
-    return std::any_cast<const T&>(it->second.payload);
   }
 
-  // Optional get (returns nullptr if missing or type mismatch)
-  template <class T>
-  T* try_get(std::string_view key) {
-    auto it = m_map.find(std::string(key));
-    if (it == m_map.end()) return nullptr;
-    if (it->second.type != std::type_index(typeid(T))) return nullptr;
-    return &std::any_cast<T&>(it->second.payload);
+  template <class V>
+  void fill(EventKey key, Slot& s, std::type_index type, V&& value) {
+    s.type = type;
+    s.payload = std::forward<V>(value);
+    mark_filled(key, s);
   }
 
-private:
-  struct Item {
-    std::type_index type{typeid(void)};
-    std::any payload;
-  };
+  void mark_filled(EventKey key, Slot& s) {
+    if (s.filled) return;
+    s.filled = true;
+    std::lock_guard<std::mutex> lk(m_mtx);
+    m_filled.push_back(key);
+  }
 
-  std::unordered_map<std::string, Item> m_map;
+  std::deque<Slot> m_slots;        // indexed by EventKey::id
+  std::vector<EventKey> m_filled;  // occupied slots, insertion order
+  std::unique_ptr<EventArena> m_arena;
+  mutable std::mutex m_mtx;        // m_filled, growth of m_slots, m_arena creation
 };
@@ -1,6 +1,8 @@
 #pragma once
 #include "common/EventStore.hpp"
 #include <yaml-cpp/yaml.h>
+#include <string>
+#include <vector>
 struct RunContext;
 
 class IAlg {
@@ -9,13 +11,27 @@ public:
     virtual ~IAlg() = default;
 
     virtual void initialize() {}   // optional
+    // optional: replaces initialize() on the per-worker copies of a cloneable alg. `first` is the instance of
+    // worker 0 (same type and config), already initialized; share its read-only job state instead of rebuilding it.
+    virtual void initialize_clone(const IAlg& first) { (void)first; initialize(); }
     virtual void execute(EventStore& evt) = 0;
     virtual void finalize() {}     // optional
+    // optional: called around every input file of a job, after ctx().config input/output/runNumber
+    // have been switched to it. initialize()/finalize() run once per job.
+    virtual void beginInput() {}
+    virtual void endInput() {}
     virtual void  parse_cfg(const YAML::Node& n) = 0;
+    // true : independent instances may process different events concurrently (one per worker)
+    // false: single instance per job, executed serially on every event (writers, accumulators)
+    virtual bool cloneable() const { return true; }
+    // EventStore keys read / written in execute(), used by AlgScheduler to run independent algs
+    // of the same event concurrently. An alg declaring neither is a barrier (runs alone, in YAML order).
+    virtual std::vector<std::string> inputs() const { return {}; }
+    virtual std::vector<std::string> outputs() const { return {}; }
+    const std::string& name() const { return m_name; }
 protected:
     RunContext& ctx() { return m_ctx; }
     const RunContext& ctx() const { return m_ctx; }
-    const std::string& name() const { return m_name; }
 
 private:
     RunContext& m_ctx;
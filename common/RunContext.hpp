@@ -12,6 +12,11 @@ struct RunConfig {
   bool MC = false;                  // is MC data?
   long long nEvents = -1;            // -1 = until EOF (if Reader supports)
   std::string log_level = "info";    // spdlog level name
+  int nThreads = 1;                  // event-level worker threads (1 = serial)
+  bool orderedOutput = true;         // keep input event order at the output stage when nThreads > 1
+  bool pipeline = false;             // reader / workers / writer on separate threads even with nThreads = 1
+  int queueDepth = 0;                // events per inter-stage queue (0 = 4 x nThreads)
+  int nAlgThreads = 1;               // task threads running independent algs of one event concurrently (1 = off)
 };
 
 struct ConditionStore {
@@ -0,0 +1,64 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Fixed-size pool of threads running submitted tasks in FIFO order.
+// Shared by all AlgSchedulers of a job; tasks must not throw (the scheduler catches per task).
+class TaskPool {
+public:
+  using Task = std::function<void()>;
+
+  explicit TaskPool(std::size_t nThreads) {
+    m_threads.reserve(nThreads);
+    for (std::size_t i = 0; i < nThreads; ++i) m_threads.emplace_back([this] { work(); });
+  }
+
+  ~TaskPool() {
+    {
+      std::lock_guard<std::mutex> lk(m_mtx);
+      m_stop = true;
+    }
+    m_cv.notify_all();
+    for (auto& t : m_threads) t.join();
+  }
+
+  TaskPool(const TaskPool&) = delete;
+  TaskPool& operator=(const TaskPool&) = delete;
+
+  std::size_t size() const { return m_threads.size(); }
+
+  void submit(Task task) {
+    {
+      std::lock_guard<std::mutex> lk(m_mtx);
+      m_tasks.push_back(std::move(task));
+    }
+    m_cv.notify_one();
+  }
+
+private:
+  void work() {
+    for (;;) {
+      Task task;
+      {
+        std::unique_lock<std::mutex> lk(m_mtx);
+        m_cv.wait(lk, [this] { return m_stop || !m_tasks.empty(); });
+        if (m_tasks.empty()) return; // stopping and drained
+        task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+      }
+      task();
+    }
+  }
+
+  std::mutex m_mtx;
+  std::condition_variable m_cv;
+  std::deque<Task> m_tasks;
+  bool m_stop = false;
+  std::vector<std::thread> m_threads;
+};
@@ -22,5 +22,20 @@ inline RunConfig parse_run_config(const YAML::Node& root) {
     if (has_node(run, "poolIndex")) {
         rc.poolIndex = run["poolIndex"].as<int>();
     }
+    if (has_node(run, "nThreads")) {
+        rc.nThreads = run["nThreads"].as<int>();
+    }
+    if (has_node(run, "orderedOutput")) {
+        rc.orderedOutput = run["orderedOutput"].as<bool>();
+    }
+    if (has_node(run, "pipeline")) {
+        rc.pipeline = run["pipeline"].as<bool>();
+    }
+    if (has_node(run, "queueDepth")) {
+        rc.queueDepth = run["queueDepth"].as<int>();
+    }
+    if (has_node(run, "nAlgThreads")) {
+        rc.nAlgThreads = run["nAlgThreads"].as<int>();
+    }
     return rc;
 }
\ No newline at end of file
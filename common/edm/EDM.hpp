@@ -4,4 +4,5 @@
 #include "common/edm/RawHit.hpp"
 #include "common/edm/RawData.hpp"
 #include "common/edm/Track.hpp"
-#include "common/edm/SimpleFittedTrack.hpp"
\ No newline at end of file
+#include "common/edm/SimpleFittedTrack.hpp"
+#include "common/edm/HitCollection.hpp"
\ No newline at end of file
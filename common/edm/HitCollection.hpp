@@ -0,0 +1,142 @@
+#pragma once
+#include "common/AHCALGeometry.hpp"
+#include "common/edm/RawHit.hpp"
+#include "common/edm/RecoHit.hpp"
+#include "IO/Descriptor.hpp"
+#include "IO/IOTypeRegistry.hpp"
+#include <cstddef>
+#include <vector>
+
+// Hits of one event as contiguous columns (structure of arrays), one entry per hit in every column.
+// Geometry (layer, x/y/z) is decoded from cellID once when a hit is added, so kernels can stream over
+// single columns instead of AHCALRawHit/AHCALRecoHit objects. Columns that a producer does not know
+// (ADCs for reco-only input, energies for raw-only input) are filled with 0.
+// Persisted as one vector branch per column: <key>.v.cellID, <key>.v.Edep, ...
+struct HitCollection {
+    std::vector<int> cellID;     // layer*100000 + asic*10000 + channel
+    std::vector<int> cell_index; // AHCALGeometry::CellIndex(cellID), -1 outside the detector
+    std::vector<int> layer;
+    std::vector<int> hg_adc;
+    std::vector<int> lg_adc;
+    std::vector<double> Edep; // in MeV
+    std::vector<double> Nmip; // in MIP
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> z;
+
+    std::size_t size() const { return cellID.size(); }
+    bool empty() const { return cellID.empty(); }
+
+    // reset for the next event, keeping the buffers (EventStore::make)
+    void clear() {
+        cellID.clear();
+        cell_index.clear();
+        layer.clear();
+        hg_adc.clear();
+        lg_adc.clear();
+        Edep.clear();
+        Nmip.clear();
+        x.clear();
+        y.clear();
+        z.clear();
+    }
+
+    void reserve(std::size_t n) {
+        cellID.reserve(n);
+        cell_index.reserve(n);
+        layer.reserve(n);
+        hg_adc.reserve(n);
+        lg_adc.reserve(n);
+        Edep.reserve(n);
+        Nmip.reserve(n);
+        x.reserve(n);
+        y.reserve(n);
+        z.reserve(n);
+    }
+
+    // Resize every column (new entries are zero, cell_index -1). Producers that write columns in place
+    // (e.g. a kernel writing into Nmip.data()) resize first and fill the cell columns with set_cell().
+    void resize(std::size_t n) {
+        cellID.resize(n, 0);
+        cell_index.resize(n, -1);
+        layer.resize(n, 0);
+        hg_adc.resize(n, 0);
+        lg_adc.resize(n, 0);
+        Edep.resize(n, 0.0);
+        Nmip.resize(n, 0.0);
+        x.resize(n, 0.0);
+        y.resize(n, 0.0);
+        z.resize(n, 0.0);
+    }
+
+    // cellID and the geometry columns derived from it for hit i
+    void set_cell(std::size_t i, int cell_id) {
+        const AHCALGeometry::CellPosition pos = AHCALGeometry::CellPos(cell_id);
+        cellID[i] = cell_id;
+        cell_index[i] = AHCALGeometry::CellIndex(cell_id);
+        layer[i] = cell_id / 100000;
+        x[i] = pos.x;
+        y[i] = pos.y;
+        z[i] = pos.z;
+    }
+
+    void push_back(int cell_id, int hg, int lg, double edep, double nmip) {
+        const std::size_t i = size();
+        resize(i + 1);
+        set_cell(i, cell_id);
+        hg_adc[i] = hg;
+        lg_adc[i] = lg;
+        Edep[i] = edep;
+        Nmip[i] = nmip;
+    }
+
+    void assign(const std::vector<AHCALRawHit>& hits) {
+        clear();
+        resize(hits.size());
+        for (std::size_t i = 0; i < hits.size(); ++i) {
+            set_cell(i, hits[i].cellID);
+            hg_adc[i] = hits[i].hg_adc;
+            lg_adc[i] = hits[i].lg_adc;
+        }
+    }
+
+    void assign(const std::vector<AHCALRecoHit>& hits) {
+        clear();
+        resize(hits.size());
+        for (std::size_t i = 0; i < hits.size(); ++i) {
+            set_cell(i, hits[i].cellID);
+            Edep[i] = hits[i].Edep;
+            Nmip[i] = hits[i].Nmip;
+        }
+    }
+
+    // AHCALRecoHit view of the collection (index = position)
+    void to_hits(std::vector<AHCALRecoHit>& out) const {
+        out.resize(size());
+        for (std::size_t i = 0; i < size(); ++i) {
+            AHCALRecoHit& h = out[i];
+            h.cellID = cellID[i];
+            h.Edep = Edep[i];
+            h.Nmip = Nmip[i];
+            h.index = static_cast<int>(i);
+        }
+    }
+};
+
+// A HitCollection is one object whose members are already per-hit vectors, so it is described with
+// describe() (one vector branch per column) rather than describe_vector() of an element type.
+inline std::vector<FieldDesc> describe(const HitCollection*) {
+    return {
+        field("v.cellID", &HitCollection::cellID),
+        field("v.cell_index", &HitCollection::cell_index),
+        field("v.layer", &HitCollection::layer),
+        field("v.hg_adc", &HitCollection::hg_adc),
+        field("v.lg_adc", &HitCollection::lg_adc),
+        field("v.Edep", &HitCollection::Edep),
+        field("v.Nmip", &HitCollection::Nmip),
+        field("v.x", &HitCollection::x),
+        field("v.y", &HitCollection::y),
+        field("v.z", &HitCollection::z),
+    };
+}
+AHCAL_REGISTER_IO_STRUCT(HitCollection, "HitCollection");
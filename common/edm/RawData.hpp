@@ -12,6 +12,13 @@ struct AHCALTLURawData{
     int CycleID;
     int TriggerID;
     int Event_Time;
+
+    // reset for the next event, keeping the vector buffers (EventStore::make)
+    void clear() {
+        Timestamp = BCID_TLU = RunNo = CycleID = TriggerID = Event_Time = 0;
+        Inputs.assign(6, 0);
+        FineTimestamps.assign(6, 0);
+    }
 };
 
 inline std::vector<FieldDesc> describe(const AHCALTLURawData*){
@@ -44,4 +44,39 @@ inline std::vector<FieldDescVector> describe_vector(const AHCALRawHit*) {
     };
 }
 AHCAL_REGISTER_IO_STRUCT(AHCALRawHit, "AHCALRawHit");
-AHCAL_REGISTER_IO_STRUCT_VECTOR(AHCALRawHit, "vector<AHCALRawHit>");
\ No newline at end of file
+AHCAL_REGISTER_IO_STRUCT_VECTOR(AHCALRawHit, "vector<AHCALRawHit>");
+
+// Raw hits of one event as columns, every vector holds one entry per hit (index = position).
+// Filled directly by RootRawHitReader; algorithms that only need a few columns consume it without
+// building AHCALRawHit objects.
+struct AHCALRawHitColumns {
+    std::vector<int> cellID;
+    std::vector<int> hg_adc;
+    std::vector<int> lg_adc;
+    std::vector<int> hittag;
+    std::vector<int> bcid;
+
+    std::size_t size() const { return cellID.size(); }
+
+    // reset for the next event, keeping the buffers (EventStore::make)
+    void clear() {
+        cellID.clear();
+        hg_adc.clear();
+        lg_adc.clear();
+        hittag.clear();
+        bcid.clear();
+    }
+
+    void to_hits(std::vector<AHCALRawHit>& out) const {
+        out.resize(size());
+        for (std::size_t i = 0; i < size(); ++i) {
+            AHCALRawHit& h = out[i];
+            h.index = static_cast<int>(i);
+            h.cellID = cellID[i];
+            h.hg_adc = hg_adc[i];
+            h.lg_adc = lg_adc[i];
+            h.hittag = hittag[i];
+            h.bcid = bcid[i];
+        }
+    }
+};
@@ -18,6 +18,17 @@ struct SimpleFittedTrack {
     bool valid = false;
     std::vector<AHCALRecoHit> inTrackHits; // for FAIR internal use
     std::vector<AHCALRecoHit> outTrackHits; // for FAIR internal use
+
+    // reset for the next event, keeping the vector buffers (EventStore::make)
+    void clear() {
+        init_pos_x = init_pos_y = direction_x = direction_y = chi2_x = chi2_y = 0.0;
+        ndf = nTotalHits = 0;
+        valid = false;
+        inTrackHitsIndices.clear();
+        outTrackHitsIndices.clear();
+        inTrackHits.clear();
+        outTrackHits.clear();
+    }
 };
 
 inline std::vector<FieldDesc> describe(const SimpleFittedTrack*) {
@@ -20,6 +20,17 @@ struct Track {
     std::vector<int> outTrackHitsIndices;
     std::vector<AHCALRecoHit> inTrackHits; // for FAIR internal use
     std::vector<AHCALRecoHit> outTrackHits; // for FAIR internal use
+
+    // reset to Track{}, keeping the vector buffers (EventStore::make)
+    void clear() {
+        x = y = tx = ty = z = chi2 = 0.0;
+        ndof = consecutive_skips = nInTrackHits = nOutTrackHits = 0;
+        valid = false;
+        inTrackHitsIndices.clear();
+        outTrackHitsIndices.clear();
+        inTrackHits.clear();
+        outTrackHits.clear();
+    }
 };
 
 inline std::vector<FieldDesc> describe(const Track*) {
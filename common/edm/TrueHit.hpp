@@ -22,20 +22,21 @@ public:
     int chip() const {
         return asic();
     }
+    // positions from the precomputed cell table (AHCALGeometry::CellTable)
     double Xpos() const {
-        return AHCALGeometry::Pos_X(this->channel(),this->asic());
+        return AHCALGeometry::CellPos(cellID).x;
     }
     double Ypos() const {
-        return AHCALGeometry::Pos_Y(this->channel(),this->asic());
+        return AHCALGeometry::CellPos(cellID).y;
     }
     double Zpos() const {
-        return AHCALGeometry::Pos_Z(this->layer());
+        return AHCALGeometry::CellPos(cellID).z;
     }
     int Xindex() const {
-        return static_cast<int>(Xpos() / 40.3 + 9.0);
+        return AHCALGeometry::CellPos(cellID).xIndex;
     }
     int Yindex() const {
-        return static_cast<int>(Ypos() / 40.3 + 9.0);
+        return AHCALGeometry::CellPos(cellID).yIndex;
     }
     int index = 0; // for internal use
 };
@@ -0,0 +1,161 @@
+// Benchmark of the ADC-to-energy conversion of AdcToEnergyReadTTreeAlg per event: the per-hit branchy loop
+// over AHCALRawHit (the algorithm before the SoA kernels) vs. what execute() does now with the scalar and
+// AVX2 kernels, i.e. packing the hits into SoA scratch arrays, the kernel and filling the RecoHits.
+// Usage: bench_adc_to_energy [nEvents=20000] [hitsPerEvent=400]
+#include "adc_to_energy/AdcToEnergyKernel.hpp"
+#include "calibration/CalibTable.hpp"
+#include "calibration/RefValues.hpp"
+#include "common/AHCALGeometry.hpp"
+#include "common/Logger.hpp"
+#include "common/edm/EDM.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace AHCALRecoAlg;
+
+namespace {
+
+// reference: the historic per-hit loop (AoS in, AoS out, gain-switch branch per hit)
+void convert_aos(const AHCALCalib::CalibTable& calib, const std::vector<AHCALRawHit>& raw,
+                 std::vector<AHCALRecoHit>& out) {
+  out.clear();
+  for (const auto& raw_hit : raw) {
+    AHCALRecoHit reco_hit;
+    reco_hit.cellID = raw_hit.cellID;
+    reco_hit.index = raw_hit.index;
+    const AHCALCalib::CellCalib* c = calib.find(raw_hit.cellID);
+    if (c) {
+      const double hg = static_cast<double>(raw_hit.hg_adc);
+      const double lg = static_cast<double>(raw_hit.lg_adc);
+      if ((hg - c->hg_ped) < (static_cast<double>(c->gain_plat) - AHCALRefValues::SwitchPoint)) {
+        reco_hit.Nmip = (hg - c->hg_ped) / c->mip;
+        reco_hit.Edep = (hg - c->hg_ped) * AHCALRefValues::MIP_E / c->mip;
+      } else {
+        reco_hit.Nmip = (lg - c->lg_ped) * c->gain_ratio / c->mip;
+        reco_hit.Edep = (lg - c->lg_ped) * c->gain_ratio * AHCALRefValues::MIP_E / c->mip;
+      }
+      if (reco_hit.Edep < 0) {
+        reco_hit.Edep = 0;
+        reco_hit.Nmip = 0;
+      }
+    }
+    out.push_back(reco_hit);
+  }
+}
+
+// execute(): AoS -> SoA scratch, kernel, RecoHit fill (scratch and output keep their capacity across events)
+struct SoAScratch {
+  std::vector<int> cell_index, hg_adc, lg_adc;
+  std::vector<double> nmip, edep;
+};
+
+void convert_soa(AdcToEnergyKernelFn kernel, const AHCALCalib::CalibTable& calib, const std::vector<AHCALRawHit>& raw,
+                 SoAScratch& s, std::vector<AHCALRecoHit>& out) {
+  const std::size_t n = raw.size();
+  s.cell_index.resize(n);
+  s.hg_adc.resize(n);
+  s.lg_adc.resize(n);
+  s.nmip.resize(n);
+  s.edep.resize(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    s.cell_index[i] = AHCALGeometry::CellIndex(raw[i].cellID);
+    s.hg_adc[i] = raw[i].hg_adc;
+    s.lg_adc[i] = raw[i].lg_adc;
+  }
+  kernel(calib, AdcHitsSoA{s.cell_index.data(), s.hg_adc.data(), s.lg_adc.data(), n}, s.nmip.data(), s.edep.data());
+  out.resize(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    AHCALRecoHit& reco_hit = out[i];
+    reco_hit.cellID = raw[i].cellID;
+    reco_hit.index = raw[i].index;
+    reco_hit.Nmip = s.nmip[i];
+    reco_hit.Edep = s.edep[i];
+  }
+}
+
+template <class Fn>
+double time_hits_per_s(long long nhits, Fn&& fn) {
+  const auto t0 = std::chrono::steady_clock::now();
+  fn();
+  const auto t1 = std::chrono::steady_clock::now();
+  return nhits / std::chrono::duration<double>(t1 - t0).count();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  FAIR::init_logger("BenchAdcToEnergy");
+  const int nEvents = argc > 1 ? std::atoi(argv[1]) : 20000;
+  const int nHits = argc > 2 ? std::atoi(argv[2]) : 400;
+
+  std::mt19937 rng(12345);
+  std::normal_distribution<double> jitter(0.0, 1.0);
+  AHCALCalib::CalibTable calib;
+  for (int i = 0; i < calib.size(); ++i) {
+    calib[i].mip = AHCALRefValues::ref_MIP + 20.0 * jitter(rng);
+    calib[i].hg_ped = AHCALRefValues::ref_ped_highgain + 5.0 * jitter(rng);
+    calib[i].lg_ped = AHCALRefValues::ref_ped_lowgain + 5.0 * jitter(rng);
+    calib[i].gain_ratio = AHCALRefValues::ref_gain_ratio + jitter(rng);
+    calib[i].gain_plat = AHCALRefValues::lowgain_plat + static_cast<int>(50.0 * jitter(rng));
+  }
+
+  // hits: random cells, HG spread over the switch point so both gains (and negatives) occur
+  std::uniform_int_distribution<int> layer(0, AHCALGeometry::Layer_No - 1), chip(0, AHCALGeometry::chip_No - 1),
+      channel(0, AHCALGeometry::channel_No - 1), hg_adc(300, 4000), lg_adc(350, 1200);
+  std::vector<std::vector<AHCALRawHit>> events(nEvents);
+  for (auto& ev : events) {
+    ev.resize(nHits);
+    for (auto& h : ev) {
+      h.cellID = layer(rng) * 100000 + chip(rng) * 10000 + channel(rng);
+      h.hg_adc = hg_adc(rng);
+      h.lg_adc = lg_adc(rng);
+    }
+  }
+  const long long total = static_cast<long long>(nEvents) * nHits;
+
+  std::vector<AHCALRecoHit> aos_out;
+  std::vector<double> ref_nmip, ref_edep;
+  const double r_aos = time_hits_per_s(total, [&] {
+    for (int e = 0; e < nEvents; ++e) {
+      convert_aos(calib, events[e], aos_out);
+      if (e == 0) {
+        for (const auto& h : aos_out) { ref_nmip.push_back(h.Nmip); ref_edep.push_back(h.Edep); }
+      }
+    }
+  });
+  std::cout << "per-hit AoS loop           : " << r_aos / 1e6 << " Mhits/s\n";
+
+  SoAScratch scratch;
+  std::vector<AHCALRecoHit> soa_out;
+  auto bench_kernel = [&](const char* label, AdcToEnergyKernelFn fn) {
+    bool identical = true;
+    const double r = time_hits_per_s(total, [&] {
+      for (int e = 0; e < nEvents; ++e) {
+        convert_soa(fn, calib, events[e], scratch, soa_out);
+        if (e == 0) {
+          for (int i = 0; i < nHits; ++i) {
+            identical = identical && std::memcmp(&soa_out[i].Nmip, &ref_nmip[i], sizeof(double)) == 0 &&
+                        std::memcmp(&soa_out[i].Edep, &ref_edep[i], sizeof(double)) == 0;
+          }
+        }
+      }
+    });
+    std::cout << label << ": " << r / 1e6 << " Mhits/s (x" << r / r_aos << ", "
+              << (identical ? "bitwise identical" : "MISMATCH") << ")\n";
+    return identical;
+  };
+
+  bool ok = bench_kernel("pack + scalar kernel + fill", &adc_to_energy_scalar);
+  if (avx2_supported()) {
+    ok = bench_kernel("pack + AVX2 kernel + fill  ", &adc_to_energy_avx2) && ok;
+  } else {
+    std::cout << "AVX2 not supported by this CPU, skipped\n";
+  }
+  std::cout << nEvents << " events x " << nHits << " hits" << std::endl;
+  return ok ? 0 : 1;
+}
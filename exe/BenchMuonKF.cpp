@@ -0,0 +1,126 @@
+// Benchmark of the MuonKFAlg hit lookup on high-occupancy events: a muon track plus a hadron shower
+// (many hits per layer from the shower start on) and random noise. The one-by-one seed search with the
+// per-layer linear scan (hitGrid: false) and with the per-event tile grid (hitGrid: true) is compared
+// with the batched search (batchSeeds: true, lane-parallel scan). All variants must find the same tracks.
+// Usage: bench_muon_kf [nEvents=2000] [showerHitsPerLayer=120] [noiseHitsPerLayer=10]
+#include "reco_alg/module/MuonKFAlg/MuonKFAlg.hpp"
+#include "common/AHCALGeometry.hpp"
+#include "common/Logger.hpp"
+#include "common/edm/EDM.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory_resource>
+#include <random>
+#include <vector>
+
+using namespace AHCALRecoAlg;
+
+namespace {
+
+// cellID (without the layer part) of every tile of the 18x18 grid, -1 if no channel sits there
+std::vector<int> tile_cells() {
+  std::vector<int> tiles(18 * 18, -1);
+  for (int chip = 0; chip < AHCALGeometry::chip_No; ++chip) {
+    for (int channel = 0; channel < AHCALGeometry::channel_No; ++channel) {
+      const auto p = AHCALGeometry::CellPos(chip * 10000 + channel);
+      if (p.xIndex >= 0 && p.xIndex < 18 && p.yIndex >= 0 && p.yIndex < 18) tiles[p.yIndex * 18 + p.xIndex] = chip * 10000 + channel;
+    }
+  }
+  return tiles;
+}
+
+std::vector<std::vector<AHCALRecoHit>> make_events(int nEvents, int showerHits, int noiseHits) {
+  std::mt19937 rng(2024);
+  std::uniform_real_distribution<double> uni(0.0, 1.0);
+  std::normal_distribution<double> gaus(0.0, 1.0);
+  const std::vector<int> tiles = tile_cells();
+  auto add = [&](std::vector<AHCALRecoHit>& hits, int layer, double xi, double yi, double nmip) {
+    const int ix = static_cast<int>(std::floor(xi)), iy = static_cast<int>(std::floor(yi));
+    if (ix < 0 || ix >= 18 || iy < 0 || iy >= 18 || tiles[iy * 18 + ix] < 0) return;
+    AHCALRecoHit h;
+    h.cellID = layer * 100000 + tiles[iy * 18 + ix];
+    h.Nmip = nmip;
+    h.Edep = nmip * 0.461;
+    h.index = static_cast<int>(hits.size());
+    hits.push_back(h);
+  };
+
+  std::vector<std::vector<AHCALRecoHit>> events(nEvents);
+  for (auto& hits : events) {
+    // muon: straight line in tile units, ~90% efficient, Landau-ish MIP signal
+    const double x0 = 3.0 + 12.0 * uni(rng), y0 = 3.0 + 12.0 * uni(rng);
+    const double sx = 0.05 * gaus(rng), sy = 0.05 * gaus(rng);
+    // shower: starts somewhere in the first half, core wandering around the muon entry point
+    const int start = static_cast<int>(20.0 * uni(rng));
+    const double cx = x0 + 2.0 * gaus(rng), cy = y0 + 2.0 * gaus(rng);
+    for (int L = 0; L < AHCALGeometry::Layer_No; ++L) {
+      if (uni(rng) < 0.9) add(hits, L, x0 + sx * L, y0 + sy * L, 1.0 + 0.3 * std::abs(gaus(rng)));
+      if (L >= start) {
+        const double width = 1.0 + 0.15 * (L - start); // tiles
+        const int n = static_cast<int>(showerHits * (0.5 + uni(rng)));
+        for (int k = 0; k < n; ++k) add(hits, L, cx + width * gaus(rng), cy + width * gaus(rng), 5.0 * uni(rng));
+      }
+      for (int k = 0; k < noiseHits; ++k) add(hits, L, 18.0 * uni(rng), 18.0 * uni(rng), 0.5 + 1.5 * uni(rng));
+    }
+  }
+  return events;
+}
+
+// bitwise: MuonKFAlg is built with -ffp-contract=off, so the scalar and the SIMD kernels round alike
+bool same_track(const Track& a, const Track& b) {
+  return a.valid == b.valid && a.inTrackHitsIndices == b.inTrackHitsIndices && a.ndof == b.ndof && a.x == b.x &&
+         a.y == b.y && a.tx == b.tx && a.ty == b.ty && a.z == b.z && a.chi2 == b.chi2;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  FAIR::init_logger("BenchMuonKF");
+  const int nEvents = argc > 1 ? std::atoi(argv[1]) : 2000;
+  const int showerHits = argc > 2 ? std::atoi(argv[2]) : 120;
+  const int noiseHits = argc > 3 ? std::atoi(argv[3]) : 10;
+
+  const auto events = make_events(nEvents, showerHits, noiseHits);
+  long long nhits = 0;
+  for (const auto& ev : events) nhits += static_cast<long long>(ev.size());
+
+  MuonKFAlgCfg cfg;
+  cfg.skipLayer.set(0);
+  cfg.skipLayer.set(2);
+  cfg.skipLayer.set(14);
+
+  std::vector<Track> ref(events.size());
+  double t_ref = 0.0;
+  auto run = [&](const char* label, bool batchSeeds, bool hitGrid) {
+    cfg.batchSeeds = batchSeeds;
+    cfg.hitGrid = hitGrid;
+    std::vector<Track> out(events.size());
+    int found = 0;
+    const auto t0 = std::chrono::steady_clock::now();
+    for (std::size_t e = 0; e < events.size(); ++e) {
+      std::pmr::monotonic_buffer_resource arena;
+      if (!find_muon_track_kf(events[e], out[e], cfg, &arena)) out[e] = Track{};
+      found += out[e].valid ? 1 : 0;
+    }
+    const double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    bool identical = true;
+    if (t_ref == 0.0) {
+      t_ref = t;
+      ref = out;
+    } else {
+      for (std::size_t e = 0; e < events.size() && identical; ++e) identical = same_track(out[e], ref[e]);
+    }
+    std::cout << label << ": " << 1e6 * t / nEvents << " us/event (x" << t_ref / t << ", " << found << " tracks, "
+              << (identical ? "identical" : "MISMATCH") << ")\n";
+    return identical;
+  };
+
+  bool ok = run("scan, one by one ", false, false);
+  ok = run("grid, one by one ", false, true) && ok;
+  ok = run("batched          ", true, false) && ok;
+  std::cout << nEvents << " events, " << static_cast<double>(nhits) / nEvents << " hits/event" << std::endl;
+  return ok ? 0 : 1;
+}
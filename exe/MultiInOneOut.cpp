@@ -7,11 +7,13 @@
 #include "common/IAlg.hpp"
 #include "common/RunContext.hpp"
 #include "common/AlgFactory.hpp"
+#include "common/EventLoop.hpp"
 #include "common/config/ParseRunConfig.hpp"
 #include "IO/reader/RootRawHitReader.hpp"
 #include "IO/reader/BinaryRawHitReader.hpp"
 #include "IO/writer/RootWriterAlg.hpp"
 #include "IO/writer/WriterRegistry.hpp"
+#include <TROOT.h>
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -84,17 +86,36 @@ int main(int argc, char* argv[]) {
     }
     LOG_INFO("AHCAL Application started.");
     LOG_INFO("RunConfig parsed successfully.");
-    auto algs = build_pipeline(ctx, config);
-    for (auto& alg : algs) {
-        alg->initialize();
+    EventLoopOptions loop_options;
+    loop_options.ordered = ctx.config.orderedOutput;
+    loop_options.pipelined = ctx.config.pipeline;
+    loop_options.queueDepth = static_cast<std::size_t>(std::max(0, ctx.config.queueDepth));
+    if (ctx.config.nThreads > 1 || ctx.config.pipeline) {
+        ROOT::EnableThreadSafety();
+        LOG_INFO("Pipelined event processing: reader -> {} workers -> writer (orderedOutput = {})", ctx.config.nThreads, ctx.config.orderedOutput);
     }
+    if (ctx.config.nAlgThreads > 1) {
+        ROOT::EnableThreadSafety();
+        LOG_INFO("Intra-event algorithm scheduling on {} task threads", ctx.config.nAlgThreads);
+    }
+    auto stages = build_pipeline_stages(ctx, config, ctx.config.nThreads, ctx.config.nAlgThreads);
+    stages.initialize();
+    EventLoop loop(stages, loop_options);
     YAML::Node reader_config = require_node(config, "reader");
     const std::string type = require_string(reader_config, "type");
     const YAML::Node cfg = reader_config["cfg"] ? reader_config["cfg"] : YAML::Node(YAML::NodeType::Map);
     if (type == "RootRawHitReader") {
         // Initialize RootRawHitReader
-        std::string input_key_hits = require_string(cfg, "out_rawhits_key");
-        std::string input_key_tlu = require_string(cfg, "out_tlu_key");
+        // AoS hits and/or hit columns (bulk mode hands the columns over without building AHCALRawHit objects)
+        const std::string hits_key = get_or<std::string>(cfg, "out_rawhits_key", "");
+        const std::string columns_key = get_or<std::string>(cfg, "out_rawhit_columns_key", "");
+        if (hits_key.empty() && columns_key.empty()) {
+            LOG_ERROR("RootRawHitReader: set out_rawhits_key and/or out_rawhit_columns_key");
+            return 1;
+        }
+        const EventKey input_key_hits = hits_key.empty() ? EventKey{} : EventKeyRegistry::instance().intern(hits_key);
+        const EventKey input_key_columns = columns_key.empty() ? EventKey{} : EventKeyRegistry::instance().intern(columns_key);
+        const EventKey input_key_tlu = EventKeyRegistry::instance().intern(require_string(cfg, "out_tlu_key"));
         for (int iinput = 0; iinput < ninputs; ++iinput) {
             ctx.config.input = input_files[iinput];
             ctx.config.runNumber = runNumbers[iinput];
@@ -102,40 +123,42 @@ int main(int argc, char* argv[]) {
             ctx.config.output = outputfile;
             LOG_INFO("Processing input file: {} (RunNumber: {}, PoolIndex: {})", ctx.config.input, ctx.config.runNumber, ctx.config.poolIndex);
             LOG_INFO("Inputs = {} / {}", iinput + 1, ninputs);
-            RootRawHitReader rawHitReader(ctx.config.input, "Raw_Hit");
+            stages.for_each_alg([](IAlg& alg) { alg.beginInput(); });
+            RootRawHitReader rawHitReader(ctx.config.input, "Raw_Hit", get_or<bool>(cfg, "bulk", false));
             LOG_INFO("RootRawHitReader created successfully.");
             int nEvent = 0;
             Long64_t total_entries = rawHitReader.entries();
             LOG_INFO("Total entries in input file {}: {}", ctx.config.input, total_entries);
-            while (true) {
-                std::vector<AHCALRawHit> rawHits;
-                AHCALTLURawData tluData;
-                if (!rawHitReader.next(rawHits, tluData)) {
-                    break; // No more events
+            loop.run([&](EventStore& eventStore) {
+                // read straight into the store's recycled objects (capacity kept across events)
+                auto& tluData = eventStore.make<AHCALTLURawData>(input_key_tlu);
+                bool ok = false;
+                if (input_key_columns.valid()) {
+                    auto& columns = eventStore.make<AHCALRawHitColumns>(input_key_columns);
+                    ok = rawHitReader.next(columns, tluData);
+                    if (ok && input_key_hits.valid()) columns.to_hits(eventStore.make<std::vector<AHCALRawHit>>(input_key_hits));
+                } else {
+                    ok = rawHitReader.next(eventStore.make<std::vector<AHCALRawHit>>(input_key_hits), tluData);
                 }
-                if (ctx.config.nEvents > 0 && nEvent >= ctx.config.nEvents) {
-                    break; // Reached the maximum number of events to process
+                if (!ok) {
+                    return false; // No more events
                 }
-                EventStore eventStore;
-                eventStore.put(input_key_hits, std::move(rawHits));
-                eventStore.put(input_key_tlu, std::move(tluData));
-                for (auto& alg : algs) {
-                    alg->execute(eventStore);
+                if (ctx.config.nEvents > 0 && nEvent >= ctx.config.nEvents) {
+                    return false; // Reached the maximum number of events to process
                 }
                 nEvent++;
                 if (nEvent % 10000 == 0) {
                     LOG_INFO("Processed {}/{} events.", nEvent, total_entries);
                 }
-                eventStore.clear();
-            }
+                return true;
+            });
+            stages.for_each_alg([](IAlg& alg) { alg.endInput(); });
         }
     } else if (type == "BinaryRawHitReader") {
         // Initialize BinaryRawHitReader
         int nEvent = 0;
-        std::string input_key_hits = require_string(cfg, "out_rawhits_key");
-        std::string input_key_tlu = require_string(cfg, "out_tlu_key");
-        // Long64_t total_entries = rawHitReader.entries();
-        // LOG_INFO("Total entries in input file: {}", total_entries);
+        const EventKey input_key_hits = EventKeyRegistry::instance().intern(require_string(cfg, "out_rawhits_key"));
+        const EventKey input_key_tlu = EventKeyRegistry::instance().intern(require_string(cfg, "out_tlu_key"));
         for (int iinput = 0; iinput < ninputs; ++iinput) {
             ctx.config.input = input_files[iinput];
             ctx.config.runNumber = runNumbers[iinput];
@@ -143,32 +166,46 @@ int main(int argc, char* argv[]) {
             ctx.config.output = outputfile;
             LOG_INFO("Processing input file: {} (RunNumber: {}, PoolIndex: {})", ctx.config.input, ctx.config.runNumber, ctx.config.poolIndex);
             LOG_INFO("Inputs = {} / {}", iinput + 1, ninputs);
-            BinaryRawHitReader rawHitReader(ctx.config.input);
+            stages.for_each_alg([](IAlg& alg) { alg.beginInput(); });
+            BinaryRawHitReader rawHitReader(ctx.config.input, get_or<bool>(cfg, "mmap", false));
             LOG_INFO("BinaryRawHitReader created successfully.");
+            // decodeThreads: decode chunks of chunkEvents events in parallel (uses the index, delivered in order)
+            const int decode_threads = get_or<int>(cfg, "decodeThreads", 0);
+            // index: pre-scan the event offsets (entries(), ranges); index_file: per-input sidecar reused by later jobs
+            // (suffix such as ".idx" or a directory, see BinaryRawHitReader::sidecar_path; default "" = memory only)
+            const YAML::Node range = cfg["range"];
+            if (get_or<bool>(cfg, "index", false) || range || decode_threads > 0) {
+                rawHitReader.build_index(BinaryRawHitReader::sidecar_path(get_or<std::string>(cfg, "index_file", ""), ctx.config.input));
+                LOG_INFO("Total entries in input file: {}", rawHitReader.entries());
+                if (range) {
+                    const auto r = range.as<std::vector<long long>>();
+                    if (r.size() != 2) throw std::runtime_error("BinaryRawHitReader.cfg.range must be [begin, end]");
+                    rawHitReader.set_range(r[0], r[1]);
+                }
+            }
+            if (decode_threads > 0) {
+                rawHitReader.enable_parallel(static_cast<std::size_t>(decode_threads), static_cast<std::size_t>(get_or<int>(cfg, "chunkEvents", 256)));
+            }
 
-            while (true) {
-                std::vector<AHCALRawHit> rawHits;
-                AHCALTLURawData tluData;
+            loop.run([&](EventStore& eventStore) {
+                // read straight into the store's recycled objects (capacity kept across events)
+                auto& rawHits = eventStore.make<std::vector<AHCALRawHit>>(input_key_hits);
+                auto& tluData = eventStore.make<AHCALTLURawData>(input_key_tlu);
                 if (!rawHitReader.next(rawHits, tluData)) {
-                    break; // No more events or error
+                    return false; // No more events or error
                 }
                 if (ctx.config.nEvents > 0 && nEvent >= ctx.config.nEvents) {
-                    break; // Reached the maximum number of events to process
-                }
-                EventStore eventStore;
-                eventStore.put(input_key_hits, std::move(rawHits));
-                eventStore.put(input_key_tlu, std::move(tluData));
-                for (auto& alg : algs) {
-                    alg->execute(eventStore);
+                    return false; // Reached the maximum number of events to process
                 }
                 nEvent++;
                 if (nEvent % 10000 == 0) {
                     LOG_INFO("Processed {}", nEvent);
                 }
-                eventStore.clear();
-            }
+                return true;
+            });
             LOG_INFO("Finished processing input file: {} (RunNumber: {}, PoolIndex: {})", ctx.config.input, ctx.config.runNumber, ctx.config.poolIndex);
             LOG_INFO("Total events processed so far: {}", nEvent);
+            stages.for_each_alg([](IAlg& alg) { alg.endInput(); });
         }
     }else if (type == "RootInput") {
         for (int iinput = 0; iinput < ninputs; ++iinput) {
@@ -178,42 +215,40 @@ int main(int argc, char* argv[]) {
             ctx.config.output = outputfile;
             LOG_INFO("Processing input file: {} (RunNumber: {}, PoolIndex: {})", ctx.config.input, ctx.config.runNumber, ctx.config.poolIndex);
             LOG_INFO("Inputs = {} / {}", iinput + 1, ninputs);
+            stages.for_each_alg([](IAlg& alg) { alg.beginInput(); });
             // Initialize RootInput reader
             RootInput in(ctx.config.input, "events");
             LOG_INFO("RootInput reader created successfully.");
             ReaderRegistry rr = parse_reader_registry(cfg);
+            // branch addresses are bound once; every event is read straight into the store slots
+            const ReadPlan read_plan = make_read_plan(cfg, rr, in);
             Long64_t total_entries = in.entries();
             LOG_INFO("Total entries in input file: {}", total_entries);
             int nEvent = 0;
-            while (true) {
+            loop.run([&](EventStore& eventStore) {
                 if (!in.next()) {
-                    break; // No more events
+                    return false; // No more events
                 }
                 if (ctx.config.nEvents > 0 && nEvent >= ctx.config.nEvents) {
-                    break; // Reached the maximum number of events to process
-                }
-                EventStore eventStore;
-                readandput(cfg, eventStore, rr, in);
-                for (auto& alg : algs) {
-                    alg->execute(eventStore);
+                    return false; // Reached the maximum number of events to process
                 }
+                read_plan.read(eventStore);
                 nEvent++;
                 if (nEvent % 10000 == 0) {
                     LOG_INFO("Processed {}/{} events.", nEvent, total_entries);
                 }
-                eventStore.clear();
-            }
+                return true;
+            });
+            in.log_stats();
             LOG_INFO("Finished processing input file: {} (RunNumber: {}, PoolIndex: {})", ctx.config.input, ctx.config.runNumber, ctx.config.poolIndex);
             LOG_INFO("Total events processed so far: {}", nEvent);
+            stages.for_each_alg([](IAlg& alg) { alg.endInput(); });
         }
     } else {
         LOG_ERROR("Unknown reader type specified in config.");
         return 1;
     }
-    for (auto& alg : algs) {
-        alg->finalize();
-    }
-    algs.clear();
+    stages.for_each_alg([](IAlg& alg) { alg.finalize(); });
     LOG_INFO("AHCAL Application finished.");
     std::cout << "AHCAL Application finished." << std::endl;
     return 0;
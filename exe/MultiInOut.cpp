@@ -7,11 +7,13 @@
 #include "common/IAlg.hpp"
 #include "common/RunContext.hpp"
 #include "common/AlgFactory.hpp"
+#include "common/EventLoop.hpp"
 #include "common/config/ParseRunConfig.hpp"
 #include "IO/reader/RootRawHitReader.hpp"
 #include "IO/reader/BinaryRawHitReader.hpp"
 #include "IO/writer/RootWriterAlg.hpp"
 #include "IO/writer/WriterRegistry.hpp"
+#include <TROOT.h>
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -97,6 +99,27 @@ int main(int argc, char* argv[]) {
     }
     LOG_INFO("AHCAL Application started.");
     LOG_INFO("RunConfig parsed successfully.");
+    EventLoopOptions loop_options;
+    loop_options.ordered = ctx.config.orderedOutput;
+    loop_options.pipelined = ctx.config.pipeline;
+    loop_options.queueDepth = static_cast<std::size_t>(std::max(0, ctx.config.queueDepth));
+    if (ctx.config.nThreads > 1 || ctx.config.pipeline) {
+        ROOT::EnableThreadSafety();
+        LOG_INFO("Pipelined event processing: reader -> {} workers -> writer (orderedOutput = {})", ctx.config.nThreads, ctx.config.orderedOutput);
+    }
+    if (ctx.config.nAlgThreads > 1) {
+        ROOT::EnableThreadSafety();
+        LOG_INFO("Intra-event algorithm scheduling on {} task threads", ctx.config.nAlgThreads);
+    }
+    // Algorithms and their conditions (calibration tables, ...) are set up once per job;
+    // only the output is re-targeted per input through beginInput()/endInput().
+    ctx.config.output = output_files[0];
+    auto stages = build_pipeline_stages(ctx, config, ctx.config.nThreads, ctx.config.nAlgThreads);
+    stages.initialize();
+    EventLoop loop(stages, loop_options);
+    YAML::Node reader_config = require_node(config, "reader");
+    const std::string type = require_string(reader_config, "type");
+    const YAML::Node cfg = reader_config["cfg"] ? reader_config["cfg"] : YAML::Node(YAML::NodeType::Map);
     for (int iinput = 0; iinput < ninputs; ++iinput) {
         ctx.config.input = input_files[iinput];
         ctx.config.runNumber = runNumbers[iinput];
@@ -104,109 +127,120 @@ int main(int argc, char* argv[]) {
         ctx.config.output = output_files[iinput];
         LOG_INFO("Processing input file: {} (RunNumber: {}, PoolIndex: {})", ctx.config.input, ctx.config.runNumber, ctx.config.poolIndex);
         LOG_INFO("Inputs = {} / {}", iinput + 1, ninputs);
-        auto algs = build_pipeline(ctx, config);
-        for (auto& alg : algs) {
-            alg->initialize();
-        }
-        YAML::Node reader_config = require_node(config, "reader");
-        const std::string type = require_string(reader_config, "type");
-        const YAML::Node cfg = reader_config["cfg"] ? reader_config["cfg"] : YAML::Node(YAML::NodeType::Map);
+        stages.for_each_alg([](IAlg& alg) { alg.beginInput(); });
 
         if (type == "RootRawHitReader") {
             // Initialize RootRawHitReader
-            RootRawHitReader rawHitReader(ctx.config.input, "Raw_Hit");
+            RootRawHitReader rawHitReader(ctx.config.input, "Raw_Hit", get_or<bool>(cfg, "bulk", false));
             LOG_INFO("RootRawHitReader created successfully.");
             int nEvent = 0;
-            std::string input_key_hits = require_string(cfg, "out_rawhits_key");
-            std::string input_key_tlu = require_string(cfg, "out_tlu_key");
+            // AoS hits and/or hit columns (bulk mode hands the columns over without building AHCALRawHit objects)
+            const std::string hits_key = get_or<std::string>(cfg, "out_rawhits_key", "");
+            const std::string columns_key = get_or<std::string>(cfg, "out_rawhit_columns_key", "");
+            if (hits_key.empty() && columns_key.empty()) {
+                LOG_ERROR("RootRawHitReader: set out_rawhits_key and/or out_rawhit_columns_key");
+                return 1;
+            }
+            const EventKey input_key_hits = hits_key.empty() ? EventKey{} : EventKeyRegistry::instance().intern(hits_key);
+            const EventKey input_key_columns = columns_key.empty() ? EventKey{} : EventKeyRegistry::instance().intern(columns_key);
+            const EventKey input_key_tlu = EventKeyRegistry::instance().intern(require_string(cfg, "out_tlu_key"));
             Long64_t total_entries = rawHitReader.entries();
             LOG_INFO("Total entries in input file: {}", total_entries);
-            while (true) {
-                std::vector<AHCALRawHit> rawHits;
-                AHCALTLURawData tluData;
-                if (!rawHitReader.next(rawHits, tluData)) {
-                    break; // No more events
+            loop.run([&](EventStore& eventStore) {
+                // read straight into the store's recycled objects (capacity kept across events)
+                auto& tluData = eventStore.make<AHCALTLURawData>(input_key_tlu);
+                bool ok = false;
+                if (input_key_columns.valid()) {
+                    auto& columns = eventStore.make<AHCALRawHitColumns>(input_key_columns);
+                    ok = rawHitReader.next(columns, tluData);
+                    if (ok && input_key_hits.valid()) columns.to_hits(eventStore.make<std::vector<AHCALRawHit>>(input_key_hits));
+                } else {
+                    ok = rawHitReader.next(eventStore.make<std::vector<AHCALRawHit>>(input_key_hits), tluData);
                 }
-                if (ctx.config.nEvents > 0 && nEvent >= ctx.config.nEvents) {
-                    break; // Reached the maximum number of events to process
+                if (!ok) {
+                    return false; // No more events
                 }
-                EventStore eventStore;
-                eventStore.put(input_key_hits, std::move(rawHits));
-                eventStore.put(input_key_tlu, std::move(tluData));
-                for (auto& alg : algs) {
-                    alg->execute(eventStore);
+                if (ctx.config.nEvents > 0 && nEvent >= ctx.config.nEvents) {
+                    return false; // Reached the maximum number of events to process
                 }
                 nEvent++;
                 if (nEvent % 10000 == 0) {
                     LOG_INFO("Processed {}/{} events.", nEvent, total_entries);
                 }
-                eventStore.clear();
-            }
+                return true;
+            });
         } else if (type == "BinaryRawHitReader") {
             // Initialize BinaryRawHitReader
-            BinaryRawHitReader rawHitReader(ctx.config.input);
+            BinaryRawHitReader rawHitReader(ctx.config.input, get_or<bool>(cfg, "mmap", false));
             LOG_INFO("BinaryRawHitReader created successfully.");
             int nEvent = 0;
-            std::string input_key_hits = require_string(cfg, "out_rawhits_key");
-            std::string input_key_tlu = require_string(cfg, "out_tlu_key");
-            // Long64_t total_entries = rawHitReader.entries();
-            // LOG_INFO("Total entries in input file: {}", total_entries);
-            while (true) {
-                std::vector<AHCALRawHit> rawHits;
-                AHCALTLURawData tluData;
+            const EventKey input_key_hits = EventKeyRegistry::instance().intern(require_string(cfg, "out_rawhits_key"));
+            const EventKey input_key_tlu = EventKeyRegistry::instance().intern(require_string(cfg, "out_tlu_key"));
+            // decodeThreads: decode chunks of chunkEvents events in parallel (uses the index, delivered in order)
+            const int decode_threads = get_or<int>(cfg, "decodeThreads", 0);
+            // index: pre-scan the event offsets (entries(), ranges); index_file: per-input sidecar reused by later jobs
+            // (suffix such as ".idx" or a directory, see BinaryRawHitReader::sidecar_path; default "" = memory only)
+            const YAML::Node range = cfg["range"];
+            if (get_or<bool>(cfg, "index", false) || range || decode_threads > 0) {
+                rawHitReader.build_index(BinaryRawHitReader::sidecar_path(get_or<std::string>(cfg, "index_file", ""), ctx.config.input));
+                LOG_INFO("Total entries in input file: {}", rawHitReader.entries());
+                if (range) {
+                    const auto r = range.as<std::vector<long long>>();
+                    if (r.size() != 2) throw std::runtime_error("BinaryRawHitReader.cfg.range must be [begin, end]");
+                    rawHitReader.set_range(r[0], r[1]);
+                }
+            }
+            if (decode_threads > 0) {
+                rawHitReader.enable_parallel(static_cast<std::size_t>(decode_threads), static_cast<std::size_t>(get_or<int>(cfg, "chunkEvents", 256)));
+            }
+            loop.run([&](EventStore& eventStore) {
+                // read straight into the store's recycled objects (capacity kept across events)
+                auto& rawHits = eventStore.make<std::vector<AHCALRawHit>>(input_key_hits);
+                auto& tluData = eventStore.make<AHCALTLURawData>(input_key_tlu);
                 if (!rawHitReader.next(rawHits, tluData)) {
-                    break; // No more events or error
+                    return false; // No more events or error
                 }
                 if (ctx.config.nEvents > 0 && nEvent >= ctx.config.nEvents) {
-                    break; // Reached the maximum number of events to process
-                }
-                EventStore eventStore;
-                eventStore.put(input_key_hits, std::move(rawHits));
-                eventStore.put(input_key_tlu, std::move(tluData));
-                for (auto& alg : algs) {
-                    alg->execute(eventStore);
+                    return false; // Reached the maximum number of events to process
                 }
                 nEvent++;
                 if (nEvent % 10000 == 0) {
                     LOG_INFO("Processed {}", nEvent);
                 }
-                eventStore.clear();
-            }
+                return true;
+            });
         }else if (type == "RootInput") {
             // Initialize RootInput reader
             RootInput in(ctx.config.input, "events");
             LOG_INFO("RootInput reader created successfully.");
             ReaderRegistry rr = parse_reader_registry(cfg);
+            // branch addresses are bound once; every event is read straight into the store slots
+            const ReadPlan read_plan = make_read_plan(cfg, rr, in);
             Long64_t total_entries = in.entries();
             LOG_INFO("Total entries in input file: {}", total_entries);
             int nEvent = 0;
-            while (true) {
+            loop.run([&](EventStore& eventStore) {
                 if (!in.next()) {
-                    break; // No more events
+                    return false; // No more events
                 }
                 if (ctx.config.nEvents > 0 && nEvent >= ctx.config.nEvents) {
-                    break; // Reached the maximum number of events to process
-                }
-                EventStore eventStore;
-                readandput(cfg, eventStore, rr, in);
-                for (auto& alg : algs) {
-                    alg->execute(eventStore);
+                    return false; // Reached the maximum number of events to process
                 }
+                read_plan.read(eventStore);
                 nEvent++;
                 if (nEvent % 10000 == 0) {
                     LOG_INFO("Processed {}/{} events.", nEvent, total_entries);
                 }
-                eventStore.clear();
-            }
+                return true;
+            });
+            in.log_stats();
         } else {
             LOG_ERROR("Unknown reader type specified in config.");
             return 1;
         }
-        for (auto& alg : algs) {
-            alg->finalize();
-        }
-        algs.clear();
+        stages.for_each_alg([](IAlg& alg) { alg.endInput(); });
     }
+    stages.for_each_alg([](IAlg& alg) { alg.finalize(); });
     LOG_INFO("AHCAL Application finished.");
     std::cout << "AHCAL Application finished." << std::endl;
     return 0;
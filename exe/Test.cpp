@@ -45,24 +45,38 @@ int main(int argc, char* argv[]) {
 
     if (type == "RootRawHitReader") {
         // Initialize RootRawHitReader
-        RootRawHitReader rawHitReader(ctx.config.input, "Raw_Hit");
+        RootRawHitReader rawHitReader(ctx.config.input, "Raw_Hit", get_or<bool>(cfg, "bulk", false));
         LOG_INFO("RootRawHitReader created successfully.");
         int nEvent = 0;
-        std::string input_key_hits = require_string(cfg, "out_rawhits_key");
-        std::string input_key_tlu = require_string(cfg, "out_tlu_key");
+        // AoS hits and/or hit columns (bulk mode hands the columns over without building AHCALRawHit objects)
+        const std::string hits_key = get_or<std::string>(cfg, "out_rawhits_key", "");
+        const std::string columns_key = get_or<std::string>(cfg, "out_rawhit_columns_key", "");
+        if (hits_key.empty() && columns_key.empty()) {
+            LOG_ERROR("RootRawHitReader: set out_rawhits_key and/or out_rawhit_columns_key");
+            return 1;
+        }
+        const EventKey input_key_hits = hits_key.empty() ? EventKey{} : EventKeyRegistry::instance().intern(hits_key);
+        const EventKey input_key_columns = columns_key.empty() ? EventKey{} : EventKeyRegistry::instance().intern(columns_key);
+        const EventKey input_key_tlu = EventKeyRegistry::instance().intern(require_string(cfg, "out_tlu_key"));
         Long64_t total_entries = rawHitReader.entries();
         LOG_INFO("Total entries in input file: {}", total_entries);
         while (true) {
             std::vector<AHCALRawHit> rawHits;
+            AHCALRawHitColumns columns;
             AHCALTLURawData tluData;
-            if (!rawHitReader.next(rawHits, tluData)) {
+            const bool ok = input_key_columns.valid() ? rawHitReader.next(columns, tluData) : rawHitReader.next(rawHits, tluData);
+            if (!ok) {
                 break; // No more events
             }
             if (ctx.config.nEvents > 0 && nEvent >= ctx.config.nEvents) {
                 break; // Reached the maximum number of events to process
             }
             EventStore eventStore;
-            eventStore.put(input_key_hits, std::move(rawHits));
+            if (input_key_columns.valid()) {
+                if (input_key_hits.valid()) columns.to_hits(rawHits);
+                eventStore.put(input_key_columns, std::move(columns));
+            }
+            if (input_key_hits.valid()) eventStore.put(input_key_hits, std::move(rawHits));
             eventStore.put(input_key_tlu, std::move(tluData));
             for (auto& alg : algs) {
                 alg->execute(eventStore);
@@ -75,13 +89,28 @@ int main(int argc, char* argv[]) {
         }
     } else if (type == "BinaryRawHitReader") {
         // Initialize BinaryRawHitReader
-        BinaryRawHitReader rawHitReader(ctx.config.input);
+        BinaryRawHitReader rawHitReader(ctx.config.input, get_or<bool>(cfg, "mmap", false));
         LOG_INFO("BinaryRawHitReader created successfully.");
         int nEvent = 0;
-        std::string input_key_hits = require_string(cfg, "out_rawhits_key");
-        std::string input_key_tlu = require_string(cfg, "out_tlu_key");
-        // Long64_t total_entries = rawHitReader.entries();
-        // LOG_INFO("Total entries in input file: {}", total_entries);
+        const EventKey input_key_hits = EventKeyRegistry::instance().intern(require_string(cfg, "out_rawhits_key"));
+        const EventKey input_key_tlu = EventKeyRegistry::instance().intern(require_string(cfg, "out_tlu_key"));
+        // decodeThreads: decode chunks of chunkEvents events in parallel (uses the index, delivered in order)
+        const int decode_threads = get_or<int>(cfg, "decodeThreads", 0);
+        // index: pre-scan the event offsets (entries(), ranges); index_file: per-input sidecar reused by later jobs
+        // (suffix such as ".idx" or a directory, see BinaryRawHitReader::sidecar_path; default "" = memory only)
+        const YAML::Node range = cfg["range"];
+        if (get_or<bool>(cfg, "index", false) || range || decode_threads > 0) {
+            rawHitReader.build_index(BinaryRawHitReader::sidecar_path(get_or<std::string>(cfg, "index_file", ""), ctx.config.input));
+            LOG_INFO("Total entries in input file: {}", rawHitReader.entries());
+            if (range) {
+                const auto r = range.as<std::vector<long long>>();
+                if (r.size() != 2) throw std::runtime_error("BinaryRawHitReader.cfg.range must be [begin, end]");
+                rawHitReader.set_range(r[0], r[1]);
+            }
+        }
+        if (decode_threads > 0) {
+            rawHitReader.enable_parallel(static_cast<std::size_t>(decode_threads), static_cast<std::size_t>(get_or<int>(cfg, "chunkEvents", 256)));
+        }
         while (true) {
             std::vector<AHCALRawHit> rawHits;
             AHCALTLURawData tluData;
@@ -108,6 +137,8 @@ int main(int argc, char* argv[]) {
         RootInput in(ctx.config.input, "events");
         LOG_INFO("RootInput reader created successfully.");
         ReaderRegistry rr = parse_reader_registry(cfg);
+        // branch addresses are bound once; every event is read straight into the store slots
+        const ReadPlan read_plan = make_read_plan(cfg, rr, in);
         Long64_t total_entries = in.entries();
         LOG_INFO("Total entries in input file: {}", total_entries);
         int nEvent = 0;
@@ -119,7 +150,7 @@ int main(int argc, char* argv[]) {
                 break; // Reached the maximum number of events to process
             }
             EventStore eventStore;
-            readandput(cfg, eventStore, rr, in);
+            read_plan.read(eventStore);
             for (auto& alg : algs) {
                 alg->execute(eventStore);
             }
@@ -129,6 +160,7 @@ int main(int argc, char* argv[]) {
             }
             eventStore.clear();
         }
+        in.log_stats();
     } else {
         LOG_ERROR("Unknown reader type specified in config.");
         return 1;
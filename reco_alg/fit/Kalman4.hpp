@@ -0,0 +1,131 @@
+#pragma once
+#include <cmath>
+
+namespace AHCALRecoAlg {
+    // Kalman filter kernels for a straight track along z with state (x, y, tx, ty), tx = dx/dz,
+    // measured in (x, y) on each layer. They exploit the structure of the model instead of doing
+    // dense 4x4 algebra:
+    //  - the covariance is symmetric, so only its 10 unique elements are stored (SymCov4);
+    //  - the transport F = I + dz*(E02 + E13) only adds dz * rows/columns 2,3 to rows/columns 0,1;
+    //  - H picks (x, y), so S is 2x2 and (I - K H) C needs only rows 0,1 of C.
+    // T is float or double. The kernels are branch-free plain arithmetic, so they also work lane-wise
+    // on GCC/Clang vector types (one track per lane); only kf4_update_xy() branches. Scalar and lane-wise
+    // use give bitwise identical results only if neither is contracted to FMAs (-ffp-contract=off).
+
+    // symmetric 4x4 covariance, upper triangle
+    template <typename T>
+    struct SymCov4 {
+        T c00{}, c01{}, c02{}, c03{};
+        T c11{}, c12{}, c13{};
+        T c22{}, c23{};
+        T c33{};
+
+        static SymCov4 diag(T d0, T d1, T d2, T d3) {
+            SymCov4 c;
+            c.c00 = d0;
+            c.c11 = d1;
+            c.c22 = d2;
+            c.c33 = d3;
+            return c;
+        }
+
+        // element (i, j) of the full matrix
+        T operator()(int i, int j) const {
+            if (i > j) { const int t = i; i = j; j = t; }
+            switch (i * 4 + j) {
+                case 0:  return c00;
+                case 1:  return c01;
+                case 2:  return c02;
+                case 3:  return c03;
+                case 5:  return c11;
+                case 6:  return c12;
+                case 7:  return c13;
+                case 10: return c22;
+                case 11: return c23;
+                default: return c33;
+            }
+        }
+    };
+
+    // Transport by dz: x <- F x, C <- F C F^T + Q with Q = diag(0, 0, q, q) (multiple scattering,
+    // q = sigma_theta^2 per step). dz = 0 and q = 0 leave the track unchanged.
+    template <typename T>
+    inline void kf4_propagate(T x[4], SymCov4<T>& C, T dz, T q) {
+        x[0] = x[0] + dz * x[2];
+        x[1] = x[1] + dz * x[3];
+        // A = F C: rows 0,1 gain dz * rows 2,3; C' = A F^T: columns 0,1 gain dz * columns 2,3
+        const T a02 = C.c02 + dz * C.c22;
+        const T a03 = C.c03 + dz * C.c23;
+        const T a12 = C.c12 + dz * C.c23;
+        const T a13 = C.c13 + dz * C.c33;
+        C.c00 = (C.c00 + dz * C.c02) + dz * a02;
+        C.c01 = (C.c01 + dz * C.c12) + dz * a03;
+        C.c11 = (C.c11 + dz * C.c13) + dz * a13;
+        C.c02 = a02;
+        C.c03 = a03;
+        C.c12 = a12;
+        C.c13 = a13;
+        C.c22 = C.c22 + q;
+        C.c33 = C.c33 + q;
+    }
+
+    // Everything an (x, y) measurement update needs, computed before deciding whether to apply it.
+    template <typename T>
+    struct KF4Gain {
+        T det;      // det S, S = C[0..1][0..1] + r2*I; the rest is meaningless if it is (close to) 0
+        T rx, ry;   // residual m - H x
+        T d2;       // r^T S^-1 r
+        T k[4][2];  // K = C H^T S^-1
+    };
+
+    // measurement (mx, my) with variance r2 in x and in y
+    template <typename T>
+    inline void kf4_gain_xy(const T x[4], const SymCov4<T>& C, T mx, T my, T r2, KF4Gain<T>& g) {
+        const T s00 = C.c00 + r2;
+        const T s01 = C.c01;
+        const T s11 = C.c11 + r2;
+        g.det = s00 * s11 - s01 * s01;
+        const T inv_det = 1 / g.det;
+        const T i00 = s11 * inv_det;
+        const T i01 = -s01 * inv_det;
+        const T i11 = s00 * inv_det;
+        g.rx = mx - x[0];
+        g.ry = my - x[1];
+        g.d2 = g.rx * (i00 * g.rx + i01 * g.ry) + g.ry * (i01 * g.rx + i11 * g.ry);
+        // C H^T = columns 0,1 of C
+        g.k[0][0] = C.c00 * i00 + C.c01 * i01;  g.k[0][1] = C.c00 * i01 + C.c01 * i11;
+        g.k[1][0] = C.c01 * i00 + C.c11 * i01;  g.k[1][1] = C.c01 * i01 + C.c11 * i11;
+        g.k[2][0] = C.c02 * i00 + C.c12 * i01;  g.k[2][1] = C.c02 * i01 + C.c12 * i11;
+        g.k[3][0] = C.c03 * i00 + C.c13 * i01;  g.k[3][1] = C.c03 * i01 + C.c13 * i11;
+    }
+
+    // x <- x + K r, C <- (I - K H) C = C - K (rows 0,1 of C)
+    template <typename T>
+    inline void kf4_apply(T x[4], SymCov4<T>& C, const KF4Gain<T>& g) {
+        for (int i = 0; i < 4; ++i) x[i] = x[i] + (g.k[i][0] * g.rx + g.k[i][1] * g.ry);
+        const SymCov4<T> c = C;
+        C.c00 = c.c00 - (g.k[0][0] * c.c00 + g.k[0][1] * c.c01);
+        C.c01 = c.c01 - (g.k[0][0] * c.c01 + g.k[0][1] * c.c11);
+        C.c02 = c.c02 - (g.k[0][0] * c.c02 + g.k[0][1] * c.c12);
+        C.c03 = c.c03 - (g.k[0][0] * c.c03 + g.k[0][1] * c.c13);
+        C.c11 = c.c11 - (g.k[1][0] * c.c01 + g.k[1][1] * c.c11);
+        C.c12 = c.c12 - (g.k[1][0] * c.c02 + g.k[1][1] * c.c12);
+        C.c13 = c.c13 - (g.k[1][0] * c.c03 + g.k[1][1] * c.c13);
+        C.c22 = c.c22 - (g.k[2][0] * c.c02 + g.k[2][1] * c.c12);
+        C.c23 = c.c23 - (g.k[2][0] * c.c03 + g.k[2][1] * c.c13);
+        C.c33 = c.c33 - (g.k[3][0] * c.c03 + g.k[3][1] * c.c13);
+    }
+
+    // Gated update with measurement (mx, my): applied only if S is invertible and d2 <= gateD2.
+    // Returns whether it was applied; d2 is set either way.
+    template <typename T>
+    inline bool kf4_update_xy(T x[4], SymCov4<T>& C, T mx, T my, T r2, T gateD2, T& d2) {
+        KF4Gain<T> g;
+        kf4_gain_xy(x, C, mx, my, r2, g);
+        d2 = g.d2;
+        if (std::abs(g.det) < static_cast<T>(1e-24)) return false;
+        if (g.d2 > gateD2) return false;
+        kf4_apply(x, C, g);
+        return true;
+    }
+}
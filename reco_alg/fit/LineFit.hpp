@@ -0,0 +1,83 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+namespace AHCALRecoAlg {
+    struct LineFitResult {
+        double intercept = 0.0; // y at x = 0
+        double slope = 0.0;     // dy/dx
+        double chi2 = 0.0;
+        int ndf = 0;            // points - 2
+        bool ok = false;
+    };
+
+    // Straight-line fit y = intercept + slope*x of points that all carry the same errors ex, ey, with
+    // the effective-variance chi2 of TGraphErrors::Fit:
+    //   chi2 = sum_i w_i (y_i - intercept - slope*x_i)^2 / (ey^2 + slope^2 ex^2)
+    // Its minimum has a closed form (Deming regression), so the fit is one pass over the points to
+    // accumulate weighted means and co-moments plus a quadratic solve: no allocation, no minimizer,
+    // no ROOT global state. Optional per-point weights w_i (default 1) scale the chi2 terms, e.g. for
+    // robust reweighting. The slope is limited to +-max_slope (like TF1::SetParLimits).
+    class LineFit {
+    public:
+        LineFit(double ex, double ey, double max_slope = std::numeric_limits<double>::infinity())
+            : m_ex2(ex * ex), m_ey2(ey * ey), m_max_slope(max_slope) {}
+
+        void clear() {
+            m_n = 0;
+            m_w = m_mx = m_my = m_cxx = m_cxy = m_cyy = 0.0;
+        }
+
+        // points with w <= 0 are ignored
+        void add(double x, double y, double w = 1.0) {
+            if (!(w > 0.0)) return;
+            ++m_n;
+            m_w += w;
+            const double dx = x - m_mx;
+            const double dy = y - m_my;
+            m_mx += dx * w / m_w;
+            m_my += dy * w / m_w;
+            m_cxx += w * dx * (x - m_mx);
+            m_cxy += w * dx * (y - m_my);
+            m_cyy += w * dy * (y - m_my);
+        }
+
+        std::size_t size() const { return m_n; }
+
+        LineFitResult solve() const {
+            LineFitResult r;
+            if (m_n < 2) return r;
+            // d(chi2)/d(slope) = 0:  ex^2 Cxy b^2 + (ey^2 Cxx - ex^2 Cyy) b - ey^2 Cxy = 0, minimum at
+            // b = 2 ey^2 Cxy / (D + sqrt(D^2 + 4 ex^2 ey^2 Cxy^2)), D = ey^2 Cxx - ex^2 Cyy (ex = 0: Cxy/Cxx)
+            const double d = m_ey2 * m_cxx - m_ex2 * m_cyy;
+            const double den = d + std::sqrt(d * d + 4.0 * m_ex2 * m_ey2 * m_cxy * m_cxy);
+            double b;
+            if (den > 0.0) {
+                b = 2.0 * m_ey2 * m_cxy / den;
+            } else {
+                // no spread in x (or x errors dominate): the chi2 falls towards the largest allowed slope
+                if (!std::isfinite(m_max_slope)) return r;
+                b = std::copysign(m_max_slope, m_cxy);
+            }
+            if (b > m_max_slope) b = m_max_slope;
+            if (b < -m_max_slope) b = -m_max_slope;
+
+            r.slope = b;
+            r.intercept = m_my - b * m_mx;
+            const double ssr = m_cyy - 2.0 * b * m_cxy + b * b * m_cxx; // sum w r^2 at the best intercept
+            r.chi2 = std::max(ssr, 0.0) / (m_ey2 + b * b * m_ex2);
+            r.ndf = static_cast<int>(m_n) - 2;
+            r.ok = true;
+            return r;
+        }
+
+    private:
+        double m_ex2, m_ey2, m_max_slope;
+        std::size_t m_n = 0;
+        double m_w = 0.0;            // sum of weights
+        double m_mx = 0.0, m_my = 0.0; // weighted means
+        double m_cxx = 0.0, m_cxy = 0.0, m_cyy = 0.0; // weighted co-moments about the means
+    };
+}
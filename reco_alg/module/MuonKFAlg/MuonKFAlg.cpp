@@ -2,12 +2,15 @@
 #include "common/Logger.hpp"
 #include "common/config/YAMLUtil.hpp"
 #include "common/AlgRegistry.hpp"
+#include "reco_alg/fit/Kalman4.hpp"
 
-#include <array>
 #include <algorithm>
+#include <array>
 #include <cctype>
 #include <cmath>
+#include <cstring>
 #include <limits>
+#include <memory_resource>
 
 AHCAL_REGISTER_ALG(AHCALRecoAlg::MuonKFAlg, "MuonKFAlg")
 // using namespace AHCALRecoAlg;
@@ -28,18 +31,21 @@ std::bitset<40> parse_skip_layers(std::vector<int> skipLayers) {
 
 
 // --------------------------------------------
-// Minimal linear algebra helpers (4D state, 2D meas)
+// Track state for the scalar search (kernels in reco_alg/fit/Kalman4.hpp)
 // state: (x, y, tx, ty)
 // meas : (x, y)
 // --------------------------------------------
+using HitPtrs = std::pmr::vector<const AHCALRecoHit*>;
+
 struct TrackInternal {
+  explicit TrackInternal(std::pmr::memory_resource* mr) : used(mr) {}
   double xv[4] = {0,0,0,0};      // x,y,tx,ty
-  double C[4][4] = {{0}};        // covariance
+  SymCov4<double> C;             // covariance
   double z = 0.0;
   double chi2 = 0.0;
   int ndof = 0;
   int consecutive_skips = 0;
-  std::vector<const AHCALRecoHit*> used;
+  HitPtrs used;
 };
 
 static inline double default_sigma_mm() {
@@ -47,133 +53,15 @@ static inline double default_sigma_mm() {
   return AHCALGeometry::xy_size / std::sqrt(12.0);
 }
 
-static inline void mat4_eye(double M[4][4]) {
-  for(int i=0;i<4;i++) for(int j=0;j<4;j++) M[i][j] = (i==j)?1.0:0.0;
-}
-
-static inline void mat4_mul(const double A[4][4], const double B[4][4], double R[4][4]) {
-  for(int i=0;i<4;i++){
-    for(int j=0;j<4;j++){
-      double s=0;
-      for(int k=0;k<4;k++) s += A[i][k]*B[k][j];
-      R[i][j]=s;
-    }
-  }
-}
-
-static inline void mat4_transpose(const double A[4][4], double R[4][4]) {
-  for(int i=0;i<4;i++) for(int j=0;j<4;j++) R[i][j]=A[j][i];
-}
-
-static inline void mat4_add(const double A[4][4], const double B[4][4], double R[4][4]) {
-  for(int i=0;i<4;i++) for(int j=0;j<4;j++) R[i][j]=A[i][j]+B[i][j];
-}
-
-static inline void mat4_sub(const double A[4][4], const double B[4][4], double R[4][4]) {
-  for(int i=0;i<4;i++) for(int j=0;j<4;j++) R[i][j]=A[i][j]-B[i][j];
-}
-
-static inline void mat4_vec4_mul(const double A[4][4], const double x[4], double r[4]) {
-  for(int i=0;i<4;i++){
-    double s=0;
-    for(int j=0;j<4;j++) s += A[i][j]*x[j];
-    r[i]=s;
-  }
-}
-
 static inline void propagate(TrackInternal& trk, double z_to, double sigmaTheta) {
-  const double dz = z_to - trk.z;
-
-  // F
-  double F[4][4]; mat4_eye(F);
-  F[0][2]=dz;
-  F[1][3]=dz;
-
-  // x <- F x
-  double xnew[4];
-  mat4_vec4_mul(F, trk.xv, xnew);
-  for(int i=0;i<4;i++) trk.xv[i]=xnew[i];
-
-  // C <- F C F^T + Q
-  double Ft[4][4]; mat4_transpose(F, Ft);
-  double FC[4][4]; mat4_mul(F, trk.C, FC);
-  double FCFt[4][4]; mat4_mul(FC, Ft, FCFt);
-
-  double Q[4][4] = {{0}};
-  Q[2][2] = sigmaTheta*sigmaTheta;
-  Q[3][3] = sigmaTheta*sigmaTheta;
-
-  mat4_add(FCFt, Q, trk.C);
-
+  kf4_propagate(trk.xv, trk.C, z_to - trk.z, sigmaTheta*sigmaTheta);
   trk.z = z_to;
 }
 
-// compute d2 = r^T S^-1 r for 2x2 S
-static inline double d2_2d(double rx, double ry,
-                           double S00, double S01, double S10, double S11) {
-  const double det = S00*S11 - S01*S10;
-  const double inv00 =  S11 / det;
-  const double inv01 = -S01 / det;
-  const double inv10 = -S10 / det;
-  const double inv11 =  S00 / det;
-  return rx*(inv00*rx + inv01*ry) + ry*(inv10*rx + inv11*ry);
-}
-
 static inline bool update_with_hit(TrackInternal& trk, const AHCALRecoHit& h,
                                    double sigma_xy_mm, double gateD2) {
-  const double mx = h.Xpos();
-  const double my = h.Ypos();
-
-  const double hx = trk.xv[0];
-  const double hy = trk.xv[1];
-
-  const double rx = mx - hx;
-  const double ry = my - hy;
-
-  // S = top-left 2x2 of C + R
-  double S00 = trk.C[0][0] + sigma_xy_mm*sigma_xy_mm;
-  double S01 = trk.C[0][1];
-  double S10 = trk.C[1][0];
-  double S11 = trk.C[1][1] + sigma_xy_mm*sigma_xy_mm;
-
-  const double det = S00*S11 - S01*S10;
-  if (std::abs(det) < 1e-24) return false;
-
-  const double inv00 =  S11 / det;
-  const double inv01 = -S01 / det;
-  const double inv10 = -S10 / det;
-  const double inv11 =  S00 / det;
-
-  const double d2 = rx*(inv00*rx + inv01*ry) + ry*(inv10*rx + inv11*ry);
-  if (d2 > gateD2) return false;
-
-  // K = C H^T S^-1  (4x2) where H picks (x,y)
-  // First take C[:,0..1] then multiply by S^-1
-  double K[4][2];
-  for(int i=0;i<4;i++){
-    const double c0 = trk.C[i][0];
-    const double c1 = trk.C[i][1];
-    K[i][0] = c0*inv00 + c1*inv10;
-    K[i][1] = c0*inv01 + c1*inv11;
-  }
-
-  // x <- x + K r
-  trk.xv[0] += K[0][0]*rx + K[0][1]*ry;
-  trk.xv[1] += K[1][0]*rx + K[1][1]*ry;
-  trk.xv[2] += K[2][0]*rx + K[2][1]*ry;
-  trk.xv[3] += K[3][0]*rx + K[3][1]*ry;
-
-  // C <- (I - K H) C
-  // (I - K H) only affects columns 0,1:
-  // M = I; M(i,0)-=K(i,0); M(i,1)-=K(i,1)
-  double M[4][4]; mat4_eye(M);
-  for(int i=0;i<4;i++){
-    M[i][0] -= K[i][0];
-    M[i][1] -= K[i][1];
-  }
-  double MC[4][4];
-  mat4_mul(M, trk.C, MC);
-  for(int i=0;i<4;i++) for(int j=0;j<4;j++) trk.C[i][j]=MC[i][j];
+  double d2;
+  if (!kf4_update_xy(trk.xv, trk.C, h.Xpos(), h.Ypos(), sigma_xy_mm*sigma_xy_mm, gateD2, d2)) return false;
 
   trk.chi2 += d2;
   trk.ndof += 2;
@@ -182,16 +70,159 @@ static inline bool update_with_hit(TrackInternal& trk, const AHCALRecoHit& h,
   return true;
 }
 
+static inline bool in_nmip_window(const AHCALRecoHit& h, const MuonKFAlgCfg& cfg) {
+  return !cfg.useNmipWindow || !(h.Nmip < cfg.nmipMin || h.Nmip > cfg.nmipMax);
+}
+
+// --------------------------------------------
+// Per-event cell grid of the busy layers (cfg.hitGrid)
+// The detector is an 18x18 grid of 40.3 mm tiles, so the hits of a layer are bucketed by tile
+// (CellPosition::xIndex/yIndex, outer tiles open towards the outside) in hit order. A nearest-hit
+// query walks rings of tiles around the predicted tile and stops as soon as every tile further out is
+// farther away than the best hit, so it inspects a few tiles instead of every hit of the layer. It
+// returns the same hit as the linear scan, including ties (first hit in layer order).
+// --------------------------------------------
+class HitGrid {
+public:
+  static constexpr int kTiles = 18;            // per row / column
+  static constexpr int kCells = kTiles*kTiles;
+  static constexpr std::size_t kMinHits = 32;  // fewer hits in a layer: the linear scan is as fast
+
+  explicit HitGrid(std::pmr::memory_resource* mr) : m_layers(mr), m_start(mr), m_entries(mr) { m_slot.fill(-1); }
+
+  bool has_layer(int L) const { return m_slot[L] >= 0; }
+
+  // bucket the hits of layer L that pass the Nmip window
+  void add_layer(int L, const HitPtrs& hits, const MuonKFAlgCfg& cfg) {
+    LayerIndex g;
+    std::fill(g.row_x0, g.row_x0 + kTiles, kTiles);
+    std::fill(g.row_x1, g.row_x1 + kTiles, -1);
+    g.start = m_start.size();
+    g.base = m_entries.size();
+    m_start.resize(g.start + kCells + 1, 0);
+    int* start = m_start.data() + g.start;
+
+    // counting sort by tile, stable in hit order
+    for (const auto* h : hits) {
+      if (!in_nmip_window(*h, cfg)) continue;
+      const AHCALGeometry::CellPosition p = AHCALGeometry::CellPos(h->cellID);
+      const int ix = clamp_tile(p.xIndex);
+      const int iy = clamp_tile(p.yIndex);
+      ++start[iy*kTiles + ix + 1];
+      g.ix0 = std::min(g.ix0, ix); g.ix1 = std::max(g.ix1, ix);
+      g.iy0 = std::min(g.iy0, iy); g.iy1 = std::max(g.iy1, iy);
+      g.row_x0[iy] = std::min(g.row_x0[iy], ix); g.row_x1[iy] = std::max(g.row_x1[iy], ix);
+    }
+    for (int c = 0; c < kCells; ++c) start[c + 1] += start[c];
+    m_entries.resize(g.base + start[kCells]);
+
+    int fill[kCells];
+    std::copy(start, start + kCells, fill);
+    int order = 0;
+    for (const auto* h : hits) {
+      if (!in_nmip_window(*h, cfg)) { ++order; continue; }
+      const AHCALGeometry::CellPosition p = AHCALGeometry::CellPos(h->cellID);
+      Entry& e = m_entries[g.base + fill[clamp_tile(p.yIndex)*kTiles + clamp_tile(p.xIndex)]++];
+      e.x = p.x;
+      e.y = p.y;
+      e.order = order++;
+      e.hit = h;
+    }
+    m_slot[L] = static_cast<int>(m_layers.size());
+    m_layers.push_back(g);
+  }
+
+  // nearest hit of layer L to (xpred, ypred), as pick_nearest_hit's linear scan would find it
+  const AHCALRecoHit* nearest(int L, double xpred, double ypred) const {
+    const LayerIndex& g = m_layers[m_slot[L]];
+    if (g.ix0 > g.ix1) return nullptr; // no hit in the Nmip window
+    if (!std::isfinite(xpred) || !std::isfinite(ypred)) return nullptr; // no finite distance either
+    const int cx = tile_of(xpred);
+    const int cy = tile_of(ypred);
+    const int* start = m_start.data() + g.start;
+    const Entry* entries = m_entries.data() + g.base;
+
+    const Entry* best = nullptr;
+    double best_d2 = std::numeric_limits<double>::infinity();
+    auto visit = [&](int ix, int iy) {
+      const int c = iy*kTiles + ix;
+      for (int i = start[c]; i < start[c + 1]; ++i) {
+        const Entry& e = entries[i];
+        const double dx = e.x - xpred;
+        const double dy = e.y - ypred;
+        const double d2 = dx*dx + dy*dy;
+        if (d2 < best_d2 || (best && d2 == best_d2 && e.order < best->order)) {
+          best_d2 = d2;
+          best = &e;
+        }
+      }
+    };
+
+    const int rmax = std::max(std::max(cx - g.ix0, g.ix1 - cx), std::max(cy - g.iy0, g.iy1 - cy));
+    for (int r = 0; r <= rmax; ++r) {
+      // tiles r or more steps away are at least `gap` away; equal distances must still be visited (ties)
+      if (best && r > 0) {
+        double gap = std::numeric_limits<double>::infinity();
+        if (cx + r <= g.ix1) gap = std::min(gap, tile_edge(cx + r) - xpred);
+        if (cx - r >= g.ix0) gap = std::min(gap, xpred - tile_edge(cx - r + 1));
+        if (cy + r <= g.iy1) gap = std::min(gap, tile_edge(cy + r) - ypred);
+        if (cy - r >= g.iy0) gap = std::min(gap, ypred - tile_edge(cy - r + 1));
+        gap -= 1e-6; // rounding of the tile edges
+        if (gap > 0.0 && gap*gap > best_d2) break;
+      }
+      const int x0 = std::max(cx - r, g.ix0), x1 = std::min(cx + r, g.ix1);
+      const int y0 = std::max(cy - r, g.iy0), y1 = std::min(cy + r, g.iy1);
+      for (int iy = y0; iy <= y1; ++iy) {
+        const int rx0 = g.row_x0[iy], rx1 = g.row_x1[iy]; // occupied tiles of the row
+        if (iy == cy - r || iy == cy + r) {
+          for (int ix = std::max(x0, rx0); ix <= std::min(x1, rx1); ++ix) visit(ix, iy);
+        } else {
+          if (cx - r >= rx0 && cx - r <= rx1) visit(cx - r, iy);
+          if (r > 0 && cx + r >= rx0 && cx + r <= rx1) visit(cx + r, iy);
+        }
+      }
+    }
+    return best ? best->hit : nullptr;
+  }
+
+private:
+  struct Entry {
+    double x, y;
+    int order; // position in the layer's hit list
+    const AHCALRecoHit* hit;
+  };
+  struct LayerIndex {
+    std::size_t start = 0; // kCells + 1 offsets at m_start[start], relative to base
+    std::size_t base = 0;  // first entry in m_entries
+    int ix0 = kTiles, ix1 = -1, iy0 = kTiles, iy1 = -1; // occupied tiles
+    int row_x0[kTiles], row_x1[kTiles];                  // occupied tiles per row (iy)
+  };
+
+  static int clamp_tile(int i) { return i < 0 ? 0 : (i >= kTiles ? kTiles - 1 : i); }
+  // same convention as CellPosition::xIndex = int(x/40.3 + 9)
+  static int tile_of(double v) {
+    const double t = v / 40.3 + 9.0;
+    return t < 0.0 ? 0 : (t >= kTiles - 1 ? kTiles - 1 : static_cast<int>(t)); // truncation = floor here
+  }
+  // lower edge of tile i
+  static double tile_edge(int i) { return (i - 9) * 40.3; }
+
+  std::array<int, 40> m_slot; // index into m_layers, -1: layer not gridded
+  std::pmr::vector<LayerIndex> m_layers;
+  std::pmr::vector<int> m_start;
+  std::pmr::vector<Entry> m_entries;
+};
+
 static inline const AHCALRecoHit* pick_nearest_hit(
-    const std::vector<const AHCALRecoHit*>& hits,
+    const HitPtrs& hits,
+    const HitGrid& grid, int L,
     double xpred, double ypred,
     const MuonKFAlgCfg& cfg) {
+  if (grid.has_layer(L)) return grid.nearest(L, xpred, ypred);
   const AHCALRecoHit* best = nullptr;
   double best_d2 = std::numeric_limits<double>::infinity();
   for (const auto* h : hits) {
-    if (cfg.useNmipWindow) {
-      if (h->Nmip < cfg.nmipMin || h->Nmip > cfg.nmipMax) continue;
-    }
+    if (!in_nmip_window(*h, cfg)) continue;
     const double dx = h->Xpos() - xpred;
     const double dy = h->Ypos() - ypred;
     const double d2 = dx*dx + dy*dy;
@@ -203,10 +234,11 @@ static inline const AHCALRecoHit* pick_nearest_hit(
   return best;
 }
 
-static inline std::vector<const AHCALRecoHit*> topK_for_seed(
-    std::vector<const AHCALRecoHit*> hits,
+static inline HitPtrs topK_for_seed(
+    const HitPtrs& layerHits,
     int K,
     const MuonKFAlgCfg& cfg) {
+  HitPtrs hits(layerHits, layerHits.get_allocator());
   if (cfg.useNmipWindow) {
     hits.erase(std::remove_if(hits.begin(), hits.end(), [&](auto* h){
       return (h->Nmip < cfg.nmipMin || h->Nmip > cfg.nmipMax);
@@ -219,17 +251,357 @@ static inline std::vector<const AHCALRecoHit*> topK_for_seed(
   return hits;
 }
 
+// --------------------------------------------
+// Result export (shared by the scalar and the batched seed search)
+// --------------------------------------------
+static void export_track(Track& out, const double xv[4], double z, double chi2, int ndof, int consecutive_skips,
+                         const AHCALRecoHit* const* used, std::size_t nUsed,
+                         const std::vector<AHCALRecoHit>& recoHits) {
+  out.clear();
+  out.x  = xv[0];
+  out.y  = xv[1];
+  out.tx = xv[2];
+  out.ty = xv[3];
+  out.z  = z;
+  out.chi2 = chi2;
+  out.ndof = ndof;
+  out.consecutive_skips = consecutive_skips;
+  out.inTrackHitsIndices.clear();
+  out.outTrackHitsIndices.clear();
+  out.valid = true;
+  for (std::size_t i = 0; i < nUsed; ++i) {
+    out.inTrackHits.push_back(*used[i]);
+    out.inTrackHitsIndices.push_back(used[i]->index);
+    out.nInTrackHits++;
+  }
+  for (const auto& h : recoHits) {
+    bool isUsed = false;
+    for (std::size_t i = 0; i < nUsed; ++i) {
+      if (h.index == used[i]->index) {
+        isUsed = true;
+        break;
+      }
+    }
+    if (!isUsed) {
+      out.outTrackHits.push_back(h);
+      out.outTrackHitsIndices.push_back(h.index);
+      out.nOutTrackHits++;
+    }
+  }
+}
+
+// --------------------------------------------
+// Batched seed search (cfg.batchSeeds)
+// Every seed pair starts at the back layer L2 and walks the same active layers, so all pairs are
+// filtered together: one lane per seed, state and covariance stored as columns (structure of arrays).
+// Lanes are processed in blocks of kSeedLanes, one SIMD vector each, with the same Kalman4 kernels as
+// the scalar loop applied lane-wise. Finished lanes are removed between layers (the live lanes are
+// compacted to the front), so every block holds live seeds. Hit picking is vectorised over lanes too:
+// the window-passing hits of a layer are laid out once and every block of lanes scans them together.
+// Seeds, picked hits, selection and rounding are those of the scalar loop.
+// --------------------------------------------
+#ifdef __AVX__
+constexpr std::size_t kSeedLanes = 4; // one 256-bit register of doubles
+#else
+constexpr std::size_t kSeedLanes = 2; // SSE2
+#endif
+
+struct SeedBatch {
+  // per-lane columns; lanes [0, nLive) hold the live seeds, in seed order
+  enum Col { X, Y, TX, TY, C00, C01, C02, C03, C11, C12, C13, C22, C23, C33, CHI2, MX, MY, NCols };
+  static constexpr int kStateCols = CHI2 + 1; // columns carried over when lanes are compacted
+
+  SeedBatch(std::size_t nSeeds, std::size_t nLayers, std::pmr::memory_resource* mr)
+      : n((nSeeds + kSeedLanes - 1) / kSeedLanes * kSeedLanes), maxUsed(nLayers), nLive(nSeeds),
+        data(NCols * n, 0.0, mr), accepted(n, 0.0, mr), pick(n, nullptr, mr), seed(n, 0, mr),
+        ndof(nSeeds, 0, mr), skips(nSeeds, 0, mr), nUsed(nSeeds, 0, mr), used(nSeeds * nLayers, nullptr, mr),
+        result(nSeeds * 6, 0.0, mr) {}
+
+  double* col(Col c) { return data.data() + c * n; }
+  std::size_t blocks() const { return (nLive + kSeedLanes - 1) / kSeedLanes; }
+
+  std::size_t n;       // lanes, a multiple of kSeedLanes
+  std::size_t maxUsed; // hits per seed at most (one per active layer)
+  std::size_t nLive;   // seeds still filtering
+  // per lane
+  std::pmr::vector<double> data;     // column c of lane l at c*n + l
+  std::pmr::vector<double> accepted; // 1: the picked hit passed the gate in the current layer
+  std::pmr::vector<const AHCALRecoHit*> pick; // hit picked in the current layer (MX, MY), nullptr if none
+  std::pmr::vector<int> seed;        // seed of the lane
+  // per seed
+  std::pmr::vector<int> ndof, skips, nUsed;
+  std::pmr::vector<const AHCALRecoHit*> used; // hits of seed s at [s*maxUsed, s*maxUsed + nUsed[s])
+  std::pmr::vector<double> result;   // final x, y, tx, ty, z, chi2 of seed s at [6*s, 6*s + 6)
+};
+
+// kSeedLanes doubles processed as one native vector (GCC/Clang vector extension)
+typedef double SeedVec __attribute__((vector_size(kSeedLanes * sizeof(double))));
+
+static inline void load_lanes(SeedVec& v, const double* p) { std::memcpy(&v, p, sizeof(SeedVec)); }
+static inline void store_lanes(double* p, const SeedVec& v) { std::memcpy(p, &v, sizeof(SeedVec)); }
+
+// state and covariance of lanes [l, l + kSeedLanes)
+static inline void load_seeds(double* const* cols, std::size_t l, SeedVec x[4], SymCov4<SeedVec>& C) {
+  load_lanes(x[0], cols[SeedBatch::X] + l);     load_lanes(x[1], cols[SeedBatch::Y] + l);
+  load_lanes(x[2], cols[SeedBatch::TX] + l);    load_lanes(x[3], cols[SeedBatch::TY] + l);
+  load_lanes(C.c00, cols[SeedBatch::C00] + l);  load_lanes(C.c01, cols[SeedBatch::C01] + l);
+  load_lanes(C.c02, cols[SeedBatch::C02] + l);  load_lanes(C.c03, cols[SeedBatch::C03] + l);
+  load_lanes(C.c11, cols[SeedBatch::C11] + l);  load_lanes(C.c12, cols[SeedBatch::C12] + l);
+  load_lanes(C.c13, cols[SeedBatch::C13] + l);  load_lanes(C.c22, cols[SeedBatch::C22] + l);
+  load_lanes(C.c23, cols[SeedBatch::C23] + l);  load_lanes(C.c33, cols[SeedBatch::C33] + l);
+}
+
+static inline void store_seeds(double* const* cols, std::size_t l, const SeedVec x[4], const SymCov4<SeedVec>& C) {
+  store_lanes(cols[SeedBatch::X] + l, x[0]);     store_lanes(cols[SeedBatch::Y] + l, x[1]);
+  store_lanes(cols[SeedBatch::TX] + l, x[2]);    store_lanes(cols[SeedBatch::TY] + l, x[3]);
+  store_lanes(cols[SeedBatch::C00] + l, C.c00);  store_lanes(cols[SeedBatch::C01] + l, C.c01);
+  store_lanes(cols[SeedBatch::C02] + l, C.c02);  store_lanes(cols[SeedBatch::C03] + l, C.c03);
+  store_lanes(cols[SeedBatch::C11] + l, C.c11);  store_lanes(cols[SeedBatch::C12] + l, C.c12);
+  store_lanes(cols[SeedBatch::C13] + l, C.c13);  store_lanes(cols[SeedBatch::C22] + l, C.c22);
+  store_lanes(cols[SeedBatch::C23] + l, C.c23);  store_lanes(cols[SeedBatch::C33] + l, C.c33);
+}
+
+// x <- F x, C <- F C F^T + Q for the live lanes (padding lanes of the last block are moved along unread)
+static void propagate_seeds(SeedBatch& b, double dz, double sigmaTheta) {
+  double* cols[SeedBatch::NCols];
+  for (int c = 0; c < SeedBatch::NCols; ++c) cols[c] = b.col(static_cast<SeedBatch::Col>(c));
+  const SeedVec d = SeedVec{} + dz;
+  const SeedVec q = SeedVec{} + sigmaTheta*sigmaTheta;
+  for (std::size_t k = 0, l = 0; k < b.blocks(); ++k, l += kSeedLanes) {
+    SeedVec x[4];
+    SymCov4<SeedVec> C;
+    load_seeds(cols, l, x, C);
+    kf4_propagate(x, C, d, q);
+    store_seeds(cols, l, x, C);
+  }
+}
+
+// Window-passing hits of one layer laid out for the lane-parallel nearest-hit scan, in layer order.
+struct LayerCandidates {
+  explicit LayerCandidates(std::pmr::memory_resource* mr) : x(mr), y(mr), hit(mr) {}
+  void assign(const HitPtrs& hits, const MuonKFAlgCfg& cfg) {
+    x.clear(); y.clear(); hit.clear();
+    for (const auto* h : hits) {
+      if (!in_nmip_window(*h, cfg)) continue;
+      const AHCALGeometry::CellPosition p = AHCALGeometry::CellPos(h->cellID);
+      x.push_back(p.x);
+      y.push_back(p.y);
+      hit.push_back(h);
+    }
+  }
+  std::pmr::vector<double> x, y;
+  std::pmr::vector<const AHCALRecoHit*> hit;
+};
+
+// pick_nearest_hit for every live lane: each block of lanes scans the candidates once, keeping the
+// first hit at the smallest distance per lane (strict <, as the scalar scan). Fills pick, MX, MY and
+// sets accepted to "has a hit" (padding lanes: no hit).
+static void pick_seeds(SeedBatch& b, const LayerCandidates& cand) {
+  double* X = b.col(SeedBatch::X);
+  double* Y = b.col(SeedBatch::Y);
+  double* MX = b.col(SeedBatch::MX);
+  double* MY = b.col(SeedBatch::MY);
+  const std::size_t nc = cand.hit.size();
+  for (std::size_t k = 0, l = 0; k < b.blocks(); ++k, l += kSeedLanes) {
+    SeedVec x, y;
+    load_lanes(x, X + l);
+    load_lanes(y, Y + l);
+    SeedVec best = SeedVec{} + std::numeric_limits<double>::infinity();
+    SeedVec idx = SeedVec{} - 1.0;
+    for (std::size_t j = 0; j < nc; ++j) {
+      const SeedVec dx = cand.x[j] - x;
+      const SeedVec dy = cand.y[j] - y;
+      const SeedVec d2 = dx*dx + dy*dy;
+      const auto closer = d2 < best;
+      best = closer ? d2 : best;
+      idx = closer ? SeedVec{} + static_cast<double>(j) : idx;
+    }
+    double lane_idx[kSeedLanes];
+    store_lanes(lane_idx, idx);
+    for (std::size_t i = 0; i < kSeedLanes; ++i) {
+      const std::size_t lane = l + i;
+      const bool hit = lane < b.nLive && lane_idx[i] >= 0.0;
+      const std::size_t j = hit ? static_cast<std::size_t>(lane_idx[i]) : 0;
+      b.pick[lane] = hit ? cand.hit[j] : nullptr;
+      b.accepted[lane] = hit ? 1.0 : 0.0;
+      MX[lane] = hit ? cand.x[j] : 0.0;
+      MY[lane] = hit ? cand.y[j] : 0.0;
+    }
+  }
+}
+
+// Kalman update of every lane that picked a hit (accepted[l] = 1 on entry, position in MX, MY), gated
+// on d2 = r^T S^-1 r <= gateD2; accepted[l] is 1 on return if the hit was used. Other lanes are unchanged.
+static void update_seeds(SeedBatch& b, double sigma_xy_mm, double gateD2) {
+  const SeedVec r2 = SeedVec{} + sigma_xy_mm*sigma_xy_mm;
+  double* cols[SeedBatch::NCols];
+  for (int c = 0; c < SeedBatch::NCols; ++c) cols[c] = b.col(static_cast<SeedBatch::Col>(c));
+  for (std::size_t k = 0, l = 0; k < b.blocks(); ++k, l += kSeedLanes) {
+    SeedVec has_hit, chi2, mx, my, x[4];
+    SymCov4<SeedVec> C;
+    load_lanes(has_hit, b.accepted.data() + l);
+    load_lanes(chi2, cols[SeedBatch::CHI2] + l);
+    load_lanes(mx, cols[SeedBatch::MX] + l);
+    load_lanes(my, cols[SeedBatch::MY] + l);
+    load_seeds(cols, l, x, C);
+
+    KF4Gain<SeedVec> g;
+    kf4_gain_xy(x, C, mx, my, r2, g);
+    const auto acc = (has_hit != 0.0) & ((g.det < 0.0 ? -g.det : g.det) >= 1e-24) & (g.d2 <= gateD2);
+
+    // apply to every lane, keep the result only where accepted
+    SeedVec xn[4] = {x[0], x[1], x[2], x[3]};
+    SymCov4<SeedVec> Cn = C;
+    kf4_apply(xn, Cn, g);
+    for (int i = 0; i < 4; ++i) x[i] = acc ? xn[i] : x[i];
+    C.c00 = acc ? Cn.c00 : C.c00;  C.c01 = acc ? Cn.c01 : C.c01;
+    C.c02 = acc ? Cn.c02 : C.c02;  C.c03 = acc ? Cn.c03 : C.c03;
+    C.c11 = acc ? Cn.c11 : C.c11;  C.c12 = acc ? Cn.c12 : C.c12;
+    C.c13 = acc ? Cn.c13 : C.c13;  C.c22 = acc ? Cn.c22 : C.c22;
+    C.c23 = acc ? Cn.c23 : C.c23;  C.c33 = acc ? Cn.c33 : C.c33;
+    store_seeds(cols, l, x, C);
+    store_lanes(cols[SeedBatch::CHI2] + l, acc ? chi2 + g.d2 : chi2);
+    store_lanes(b.accepted.data() + l, acc ? SeedVec{} + 1.0 : SeedVec{});
+  }
+}
+
+// final state of the seed in lane l, filtered up to z
+static inline void finish_lane(SeedBatch& b, std::size_t l, double z) {
+  double* r = b.result.data() + 6 * b.seed[l];
+  r[0] = b.col(SeedBatch::X)[l];
+  r[1] = b.col(SeedBatch::Y)[l];
+  r[2] = b.col(SeedBatch::TX)[l];
+  r[3] = b.col(SeedBatch::TY)[l];
+  r[4] = z;
+  r[5] = b.col(SeedBatch::CHI2)[l];
+}
+
+// Hit bookkeeping of the live lanes after update_seeds, as in the scalar loop; seeds with too many
+// consecutive skips are finished and their lanes dropped, the others move up in order.
+static void advance_seeds(SeedBatch& b, double z, int maxConsecutiveSkips) {
+  std::size_t live = 0;
+  for (std::size_t l = 0; l < b.nLive; ++l) {
+    const int s = b.seed[l];
+    if (b.accepted[l] != 0.0) {
+      b.ndof[s] += 2;
+      b.skips[s] = 0;
+      b.used[s * b.maxUsed + b.nUsed[s]++] = b.pick[l];
+    } else if (++b.skips[s] > maxConsecutiveSkips) {
+      finish_lane(b, l, z);
+      continue;
+    }
+    if (live != l) {
+      for (int c = 0; c < SeedBatch::kStateCols; ++c) {
+        double* v = b.col(static_cast<SeedBatch::Col>(c));
+        v[live] = v[l];
+      }
+      b.seed[live] = s;
+    }
+    ++live;
+  }
+  b.nLive = live;
+}
+
+// Same search as the scalar loop in find_muon_track_kf (same seeds, seed order = scalar seed order,
+// same selection), with all seed pairs filtered together.
+static bool find_muon_track_batched(const std::vector<AHCALRecoHit>& recoHits,
+                                    const std::pmr::vector<HitPtrs>& byLayer,
+                                    const std::pmr::vector<int>& layers,
+                                    const HitPtrs& hitsL2,
+                                    const std::pmr::vector<int>& seedL1s,
+                                    double sigma_xy,
+                                    Track& bestOut,
+                                    const MuonKFAlgCfg& cfg,
+                                    std::pmr::memory_resource* scratch) {
+  const int L2 = layers.back();
+  const double z2 = AHCALGeometry::Pos_Z(L2);
+
+  // seed pairs in the order of the scalar loops: L1, h1, h2
+  std::pmr::vector<HitPtrs> hitsL1s(scratch);
+  std::size_t nSeeds = 0;
+  for (int L1 : seedL1s) {
+    hitsL1s.push_back(topK_for_seed(byLayer[L1], cfg.maxSeedHitsPerLayer, cfg));
+    if (std::abs(z2 - AHCALGeometry::Pos_Z(L1)) < 1e-6) hitsL1s.back().clear();
+    nSeeds += hitsL1s.back().size() * hitsL2.size();
+  }
+  if (nSeeds == 0) return false;
+
+  SeedBatch b(nSeeds, layers.size(), scratch);
+  {
+    double* x = b.col(SeedBatch::X);   double* y = b.col(SeedBatch::Y);
+    double* tx = b.col(SeedBatch::TX); double* ty = b.col(SeedBatch::TY);
+    double* c00 = b.col(SeedBatch::C00); double* c11 = b.col(SeedBatch::C11);
+    double* c22 = b.col(SeedBatch::C22); double* c33 = b.col(SeedBatch::C33);
+    const double slope0 = 0.05; // 50 mrad prior (loose)
+    std::size_t l = 0;
+    for (std::size_t i = 0; i < seedL1s.size(); ++i) {
+      const double dz = z2 - AHCALGeometry::Pos_Z(seedL1s[i]);
+      for (const auto* h1 : hitsL1s[i]) {
+        for (const auto* h2 : hitsL2) {
+          x[l] = h2->Xpos();
+          y[l] = h2->Ypos();
+          tx[l] = (h2->Xpos() - h1->Xpos()) / dz;
+          ty[l] = (h2->Ypos() - h1->Ypos()) / dz;
+          c00[l] = sigma_xy*sigma_xy;
+          c11[l] = sigma_xy*sigma_xy;
+          c22[l] = slope0*slope0;
+          c33[l] = slope0*slope0;
+          b.seed[l] = static_cast<int>(l);
+          b.used[l * b.maxUsed] = h2;
+          b.nUsed[l] = 1;
+          ++l;
+        }
+      }
+    }
+  }
+
+  // iterate backward over active layers (excluding L2 itself at the end); all live lanes share z
+  LayerCandidates cand(scratch);
+  double z = z2;
+  for (int idx = (int)layers.size() - 2; idx >= 0 && b.nLive > 0; --idx) {
+    const int L = layers[idx];
+    const double zL = AHCALGeometry::Pos_Z(L);
+    propagate_seeds(b, zL - z, cfg.sigmaTheta);
+    z = zL;
+
+    cand.assign(byLayer[L], cfg);
+    pick_seeds(b, cand);
+    update_seeds(b, sigma_xy, cfg.gateD2);
+    advance_seeds(b, z, cfg.maxConsecutiveSkips);
+  }
+  for (std::size_t l = 0; l < b.nLive; ++l) finish_lane(b, l, z);
+
+  // best seed, first one wins on ties (scalar order)
+  double bestScore = std::numeric_limits<double>::infinity();
+  std::size_t best = nSeeds;
+  for (std::size_t s = 0; s < nSeeds; ++s) {
+    if (b.nUsed[s] < cfg.minUsedLayers) continue;
+    const double chi2ndof = (b.ndof[s] > 0) ? (b.result[6 * s + 5] / b.ndof[s]) : 1e9;
+    const double score = chi2ndof + 2.0 / (double)b.nUsed[s];
+    if (score < bestScore) {
+      bestScore = score;
+      best = s;
+    }
+  }
+  if (best == nSeeds) return false;
+
+  const double* r = b.result.data() + 6 * best;
+  export_track(bestOut, r, r[4], r[5], b.ndof[best], b.skips[best],
+               b.used.data() + best * b.maxUsed, b.nUsed[best], recoHits);
+  return true;
+}
+
 // --------------------------------------------
 // Public function: find_muon_track_kf
 // --------------------------------------------
 bool find_muon_track_kf(const std::vector<AHCALRecoHit>& recoHits,
                         Track& bestOut,
-                        const MuonKFAlgCfg& cfg) {
+                        const MuonKFAlgCfg& cfg,
+                        std::pmr::memory_resource* scratch) {
   if (recoHits.empty()) return false;
 
   // group by layer, respecting skipLayer
-  std::array<std::vector<const AHCALRecoHit*>, 40> byLayer;
-  for (auto& v : byLayer) v.clear();
+  std::pmr::vector<HitPtrs> byLayer(40, scratch);
 
   int maxLayer = -1;
   for (const auto& h : recoHits) {
@@ -245,7 +617,7 @@ bool find_muon_track_kf(const std::vector<AHCALRecoHit>& recoHits,
   const int Lstart = std::max(0, Lend - cfg.lastNLayers + 1);
 
   // build active layer list (hit exists + not skipped)
-  std::vector<int> layers;
+  std::pmr::vector<int> layers(scratch);
   layers.reserve(cfg.lastNLayers);
   for (int L = Lstart; L <= Lend; ++L) {
     if (cfg.skipLayer.test(L)) continue;
@@ -261,16 +633,30 @@ bool find_muon_track_kf(const std::vector<AHCALRecoHit>& recoHits,
   if (hitsL2.empty()) return false;
 
   // choose candidate earlier layers for seeds with sufficient gap
-  std::vector<int> seedL1s;
+  std::pmr::vector<int> seedL1s(scratch);
   for (int i = (int)layers.size() - 2; i >= 0; --i) {
     if (L2 - layers[i] >= cfg.seedLayerGap) seedL1s.push_back(layers[i]);
     if ((int)seedL1s.size() >= 4) break;
   }
   if (seedL1s.empty()) return false;
 
+  // the batched search scans each layer once for all lanes (pick_seeds) and needs no grid
+  if (cfg.batchSeeds) {
+    return find_muon_track_batched(recoHits, byLayer, layers, hitsL2, seedL1s, sigma_xy, bestOut, cfg, scratch);
+  }
+
+  // cell grids of the busy layers the filter steps through (all but L2), built once per event
+  HitGrid grid(scratch);
+  if (cfg.hitGrid) {
+    for (std::size_t i = 0; i + 1 < layers.size(); ++i) {
+      if (byLayer[layers[i]].size() >= HitGrid::kMinHits) grid.add_layer(layers[i], byLayer[layers[i]], cfg);
+    }
+  }
+
   bool found = false;
   double bestScore = std::numeric_limits<double>::infinity();
-  TrackInternal bestInt;
+  TrackInternal bestInt(scratch);
+  TrackInternal trk(scratch); // every field is reset per seed pair below
 
   const double z2 = AHCALGeometry::Pos_Z(L2);
 
@@ -285,7 +671,6 @@ bool find_muon_track_kf(const std::vector<AHCALRecoHit>& recoHits,
     for (const auto* h1 : hitsL1) {
       for (const auto* h2 : hitsL2) {
 
-        TrackInternal trk;
         trk.z = z2;
         trk.xv[0] = h2->Xpos();
         trk.xv[1] = h2->Ypos();
@@ -293,12 +678,8 @@ bool find_muon_track_kf(const std::vector<AHCALRecoHit>& recoHits,
         trk.xv[3] = (h2->Ypos() - h1->Ypos()) / dz;
 
         // init covariance
-        for(int i=0;i<4;i++) for(int j=0;j<4;j++) trk.C[i][j]=0.0;
-        trk.C[0][0] = sigma_xy*sigma_xy;
-        trk.C[1][1] = sigma_xy*sigma_xy;
         const double slope0 = 0.05; // 50 mrad prior (loose)
-        trk.C[2][2] = slope0*slope0;
-        trk.C[3][3] = slope0*slope0;
+        trk.C = SymCov4<double>::diag(sigma_xy*sigma_xy, sigma_xy*sigma_xy, slope0*slope0, slope0*slope0);
 
         trk.used.clear();
         trk.used.push_back(h2);
@@ -316,7 +697,7 @@ bool find_muon_track_kf(const std::vector<AHCALRecoHit>& recoHits,
           const double xpred = trk.xv[0];
           const double ypred = trk.xv[1];
 
-          const AHCALRecoHit* hbest = pick_nearest_hit(byLayer[L], xpred, ypred, cfg);
+          const AHCALRecoHit* hbest = pick_nearest_hit(byLayer[L], grid, L, xpred, ypred, cfg);
           if (!hbest) {
             trk.consecutive_skips++;
             if (trk.consecutive_skips > cfg.maxConsecutiveSkips) break;
@@ -349,38 +730,8 @@ bool find_muon_track_kf(const std::vector<AHCALRecoHit>& recoHits,
   if (!found) return false;
 
   // export to public Track
-  bestOut = Track{};
-  bestOut.x  = bestInt.xv[0];
-  bestOut.y  = bestInt.xv[1];
-  bestOut.tx = bestInt.xv[2];
-  bestOut.ty = bestInt.xv[3];
-  bestOut.z  = bestInt.z;
-  bestOut.chi2 = bestInt.chi2;
-  bestOut.ndof = bestInt.ndof;
-  bestOut.consecutive_skips = bestInt.consecutive_skips;
-  bestOut.inTrackHitsIndices.clear();
-  bestOut.outTrackHitsIndices.clear();
-  bestOut.valid = true;
-  for (const auto* h : bestInt.used) {
-    bestOut.inTrackHits.push_back(*h);
-    bestOut.inTrackHitsIndices.push_back(h->index);
-    bestOut.nInTrackHits++;
-  }
-  for (const auto& h : recoHits) {
-    bool used = false;
-    for (const auto* uh : bestInt.used) {
-      if (h.index == uh->index) {
-        used = true;
-        break;
-      }
-    }
-    if (!used) {
-      bestOut.outTrackHits.push_back(h);
-      bestOut.outTrackHitsIndices.push_back(h.index);
-      bestOut.nOutTrackHits++;
-    }
-  }
-
+  export_track(bestOut, bestInt.xv, bestInt.z, bestInt.chi2, bestInt.ndof, bestInt.consecutive_skips,
+               bestInt.used.data(), bestInt.used.size(), recoHits);
   return true;
 }
 
@@ -388,25 +739,35 @@ bool find_muon_track_kf(const std::vector<AHCALRecoHit>& recoHits,
 // MuonKFAlg (RecoAlg-style wrapper)
 // --------------------------------------------
 void MuonKFAlg::execute(EventStore & evt) {
-  auto recohits = evt.get<std::vector<AHCALRecoHit>>(m_cfg.in_recohit_key);
+  const auto& recohits = evt.read<std::vector<AHCALRecoHit>>(m_in_recohit);
+  // filled in place (recycled with its hit vectors); stays Track{} when no track is found
+  Track& trk = evt.make<Track>(m_out_track);
   m_last_found = false;
-  m_last = Track{};
+  m_last.clear();
 
   if (recohits.empty()) {
-    evt.put<Track>(m_cfg.out_track_key, Track{});
     LOG_DEBUG("MuonKFAlg: No input reco hits found.");
     return;
   }
 
-  Track trk;
-  if (find_muon_track_kf(recohits, trk, m_cfg)) {
+  // seed / layer bookkeeping lives in the event arena
+  if (find_muon_track_kf(recohits, trk, m_cfg, &evt.arena())) {
     m_last_found = true;
-    m_last = std::move(trk);
-    evt.put<Track>(m_cfg.out_track_key, m_last);
+    // fit parameters only: the hit lists stay in the event's Track, no per-event copy
+    m_last.x = trk.x;
+    m_last.y = trk.y;
+    m_last.tx = trk.tx;
+    m_last.ty = trk.ty;
+    m_last.z = trk.z;
+    m_last.chi2 = trk.chi2;
+    m_last.ndof = trk.ndof;
+    m_last.consecutive_skips = trk.consecutive_skips;
+    m_last.valid = trk.valid;
+    m_last.nInTrackHits = trk.nInTrackHits;
+    m_last.nOutTrackHits = trk.nOutTrackHits;
   }else{
-    trk = Track{};
+    trk.clear();
     m_last_found = false;
-    evt.put<Track>(m_cfg.out_track_key, Track{});
   }
 }
 
@@ -424,7 +785,11 @@ void MuonKFAlg::parse_cfg(const YAML::Node& n) {
   m_cfg.gateD2 = get_or<double>(n, "gateD2", m_cfg.gateD2);
   m_cfg.seedLayerGap = get_or<int>(n, "seedLayerGap", m_cfg.seedLayerGap);
   m_cfg.maxSeedHitsPerLayer = get_or<int>(n, "maxSeedHitsPerLayer", m_cfg.maxSeedHitsPerLayer);
+  m_cfg.batchSeeds = get_or<bool>(n, "batchSeeds", m_cfg.batchSeeds);
+  m_cfg.hitGrid = get_or<bool>(n, "hitGrid", m_cfg.hitGrid);
   std::vector<int> skipLayers = get_or<std::vector<int>>(n, "skipLayers", {0,2,14});
   m_cfg.skipLayer = parse_skip_layers(skipLayers);
+  m_in_recohit = EventKeyRegistry::instance().intern(m_cfg.in_recohit_key);
+  m_out_track = EventKeyRegistry::instance().intern(m_cfg.out_track_key);
 }
 } // namespace AHCALRecoAlg
@@ -1,5 +1,6 @@
 #pragma once
 #include <bitset>
+#include <memory_resource>
 #include <string>
 #include <vector>
 #include <yaml-cpp/yaml.h>
@@ -24,6 +25,7 @@ namespace AHCALRecoAlg {
         bool   useNmipWindow = true;
         double nmipMin = 0.2;
         double nmipMax = 3.0;
+        bool   hitGrid = true;         // one-by-one search: look up hits of busy layers in a per-event 18x18 tile grid (same result as a scan)
 
         // measurement resolution (mm). If <=0, defaults to pitch/sqrt(12)
         double measSigmaXY_mm = 0.0;
@@ -37,15 +39,17 @@ namespace AHCALRecoAlg {
         // seeding
         int seedLayerGap = 4;          // choose two seed layers separated by >= gap
         int maxSeedHitsPerLayer = 8;   // keep top-K candidate hits per layer for seeds
+        bool batchSeeds = false;       // filter all seed pairs together (SoA lanes) instead of one by one
 
         // skip layer mask (欠損レイヤー等)
         std::bitset<40> skipLayer;
     };
 
-    // Run KF muon tagging on a single event
+    // Run KF muon tagging on a single event; temporaries are allocated from `scratch` (e.g. the event arena)
     bool find_muon_track_kf(const std::vector<AHCALRecoHit>& recoHits,
                             Track& bestOut,
-                            const MuonKFAlgCfg& cfg);
+                            const MuonKFAlgCfg& cfg,
+                            std::pmr::memory_resource* scratch = std::pmr::get_default_resource());
 
 
     class MuonKFAlg final : public IAlg {
@@ -53,6 +57,8 @@ namespace AHCALRecoAlg {
         MuonKFAlg(RunContext& ctx, std::string name) 
             : IAlg(ctx, std::move(name)) {}
         void parse_cfg(const YAML::Node& n) override;
+        std::vector<std::string> inputs() const override { return {m_cfg.in_recohit_key}; }
+        std::vector<std::string> outputs() const override { return {m_cfg.out_track_key}; }
         MuonKFAlgCfg& config() { return m_cfg; }
         const MuonKFAlgCfg& config() const { return m_cfg; }
 
@@ -60,6 +66,7 @@ namespace AHCALRecoAlg {
         void execute(EventStore& evt) override;
 
         // (optional) expose result (or you can evt.put it in cpp)
+        // fit parameters and hit counts of the last event's track; its hit lists are only in the EventStore
         const Track& last_track() const { return m_last; }
         bool last_found() const { return m_last_found; }
 
@@ -67,8 +74,10 @@ namespace AHCALRecoAlg {
         // std::string m_in_recohit_key;
         // std::string m_out_track_key;
         MuonKFAlgCfg m_cfg;
+        EventKey m_in_recohit; // handles of the cfg keys, resolved in parse_cfg
+        EventKey m_out_track;
 
-        // cache last result
+        // cache last result (scalar fields only)
         Track m_last;
         bool m_last_found = false;
     };
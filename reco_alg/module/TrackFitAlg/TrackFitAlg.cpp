@@ -1,73 +1,56 @@
 #include "TrackFitAlg.hpp"
-#include <TGraphErrors.h>
-#include <TF1.h>
 #include "common/config/YAMLUtil.hpp"
 #include "common/edm/EDM.hpp"
 #include "common/AlgRegistry.hpp"
 AHCAL_REGISTER_ALG(AHCALRecoAlg::TrackFitAlg, "TrackFitAlg")
 namespace AHCALRecoAlg {
     void TrackFitAlg::execute(EventStore& evt) {
-        std::string m_in_recohit_key = m_cfg.in_recohit_key;
-        std::string m_out_track_key = m_cfg.out_track_key;
         double threshold_xy = m_cfg.threshold_xy;
-        auto recohits = evt.get<std::vector<AHCALRecoHit>>(m_in_recohit_key);
+        const auto recohits = evt.view<AHCALRecoHit>(m_in_recohit);
+        // filled in place: the track of the previous event is recycled with its hit vectors
+        SimpleFittedTrack& track = evt.make<SimpleFittedTrack>(m_out_track);
         if (recohits.empty()) {
             // throw std::runtime_error("TrackFitAlg: No input reco hits found");
             // LOG_WARN("TrackFitAlg: No input reco hits found.");
             LOG_DEBUG("TrackFitAlg: No input reco hits found.");
-            SimpleFittedTrack empty_track;
-            empty_track.valid = false;
-            evt.put(m_out_track_key, std::move(empty_track));
+            track.valid = false;
             return;
         }
-        std::unique_ptr<TGraphErrors> graph_xz = std::make_unique<TGraphErrors>();
-        std::unique_ptr<TGraphErrors> graph_yz = std::make_unique<TGraphErrors>();
-        SimpleFittedTrack track;
+        m_z.clear();
+        m_x.clear();
+        m_y.clear();
         for (const auto& hit : recohits) {
             if (hit.Nmip <0.5) continue; // MIP cut
             track.nTotalHits++;
-            double x = hit.Xpos();
-            double y = hit.Ypos();
-            double z = hit.Zpos();
-            int index = graph_xz->GetN();
-            graph_xz->SetPoint(index, z, x);
-            graph_yz->SetPoint(index, z, y);
-            graph_xz->SetPointError(index, AHCALGeometry::z_size/2, AHCALGeometry::xy_size/2);
-            graph_yz->SetPointError(index, AHCALGeometry::z_size/2, AHCALGeometry::xy_size/2);
+            const AHCALGeometry::CellPosition pos = AHCALGeometry::CellPos(hit.cellID);
+            m_z.push_back(pos.z);
+            m_x.push_back(pos.x);
+            m_y.push_back(pos.y);
         }
         if (track.nTotalHits < 3){
             LOG_DEBUG("TrackFitAlg: Not enough hits to fit a track. Hits found: {}", track.nTotalHits);
-            evt.put(m_out_track_key, std::move(track));
             return; // Not enough hits to fit
         }
-        track.valid = true;
-        // Fit lines
-        auto pol1_x = std::make_unique<TF1>("pol1_x", "[0] + [1]*x");
-        auto pol1_y = std::make_unique<TF1>("pol1_y", "[0] + [1]*x");
-        pol1_x->SetParLimits(1, -20, 20); // Limit slope to reasonable values
-        pol1_y->SetParLimits(1, -20, 20);
-        graph_xz->Fit("pol1_x", "Q"); // "Q" for quiet mode
-        graph_yz->Fit("pol1_y", "Q");
-        if (graph_xz->GetFunction("pol1_x") == nullptr || graph_yz->GetFunction("pol1_y") == nullptr) {
+        m_w.assign(m_z.size(), 1.0);
+        LineFitResult line_x, line_y;
+        if (fit_lines(line_x, line_y) && m_robust != Robust::None) robust_refit(line_x, line_y);
+        if (!line_x.ok || !line_y.ok) {
             LOG_WARN("TrackFitAlg: Fit failed.");
             track.valid = false;
-            evt.put(m_out_track_key, std::move(track));
             return;
         }
-            
-        // Extract fit parameters
-        double p0_x = graph_xz->GetFunction("pol1_x")->GetParameter(0);
-        double p1_x = graph_xz->GetFunction("pol1_x")->GetParameter(1);
-        double p0_y = graph_yz->GetFunction("pol1_y")->GetParameter(0);
-        double p1_y = graph_yz->GetFunction("pol1_y")->GetParameter(1);
-        // Create Track object
+        track.valid = true;
+        double p0_x = line_x.intercept;
+        double p1_x = line_x.slope;
+        double p0_y = line_y.intercept;
+        double p1_y = line_y.slope;
         track.init_pos_x = p0_x;
         track.init_pos_y = p0_y;
         track.direction_x = p1_x;
         track.direction_y = p1_y;
-        track.chi2_x = graph_xz->GetFunction("pol1_x")->GetChisquare();
-        track.chi2_y = graph_yz->GetFunction("pol1_y")->GetChisquare();
-        track.ndf = graph_xz->GetFunction("pol1_x")->GetNDF();
+        track.chi2_x = line_x.chi2;
+        track.chi2_y = line_y.chi2;
+        track.ndf = line_x.ndf;
         // Classify hits
         int index = 0;
         for (const auto& hit : recohits) {
@@ -84,13 +67,76 @@ namespace AHCALRecoAlg {
             }
             index++;
         }
-        // Store track
-        evt.put(m_out_track_key, std::move(track));
     }
+    bool TrackFitAlg::fit_lines(LineFitResult& line_x, LineFitResult& line_y) const {
+        // x(z) and y(z) lines with the hit size as errors (tile half-width in x/y, half-thickness in z),
+        // slope limited to +-20; same chi2 as a TGraphErrors fit, in closed form
+        LineFit fit_xz(AHCALGeometry::z_size/2, AHCALGeometry::xy_size/2, 20.0);
+        LineFit fit_yz(AHCALGeometry::z_size/2, AHCALGeometry::xy_size/2, 20.0);
+        for (std::size_t i = 0; i < m_z.size(); ++i) {
+            fit_xz.add(m_z[i], m_x[i], m_w[i]);
+            fit_yz.add(m_z[i], m_y[i], m_w[i]);
+        }
+        line_x = fit_xz.solve();
+        line_y = fit_yz.solve();
+        return line_x.ok && line_y.ok;
+    }
+
+    void TrackFitAlg::robust_refit(LineFitResult& line_x, LineFitResult& line_y) {
+        const double inv_cut2 = 1.0 / (m_cfg.robust_cut * m_cfg.robust_cut);
+        int pass = 0;
+        for (; pass < m_cfg.robust_passes; ++pass) {
+            m_w_next.resize(m_z.size());
+            int n_used = 0;
+            bool changed = false;
+            for (std::size_t i = 0; i < m_z.size(); ++i) {
+                const double dx = m_x[i] - (line_x.intercept + line_x.slope * m_z[i]);
+                const double dy = m_y[i] - (line_y.intercept + line_y.slope * m_z[i]);
+                const double u2 = (dx * dx + dy * dy) * inv_cut2;
+                double w = 0.0;
+                if (u2 < 1.0) w = (m_robust == Robust::Trim) ? 1.0 : (1.0 - u2) * (1.0 - u2);
+                if (w > 0.0) ++n_used;
+                changed = changed || w != m_w[i];
+                m_w_next[i] = w;
+            }
+            if (!changed || n_used < 3) break; // settled, or too few hits left to refit: keep the last fit
+            m_w.swap(m_w_next);
+            LineFitResult next_x, next_y;
+            if (!fit_lines(next_x, next_y)) break;
+            const bool converged = std::abs(next_x.intercept - line_x.intercept) < 1e-3 &&
+                                   std::abs(next_y.intercept - line_y.intercept) < 1e-3 &&
+                                   std::abs(next_x.slope - line_x.slope) < 1e-6 &&
+                                   std::abs(next_y.slope - line_y.slope) < 1e-6;
+            line_x = next_x;
+            line_y = next_y;
+            if (converged) {
+                ++pass;
+                break;
+            }
+        }
+        LOG_DEBUG("TrackFitAlg: robust fit after {} refits, ndf={}", pass, line_x.ndf);
+    }
+
     void TrackFitAlg::parse_cfg(const YAML::Node& n) {
         m_cfg.in_recohit_key = get_or<std::string>(n, "in_recohit_key", m_cfg.in_recohit_key);
         m_cfg.out_track_key = get_or<std::string>(n, "out_track_key", m_cfg.out_track_key);
         m_cfg.threshold_xy = get_or<double>(n, "threshold_xy", m_cfg.threshold_xy);
+        m_cfg.robust = get_or<std::string>(n, "robust", m_cfg.robust);
+        m_cfg.robust_passes = get_or<int>(n, "robust_passes", m_cfg.robust_passes);
+        m_cfg.robust_cut = get_or<double>(n, "robust_cut", m_cfg.robust_cut);
+        if (m_cfg.robust == "none") m_robust = Robust::None;
+        else if (m_cfg.robust == "irls") m_robust = Robust::IRLS;
+        else if (m_cfg.robust == "trim") m_robust = Robust::Trim;
+        else {
+            LOG_ERROR("TrackFitAlg: unknown robust mode '{}' (none | irls | trim)", m_cfg.robust);
+            throw std::runtime_error("TrackFitAlg: unknown robust mode: " + m_cfg.robust);
+        }
+        if (m_robust != Robust::None && !(m_cfg.robust_cut > 0.0)) {
+            LOG_ERROR("TrackFitAlg: robust_cut must be positive (got {})", m_cfg.robust_cut);
+            throw std::runtime_error("TrackFitAlg: invalid robust_cut");
+        }
+        m_in_recohit = EventKeyRegistry::instance().intern(m_cfg.in_recohit_key);
+        m_out_track = EventKeyRegistry::instance().intern(m_cfg.out_track_key);
     }
 }
 
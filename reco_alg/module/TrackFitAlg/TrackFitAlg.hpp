@@ -3,6 +3,7 @@
 #include "common/EventStore.hpp"
 #include "common/IAlg.hpp"
 #include "common/edm/EDM.hpp"
+#include "reco_alg/fit/LineFit.hpp"
 #include <yaml-cpp/yaml.h>
 #include <string>
 #include <memory>
@@ -15,6 +16,9 @@ namespace AHCALRecoAlg {
         std::string in_recohit_key = "RecoHits";
         std::string out_track_key = "FittedTrack";
         double threshold_xy = 40./2;
+        std::string robust = "none"; // none | irls (Tukey biweight) | trim (drop hits beyond robust_cut)
+        int robust_passes = 5;       // maximum number of refits after the first fit
+        double robust_cut = 60.;     // mm, transverse distance beyond which a hit gets weight 0
     };
 
     class TrackFitAlg final : public IAlg { // final to prevent inheritance
@@ -24,11 +28,23 @@ namespace AHCALRecoAlg {
 
         void execute(EventStore& evt) override;
         void parse_cfg(const YAML::Node& n) override;
+        std::vector<std::string> inputs() const override { return {m_cfg.in_recohit_key}; }
+        std::vector<std::string> outputs() const override { return {m_cfg.out_track_key}; }
         void setThresholdXY(double threshold) {
             m_cfg.threshold_xy = threshold;
         }
     private:
+        enum class Robust { None, IRLS, Trim };
+        // fit both projections of the projected hits with the weights in m_w
+        bool fit_lines(LineFitResult& line_x, LineFitResult& line_y) const;
+        // refit with hit weights from the residuals of the previous fit until the weights settle
+        void robust_refit(LineFitResult& line_x, LineFitResult& line_y);
         TrackFitAlgCfg m_cfg;
+        Robust m_robust = Robust::None;
+        // hits passing the MIP cut projected to (z, x, y) and their fit weights, reused across events
+        std::vector<double> m_z, m_x, m_y, m_w, m_w_next;
+        EventKey m_in_recohit; // handles of the cfg keys, resolved in parse_cfg
+        EventKey m_out_track;
     };
 
 } // namespace AHCALRecoAlg
@@ -0,0 +1,96 @@
+// ADC-to-energy kernels: the AVX2 kernel must reproduce the scalar one bit for bit, for every event size
+// (full 4-hit blocks and the tail), hits outside the detector, both sides of the gain switch, negative
+// energies, and degenerate constants (MIP 0, NaN gain ratio). Skipped on CPUs without AVX2.
+#include "adc_to_energy/AdcToEnergyKernel.hpp"
+#include "calibration/RefValues.hpp"
+#include "common/Logger.hpp"
+#include "tests/TestUtil.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace AHCALRecoAlg;
+
+namespace {
+
+void fill_table(AHCALCalib::CalibTable& calib, std::mt19937& rng) {
+  for (int i = 0; i < calib.size(); ++i) {
+    auto& c = calib[i];
+    c.mip = rng() % 17 == 0 ? 0.0 : 250.0 + (rng() % 2000) / 10.0;
+    c.hg_ped = 350.0 + (rng() % 1000) / 20.0;
+    c.lg_ped = 350.0 + (rng() % 1000) / 20.0;
+    c.gain_ratio = rng() % 13 == 0 ? std::numeric_limits<double>::quiet_NaN() : 20.0 + (rng() % 1000) / 100.0;
+    c.gain_plat = 1800 + static_cast<int>(rng() % 400);
+  }
+}
+
+int compare(const AHCALCalib::CalibTable& calib, const std::vector<int>& idx, const std::vector<int>& hg,
+            const std::vector<int>& lg) {
+  const std::size_t n = idx.size();
+  std::vector<double> nmip_s(n, -1.0), edep_s(n, -1.0), nmip_v(n, -2.0), edep_v(n, -2.0);
+  const AdcHitsSoA hits{idx.data(), hg.data(), lg.data(), n};
+  adc_to_energy_scalar(calib, hits, nmip_s.data(), edep_s.data());
+  adc_to_energy_avx2(calib, hits, nmip_v.data(), edep_v.data());
+  int bad = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    if (std::memcmp(&nmip_s[i], &nmip_v[i], sizeof(double)) != 0 || std::memcmp(&edep_s[i], &edep_v[i], sizeof(double)) != 0) {
+      ++bad;
+    }
+  }
+  return bad;
+}
+
+// every event size up to a few blocks, random hits with extreme ADCs and out-of-detector cells mixed in
+void random_events(const AHCALCalib::CalibTable& calib, std::mt19937& rng) {
+  for (int n = 0; n < 70; ++n) {
+    for (int rep = 0; rep < 20; ++rep) {
+      std::vector<int> idx(n), hg(n), lg(n);
+      for (int k = 0; k < n; ++k) {
+        idx[k] = rng() % 8 == 0 ? -1 : static_cast<int>(rng() % static_cast<unsigned>(calib.size()));
+        hg[k] = rng() % 10 == 0 ? 0 : static_cast<int>(rng() % 4096);
+        lg[k] = rng() % 10 == 0 ? 4095 : static_cast<int>(rng() % 4096);
+      }
+      FAIR_CHECK(compare(calib, idx, hg, lg) == 0);
+    }
+  }
+}
+
+// HG just below, at and above the switch point of each cell, and ADCs below the pedestals (clamped to 0)
+void gain_switch(const AHCALCalib::CalibTable& calib) {
+  std::vector<int> idx, hg, lg;
+  for (int i = 0; i < calib.size(); ++i) {
+    const auto& c = calib[i];
+    const int sw = static_cast<int>(std::floor(c.hg_ped + c.gain_plat - AHCALRefValues::SwitchPoint));
+    for (const int d : {-2, -1, 0, 1, 2}) {
+      idx.push_back(i);
+      hg.push_back(sw + d);
+      lg.push_back(static_cast<int>(c.lg_ped) + 3 * d);
+    }
+    idx.push_back(i);
+    hg.push_back(static_cast<int>(c.hg_ped) - 5);
+    lg.push_back(0);
+  }
+  FAIR_CHECK(compare(calib, idx, hg, lg) == 0);
+}
+
+} // namespace
+
+int main() {
+  FAIR::set_level(spdlog::level::warn);
+  if (!avx2_supported()) {
+    std::cout << "test_adc_kernel: no AVX2 on this CPU, skipped" << std::endl;
+    return FairTest::kSkip;
+  }
+  FAIR_CHECK(select_adc_kernel(AdcToEnergyKernel::Auto) == &adc_to_energy_avx2);
+  FAIR_CHECK(select_adc_kernel(AdcToEnergyKernel::Scalar) == &adc_to_energy_scalar);
+
+  std::mt19937 rng(20240601);
+  AHCALCalib::CalibTable calib;
+  fill_table(calib, rng);
+  random_events(calib, rng);
+  gain_switch(calib);
+  return FairTest::result("test_adc_kernel");
+}
@@ -0,0 +1,228 @@
+// AlgScheduler: the dependency graph built from inputs()/outputs(), the per-event countdown over many
+// events on a shared TaskPool, several schedulers (workers) sharing one pool, exception propagation, and
+// destroying a scheduler right after execute().
+#include "common/AlgScheduler.hpp"
+#include "common/Logger.hpp"
+#include "common/RunContext.hpp"
+#include "tests/TestUtil.hpp"
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::atomic<long long> g_clock{0};
+
+// outputs = sum of inputs + id; records when it started and finished on the shared clock
+class GraphAlg final : public IAlg {
+public:
+  GraphAlg(RunContext& ctx, std::string name, int id, std::vector<std::string> in, std::vector<std::string> out,
+           long long throwAt = -1)
+    : IAlg(ctx, std::move(name)), m_id(id), m_in(std::move(in)), m_out(std::move(out)), m_throwAt(throwAt) {
+    for (const auto& k : m_in) m_inKeys.push_back(EventKeyRegistry::instance().intern(k));
+    for (const auto& k : m_out) m_outKeys.push_back(EventKeyRegistry::instance().intern(k));
+  }
+  void parse_cfg(const YAML::Node&) override {}
+  std::vector<std::string> inputs() const override { return m_in; }
+  std::vector<std::string> outputs() const override { return m_out; }
+  void execute(EventStore& evt) override {
+    start = g_clock.fetch_add(1);
+    long long sum = m_id;
+    for (const auto k : m_inKeys) sum += evt.read<long long>(k);
+    if (sum - m_id == m_throwAt) throw std::runtime_error(name() + ": requested failure");
+    volatile unsigned x = 0;
+    for (unsigned i = 0; i < 500u * static_cast<unsigned>(m_id % 4 + 1); ++i) x = x + i;
+    for (const auto k : m_outKeys) evt.make<long long>(k) = sum;
+    ++runs;
+    end = g_clock.fetch_add(1);
+  }
+  long long start = -1, end = -1;
+  long long runs = 0;
+
+private:
+  int m_id;
+  std::vector<std::string> m_in, m_out;
+  std::vector<EventKey> m_inKeys, m_outKeys;
+  long long m_throwAt;
+};
+
+using Algs = std::vector<std::unique_ptr<GraphAlg>>;
+
+// A, H roots; B, C, D read a; E joins b and c; W writes c, which E reads (write after read) and C
+// writes (write after write); F declares no keys (barrier); G joins d and e.
+// E throws on the event whose input is throwAt.
+Algs make_algs(RunContext& ctx, long long throwAt = -1) {
+  using V = std::vector<std::string>;
+  Algs a;
+  a.emplace_back(std::make_unique<GraphAlg>(ctx, "A", 1, V{"in"}, V{"a"}));
+  a.emplace_back(std::make_unique<GraphAlg>(ctx, "H", 2, V{"in"}, V{"h"}));
+  a.emplace_back(std::make_unique<GraphAlg>(ctx, "B", 3, V{"a"}, V{"b"}));
+  a.emplace_back(std::make_unique<GraphAlg>(ctx, "C", 4, V{"a"}, V{"c"}));
+  a.emplace_back(std::make_unique<GraphAlg>(ctx, "D", 5, V{"a"}, V{"d"}));
+  a.emplace_back(std::make_unique<GraphAlg>(ctx, "E", 6, V{"b", "c"}, V{"e"}, throwAt));
+  a.emplace_back(std::make_unique<GraphAlg>(ctx, "W", 9, V{"h"}, V{"c"}));
+  a.emplace_back(std::make_unique<GraphAlg>(ctx, "F", 7, V{}, V{}));
+  a.emplace_back(std::make_unique<GraphAlg>(ctx, "G", 8, V{"d", "e"}, V{"g"}));
+  return a;
+}
+
+std::vector<IAlg*> ptrs(const Algs& algs) {
+  std::vector<IAlg*> v;
+  for (const auto& a : algs) v.push_back(a.get());
+  return v;
+}
+
+// i must finish before j starts: the rules documented in AlgScheduler.hpp, restated
+bool must_precede(const GraphAlg& i, const GraphAlg& j) {
+  const auto in_i = i.inputs(), out_i = i.outputs(), in_j = j.inputs(), out_j = j.outputs();
+  if ((in_i.empty() && out_i.empty()) || (in_j.empty() && out_j.empty())) return true;
+  auto overlap = [](const std::vector<std::string>& a, const std::vector<std::string>& b) {
+    for (const auto& x : a)
+      for (const auto& y : b)
+        if (x == y) return true;
+    return false;
+  };
+  return overlap(out_i, in_j) || overlap(in_i, out_j) || overlap(out_i, out_j);
+}
+
+const std::vector<std::string> kKeys = {"a", "b", "c", "d", "e", "g", "h"};
+
+// values of the serial YAML-order run
+std::vector<long long> reference(long long input) {
+  RunContext ctx;
+  Algs algs = make_algs(ctx);
+  AlgScheduler serial(ptrs(algs), nullptr);
+  EventStore evt;
+  evt.put("in", input);
+  serial.execute(evt);
+  std::vector<long long> v;
+  for (const auto& k : kKeys) v.push_back(evt.read<long long>(k));
+  return v;
+}
+
+void check_event(const Algs& algs, const EventStore& evt, const std::vector<long long>& ref) {
+  for (std::size_t k = 0; k < kKeys.size(); ++k) FAIR_CHECK(evt.read<long long>(kKeys[k]) == ref[k]);
+  for (std::size_t j = 0; j < algs.size(); ++j)
+    for (std::size_t i = 0; i < j; ++i)
+      if (must_precede(*algs[i], *algs[j])) FAIR_CHECK(algs[i]->end < algs[j]->start);
+}
+
+void graph_shape() {
+  RunContext ctx;
+  Algs algs = make_algs(ctx);
+  TaskPool pool(2);
+  AlgScheduler serial(ptrs(algs), nullptr);
+  FAIR_CHECK(!serial.parallel());
+  AlgScheduler graph(ptrs(algs), &pool);
+  FAIR_CHECK(graph.parallel());
+  FAIR_CHECK(graph.depth() == 6); // {A,H} {B,C,D} E W F G
+  FAIR_CHECK(graph.width() == 3);
+
+  // a plain chain stays on the serial loop even with a pool
+  using V = std::vector<std::string>;
+  Algs chain;
+  chain.emplace_back(std::make_unique<GraphAlg>(ctx, "X", 1, V{"in"}, V{"x"}));
+  chain.emplace_back(std::make_unique<GraphAlg>(ctx, "Y", 2, V{"x"}, V{"y"}));
+  AlgScheduler c(ptrs(chain), &pool);
+  FAIR_CHECK(!c.parallel());
+  FAIR_CHECK(c.depth() == 2 && c.width() == 1);
+}
+
+// one scheduler reused over many events: the countdown is re-armed every event
+void many_events(std::size_t nThreads) {
+  RunContext ctx;
+  Algs algs = make_algs(ctx);
+  TaskPool pool(nThreads);
+  AlgScheduler graph(ptrs(algs), &pool);
+  EventStore evt;
+  for (long long e = 0; e < 5000; ++e) {
+    evt.put("in", e);
+    graph.execute(evt);
+    check_event(algs, evt, reference(e));
+    evt.clear();
+  }
+  for (const auto& a : algs) FAIR_CHECK(a->runs == 5000);
+}
+
+// event-level workers, each with its own chain and scheduler, on one shared pool
+void shared_pool(std::size_t nWorkers, std::size_t nThreads) {
+  TaskPool pool(nThreads);
+  std::vector<long long> ref[4];
+  for (long long e = 0; e < 4; ++e) ref[e] = reference(e);
+  std::vector<std::thread> workers;
+  for (std::size_t w = 0; w < nWorkers; ++w) {
+    workers.emplace_back([&, w] {
+      RunContext ctx;
+      Algs algs = make_algs(ctx);
+      AlgScheduler graph(ptrs(algs), &pool);
+      EventStore evt;
+      for (long long e = 0; e < 2000; ++e) {
+        const long long input = static_cast<long long>(w + e) % 4;
+        evt.put("in", input);
+        graph.execute(evt);
+        check_event(algs, evt, ref[input]);
+        evt.clear();
+      }
+    });
+  }
+  for (auto& t : workers) t.join();
+}
+
+// E throws: execute() rethrows after the event drained, algs after E are skipped, the next event is fine
+void exceptions(std::size_t nThreads) {
+  RunContext ctx;
+  Algs algs = make_algs(ctx, 13);
+  TaskPool pool(nThreads);
+  AlgScheduler graph(ptrs(algs), &pool);
+  EventStore evt;
+  for (long long e = 0; e < 200; ++e) {
+    const long long input = e % 20;
+    evt.put("in", input);
+    bool thrown = false;
+    try {
+      graph.execute(evt);
+    } catch (const std::runtime_error& ex) {
+      thrown = std::string(ex.what()) == "E: requested failure";
+    }
+    // E sees b + c = (in + 4) + (in + 5)
+    const bool fails = 2 * input + 9 == 13;
+    FAIR_CHECK(thrown == fails);
+    if (fails) FAIR_CHECK(!evt.has("e") && !evt.has("g"));
+    else check_event(algs, evt, reference(input));
+    evt.clear();
+  }
+}
+
+// the scheduler (and its countdown state) can go away as soon as execute() returns
+void destroy_after_execute() {
+  RunContext ctx;
+  TaskPool pool(3);
+  for (int r = 0; r < 500; ++r) {
+    Algs algs = make_algs(ctx);
+    auto graph = std::make_unique<AlgScheduler>(ptrs(algs), &pool);
+    EventStore evt;
+    evt.put("in", static_cast<long long>(r));
+    graph->execute(evt);
+    graph.reset();
+    FAIR_CHECK(evt.has("g"));
+  }
+}
+
+} // namespace
+
+int main() {
+  FAIR::set_level(spdlog::level::off); // the exception case logs errors on purpose
+  graph_shape();
+  for (const std::size_t n : {1u, 2u, 4u}) {
+    many_events(n);
+    exceptions(n);
+  }
+  shared_pool(3, 2);
+  shared_pool(4, 4);
+  destroy_after_execute();
+  return FairTest::result("test_alg_scheduler");
+}
@@ -0,0 +1,108 @@
+// BoundedQueue: capacity, FIFO order, close/abort, and multi-producer / multi-consumer delivery of every
+// element exactly once, with each producer's elements arriving in order at every consumer.
+#include "common/BoundedQueue.hpp"
+#include "tests/TestUtil.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+
+void single_thread() {
+  BoundedQueue<int> q(5);
+  FAIR_CHECK(q.capacity() == 8);
+  for (int i = 0; i < 8; ++i) {
+    int v = i;
+    FAIR_CHECK(q.try_push(v));
+  }
+  int extra = 8;
+  FAIR_CHECK(!q.try_push(extra)); // full
+  FAIR_CHECK(q.depth() == 8);
+  for (int i = 0; i < 8; ++i) {
+    int v = -1;
+    FAIR_CHECK(q.try_pop(v) && v == i);
+  }
+  int v = -1;
+  FAIR_CHECK(!q.try_pop(v)); // empty
+
+  // close: pop() drains what is left, then returns false
+  FAIR_CHECK(q.push(1) && q.push(2));
+  q.close();
+  FAIR_CHECK(q.pop(v) && v == 1);
+  FAIR_CHECK(q.pop(v) && v == 2);
+  FAIR_CHECK(!q.pop(v));
+}
+
+void abort_unblocks() {
+  std::atomic<bool> abort{false};
+  BoundedQueue<int> full(2, &abort);
+  FAIR_CHECK(full.push(1) && full.push(2));
+  BoundedQueue<int> empty(2, &abort);
+  std::atomic<int> pushed{-1}, popped{-1};
+  std::thread producer([&] { pushed = full.push(3) ? 1 : 0; });
+  std::thread consumer([&] {
+    int v;
+    popped = empty.pop(v) ? 1 : 0;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  abort.store(true);
+  producer.join();
+  consumer.join();
+  FAIR_CHECK(pushed == 0);
+  FAIR_CHECK(popped == 0);
+}
+
+void mpmc(std::size_t capacity, int nProducers, int nConsumers, int perProducer) {
+  struct Item {
+    int producer = -1;
+    int seq = -1;
+  };
+  BoundedQueue<Item> q(capacity);
+  std::vector<std::vector<Item>> got(nConsumers);
+  std::vector<std::thread> consumers;
+  for (int c = 0; c < nConsumers; ++c) {
+    consumers.emplace_back([&, c] {
+      Item it;
+      while (q.pop(it)) got[c].push_back(it);
+    });
+  }
+  std::vector<std::thread> producers;
+  for (int p = 0; p < nProducers; ++p) {
+    producers.emplace_back([&, p] {
+      for (int i = 0; i < perProducer; ++i) FAIR_CHECK(q.push(Item{p, i}));
+    });
+  }
+  for (auto& t : producers) t.join();
+  q.close();
+  for (auto& t : consumers) t.join();
+
+  std::vector<std::vector<int>> seen(nProducers, std::vector<int>(perProducer, 0));
+  for (const auto& items : got) {
+    std::vector<int> last(nProducers, -1);
+    for (const auto& it : items) {
+      FAIR_CHECK(it.producer >= 0 && it.producer < nProducers && it.seq >= 0 && it.seq < perProducer);
+      if (it.producer < 0 || it.producer >= nProducers || it.seq < 0 || it.seq >= perProducer) continue;
+      FAIR_CHECK(it.seq > last[it.producer]); // FIFO per producer
+      last[it.producer] = it.seq;
+      ++seen[it.producer][it.seq];
+    }
+  }
+  for (const auto& s : seen)
+    for (const int n : s) FAIR_CHECK(n == 1); // every element exactly once
+
+  const auto st = q.stats();
+  FAIR_CHECK(st.pushed == static_cast<unsigned long long>(nProducers) * perProducer);
+  FAIR_CHECK(st.max_depth <= q.capacity());
+}
+
+} // namespace
+
+int main() {
+  single_thread();
+  abort_unblocks();
+  mpmc(2, 1, 1, 100000);
+  mpmc(4, 4, 4, 50000);
+  mpmc(64, 3, 5, 50000);
+  return FairTest::result("test_bounded_queue");
+}
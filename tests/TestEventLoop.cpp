@@ -0,0 +1,207 @@
+// EventLoop: serial and pipelined runs over cloned worker chains. Checks that every event reaches the
+// sink exactly once, in input order when ordered, that the reader throttle bounds the events in flight,
+// that EventStores are recycled, and that an exception in any stage ends run() with that exception.
+#include "common/EventLoop.hpp"
+#include "common/Logger.hpp"
+#include "common/RunContext.hpp"
+#include "tests/TestUtil.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// out = in + add, after a pseudo-random delay so that events overtake each other between workers
+class AddAlg final : public IAlg {
+public:
+  AddAlg(RunContext& ctx, std::string in, std::string out, int add, long long throwAt = -1)
+    : IAlg(ctx, "AddAlg"), m_in(std::move(in)), m_out(std::move(out)), m_add(add), m_throwAt(throwAt),
+      m_inKey(EventKeyRegistry::instance().intern(m_in)), m_outKey(EventKeyRegistry::instance().intern(m_out)) {}
+  void parse_cfg(const YAML::Node&) override {}
+  std::vector<std::string> inputs() const override { return {m_in}; }
+  std::vector<std::string> outputs() const override { return {m_out}; }
+  void execute(EventStore& evt) override {
+    const long long v = evt.read<long long>(m_inKey);
+    if (v == m_throwAt) throw std::runtime_error("AddAlg: requested failure");
+    const unsigned spin = static_cast<unsigned>((v * 2654435761u) % 2000u);
+    volatile unsigned x = 0;
+    for (unsigned i = 0; i < spin; ++i) x = x + i;
+    if (v % 97 == 0) std::this_thread::sleep_for(std::chrono::microseconds(300)); // a straggler
+    evt.make<long long>(m_outKey) = v + m_add;
+  }
+
+private:
+  std::string m_in, m_out;
+  int m_add;
+  long long m_throwAt;
+  EventKey m_inKey, m_outKey;
+};
+
+// non-cloneable: records what reaches the output stage
+class SinkAlg final : public IAlg {
+public:
+  SinkAlg(RunContext& ctx, std::string in) : IAlg(ctx, "SinkAlg"), m_in(std::move(in)), m_key(EventKeyRegistry::instance().intern(m_in)) {}
+  void parse_cfg(const YAML::Node&) override {}
+  bool cloneable() const override { return false; }
+  std::vector<std::string> inputs() const override { return {m_in}; }
+  void execute(EventStore& evt) override {
+    seen.push_back(evt.read<long long>(m_key));
+    sunk.fetch_add(1, std::memory_order_release);
+  }
+  std::vector<long long> seen;
+  std::atomic<long long> sunk{0};
+
+private:
+  std::string m_in;
+  EventKey m_key;
+};
+
+PipelineStages make_stages(RunContext& ctx, std::size_t nWorkers, std::size_t nAlgThreads, long long throwAt,
+                           SinkAlg*& sink) {
+  PipelineStages st;
+  st.workers.resize(nWorkers);
+  for (auto& w : st.workers) {
+    w.emplace_back(std::make_unique<AddAlg>(ctx, "in", "a", 1, throwAt));
+    w.emplace_back(std::make_unique<AddAlg>(ctx, "a", "b", 10));
+    w.emplace_back(std::make_unique<AddAlg>(ctx, "a", "c", 100));
+    w.emplace_back(std::make_unique<AddAlg>(ctx, "b", "d", 1000));
+  }
+  auto s = std::make_unique<SinkAlg>(ctx, "d");
+  sink = s.get();
+  st.sink.emplace_back(std::move(s));
+  for (auto& a : st.workers[0]) st.sequence.push_back(a.get());
+  st.sequence.push_back(sink);
+  if (nAlgThreads > 1) st.pool = std::make_unique<TaskPool>(nAlgThreads);
+  st.serial_graph = AlgScheduler(st.sequence, st.pool.get());
+  for (auto& chain : st.workers) {
+    std::vector<IAlg*> algs;
+    for (auto& a : chain) algs.push_back(a.get());
+    st.graphs.emplace_back(std::move(algs), st.pool.get());
+  }
+  return st;
+}
+
+void run_case(std::size_t nWorkers, std::size_t nAlgThreads, bool pipelined, bool ordered, std::size_t depth) {
+  const long long nEvents = 3000;
+  RunContext ctx;
+  SinkAlg* sink = nullptr;
+  PipelineStages st = make_stages(ctx, nWorkers, nAlgThreads, -1, sink);
+  EventLoopOptions opt;
+  opt.pipelined = pipelined;
+  opt.ordered = ordered;
+  opt.queueDepth = depth;
+  EventLoop loop(st, opt);
+
+  const EventKey in = EventKeyRegistry::instance().intern("in");
+  const EventKey a = EventKeyRegistry::instance().intern("a");
+  long long next = 0;
+  long long maxAhead = 0;
+  const long long n = loop.run([&](EventStore& evt) {
+    if (next >= nEvents) return false;
+    FAIR_CHECK(!evt.has(in) && !evt.has(a)); // recycled stores come back cleared
+    maxAhead = std::max(maxAhead, next - sink->sunk.load(std::memory_order_acquire));
+    evt.put(in, next++);
+    return true;
+  });
+  FAIR_CHECK(n == nEvents);
+  FAIR_CHECK(static_cast<long long>(sink->seen.size()) == nEvents);
+
+  std::vector<long long> got = sink->seen;
+  if (!ordered) std::sort(got.begin(), got.end());
+  bool inOrder = got.size() == static_cast<std::size_t>(nEvents);
+  for (std::size_t i = 0; inOrder && i < got.size(); ++i) inOrder = got[i] == static_cast<long long>(i) + 1011;
+  FAIR_CHECK(inOrder);
+
+  if (pipelined || nWorkers > 1) {
+    const std::size_t d = depth > 0 ? depth : 4 * nWorkers;
+    const auto maxInFlight = static_cast<long long>(2 * d + nWorkers);
+    FAIR_CHECK(loop.stats().input.pushed == static_cast<unsigned long long>(nEvents));
+    // EventStores are recycled: bounded by the queues, the workers and the one being filled, not by nEvents
+    FAIR_CHECK(loop.stats().event_stores <= loop.stats().input.capacity + loop.stats().output.capacity + nWorkers + 2);
+    if (ordered) {
+      // reader throttle: event s is read only once event s - maxInFlight has left the sink
+      FAIR_CHECK(maxAhead <= maxInFlight);
+      FAIR_CHECK(static_cast<long long>(loop.stats().max_reorder) <= maxInFlight);
+    }
+  }
+}
+
+void exception_case(std::size_t nWorkers, bool pipelined, int where) {
+  RunContext ctx;
+  SinkAlg* sink = nullptr;
+  PipelineStages st = make_stages(ctx, nWorkers, nWorkers > 1 ? 3 : 1, where == 1 ? 500 : -1, sink);
+  EventLoopOptions opt;
+  opt.pipelined = pipelined;
+  EventLoop loop(st, opt);
+  const EventKey in = EventKeyRegistry::instance().intern("in");
+  long long next = 0;
+  bool thrown = false;
+  try {
+    loop.run([&](EventStore& evt) {
+      if (next >= 5000) return false;
+      if (where == 0 && next == 700) throw std::runtime_error("source: requested failure");
+      evt.put(in, next++);
+      return true;
+    });
+  } catch (const std::runtime_error& e) {
+    thrown = std::string(e.what()).find("requested failure") != std::string::npos;
+  }
+  FAIR_CHECK(thrown);
+}
+
+// PipelineStages::initialize(): job state is built by worker 0 only and handed to the other workers' copies
+class SharedStateAlg final : public IAlg {
+public:
+  explicit SharedStateAlg(RunContext& ctx) : IAlg(ctx, "SharedStateAlg") {}
+  void parse_cfg(const YAML::Node&) override {}
+  void execute(EventStore&) override {}
+  void initialize() override {
+    ++loads;
+    state = std::make_shared<const int>(42);
+  }
+  void initialize_clone(const IAlg& first) override { state = static_cast<const SharedStateAlg&>(first).state; }
+  static inline int loads = 0;
+  std::shared_ptr<const int> state;
+};
+
+void initialize_clones(std::size_t nWorkers) {
+  RunContext ctx;
+  SinkAlg* sink = nullptr;
+  PipelineStages st = make_stages(ctx, nWorkers, 1, -1, sink);
+  for (auto& w : st.workers) w.emplace_back(std::make_unique<SharedStateAlg>(ctx));
+  SharedStateAlg::loads = 0;
+  st.initialize();
+  FAIR_CHECK(SharedStateAlg::loads == 1);
+  const auto& first = static_cast<const SharedStateAlg&>(*st.workers[0].back());
+  for (auto& w : st.workers) FAIR_CHECK(static_cast<const SharedStateAlg&>(*w.back()).state == first.state);
+}
+
+} // namespace
+
+int main() {
+  FAIR::set_level(spdlog::level::off); // the exception cases log errors on purpose
+  run_case(1, 1, false, true, 0);  // serial loop
+  run_case(1, 3, false, true, 0);  // serial loop, algs of an event in parallel
+  run_case(1, 1, true, true, 0);   // staged, one worker
+  for (const std::size_t w : {2u, 4u}) {
+    for (const std::size_t d : {0u, 1u, 3u}) { // 1: the throttle, not the queues, limits the reader
+      run_case(w, 1, true, true, d);
+      run_case(w, 1, true, false, d);
+    }
+    run_case(w, 3, true, true, 0);
+  }
+  for (const int where : {0, 1}) {
+    exception_case(1, false, where);
+    exception_case(1, true, where);
+    exception_case(4, true, where);
+  }
+  initialize_clones(1);
+  initialize_clones(4);
+  return FairTest::result("test_event_loop");
+}
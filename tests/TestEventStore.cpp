@@ -0,0 +1,107 @@
+// EventStore: slot lookup by EventKey, keys registered after the store was sized, payload recycling across
+// clear(), and the concurrent pattern of AlgScheduler: algs of one event filling distinct keys and reading
+// the keys of their parents from several threads, on a store reused over many events.
+#include "common/EventStore.hpp"
+#include "common/Logger.hpp"
+#include "tests/TestUtil.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+EventKey key(const std::string& name) { return EventKeyRegistry::instance().intern(name); }
+
+template <class Fn>
+bool throws(Fn&& fn) {
+  try {
+    fn();
+  } catch (const std::runtime_error&) {
+    return true;
+  }
+  return false;
+}
+
+void single_thread() {
+  const EventKey a = key("es.a");
+  EventStore s;
+  s.make<std::vector<int>>(a).assign({1, 2, 3});
+  FAIR_CHECK(s.view<int>(a).size() == 3 && s.view<int>("es.a")[2] == 3); // handle and string agree
+
+  // put() keeps an existing entry, set() overwrites
+  s.put("es.d", 1.0);
+  s.put("es.d", 2.0);
+  FAIR_CHECK(s.read<double>("es.d") == 1.0);
+  s.set("es.d", 3.0);
+  FAIR_CHECK(s.read<double>("es.d") == 3.0);
+
+  // missing keys and type mismatches throw, try_get returns nullptr
+  FAIR_CHECK(throws([&] { (void)s.read<int>("es.d"); }));
+  FAIR_CHECK(throws([&] { (void)s.read<int>("es.never_registered"); }));
+  FAIR_CHECK(throws([&] { (void)s.read<int>(key("es.registered_not_filled")); }));
+  FAIR_CHECK(s.try_get<int>("es.d") == nullptr && s.try_get<double>("es.d") != nullptr);
+
+  // a key registered after the store was sized gets its slot on first use; earlier references stay valid
+  const auto* before = &s.read<std::vector<int>>(a);
+  for (int i = 0; i < 200; ++i) s.put(key("es.late" + std::to_string(i)), i);
+  FAIR_CHECK(&s.read<std::vector<int>>(a) == before && s.read<int>("es.late199") == 199);
+  FAIR_CHECK(s.size() == 202);
+  FAIR_CHECK(s.handles().front() == a); // insertion order
+
+  s.erase("es.late5");
+  FAIR_CHECK(!s.has("es.late5") && s.size() == 201);
+
+  // clear(): everything gone, make<T>() hands the previous object back empty with its buffer
+  const int* buffer = s.read<std::vector<int>>(a).data();
+  s.clear();
+  FAIR_CHECK(s.size() == 0 && !s.has(a) && !s.has("es.d"));
+  auto& v = s.make<std::vector<int>>(a);
+  FAIR_CHECK(v.empty() && v.capacity() >= 3 && v.data() == buffer);
+}
+
+// per event: nThreads "algs" each fill their own keys, reading the event input and their parent's key
+void concurrent(int nThreads, int keysPerThread, int nEvents) {
+  const EventKey in = key("es.in");
+  std::vector<std::vector<EventKey>> keys(nThreads);
+  for (int t = 0; t < nThreads; ++t)
+    for (int k = 0; k < keysPerThread; ++k) keys[t].push_back(key("es.t" + std::to_string(t) + "." + std::to_string(k)));
+
+  EventStore s;
+  for (int e = 0; e < nEvents; ++e) {
+    s.put(in, e);
+    std::vector<std::thread> algs;
+    for (int t = 0; t < nThreads; ++t) {
+      algs.emplace_back([&, t] {
+        for (int k = 0; k < keysPerThread; ++k) {
+          const int input = s.read<int>(in);
+          const int parent = k == 0 ? 0 : s.view<int>(keys[t][k - 1])[0];
+          auto& out = s.make<std::vector<int>>(keys[t][k]);
+          out.push_back(input + parent + t);
+          FAIR_CHECK(s.has(keys[t][k]) && !s.has(key("es.registered_not_filled")));
+        }
+      });
+    }
+    for (auto& th : algs) th.join();
+
+    FAIR_CHECK(s.size() == static_cast<std::size_t>(nThreads * keysPerThread + 1));
+    for (int t = 0; t < nThreads; ++t) {
+      for (int k = 0; k < keysPerThread; ++k) {
+        const auto out = s.view<int>(keys[t][k]);
+        FAIR_CHECK(out.size() == 1 && out[0] == (k + 1) * (e + t));
+      }
+    }
+    s.clear();
+  }
+}
+
+} // namespace
+
+int main() {
+  FAIR::set_level(spdlog::level::off); // the missing-key checks log errors on purpose
+  single_thread();
+  concurrent(8, 8, 200);
+  concurrent(3, 40, 100);
+  return FairTest::result("test_event_store");
+}
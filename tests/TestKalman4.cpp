@@ -0,0 +1,219 @@
+// Kalman4 kernels: run lane-wise on GCC/Clang vector types (one track per lane, gating as a mask, as in
+// MuonKFAlg's batched seed search) they must reproduce the scalar kf4_update_xy() loop bit for bit, in
+// double and float, in 128-bit and (with AVX) 256-bit vectors; the structured kernels must also agree
+// with dense 4x4 algebra. Built with -ffp-contract=off, like MuonKFAlg (see Kalman4.hpp).
+#include "reco_alg/fit/Kalman4.hpp"
+#include "tests/TestUtil.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace AHCALRecoAlg;
+
+namespace {
+
+// 128-bit lanes (SSE2), and 256-bit lanes when the build has AVX (like MuonKFAlg's kSeedLanes)
+typedef double Double2 __attribute__((vector_size(2 * sizeof(double))));
+typedef float Float4 __attribute__((vector_size(4 * sizeof(float))));
+#ifdef __AVX__
+typedef double Double4 __attribute__((vector_size(4 * sizeof(double))));
+typedef float Float8 __attribute__((vector_size(8 * sizeof(float))));
+#endif
+
+template <typename T>
+bool same_bits(T a, T b) { return std::memcmp(&a, &b, sizeof(T)) == 0; }
+
+template <typename T>
+struct Track {
+  T x[4];
+  SymCov4<T> C;
+  T chi2 = 0;
+};
+
+// one step of the filter: transport by dz, then a measurement (mx, my)
+template <typename T>
+struct Step {
+  T dz, q, mx, my;
+};
+
+template <typename T>
+Track<T> start(std::mt19937& rng) {
+  std::uniform_real_distribution<double> u(-1.0, 1.0);
+  Track<T> t;
+  t.x[0] = static_cast<T>(200.0 * u(rng));
+  t.x[1] = static_cast<T>(200.0 * u(rng));
+  t.x[2] = static_cast<T>(0.1 * u(rng));
+  t.x[3] = static_cast<T>(0.1 * u(rng));
+  t.C = SymCov4<T>::diag(static_cast<T>(1e4), static_cast<T>(1e4), static_cast<T>(0.01), static_cast<T>(0.01));
+  return t;
+}
+
+// measurements near the straight line of t, some far off (rejected by the gate); steps of 0 (same layer)
+// and negative dz (upstream filtering)
+template <typename T>
+std::vector<Step<T>> steps(const Track<T>& t, std::mt19937& rng, int n) {
+  std::uniform_real_distribution<double> u(-1.0, 1.0);
+  std::vector<Step<T>> v;
+  double x = static_cast<double>(t.x[0]), y = static_cast<double>(t.x[1]);
+  for (int i = 0; i < n; ++i) {
+    const double dz = rng() % 7 == 0 ? 0.0 : -30.0 * (1 + rng() % 3);
+    x += dz * static_cast<double>(t.x[2]);
+    y += dz * static_cast<double>(t.x[3]);
+    const double off = rng() % 5 == 0 ? 300.0 : 15.0;
+    v.push_back({static_cast<T>(dz), static_cast<T>(1.6e-5 * (1 + rng() % 4)), static_cast<T>(x + off * u(rng)),
+                 static_cast<T>(y + off * u(rng))});
+  }
+  return v;
+}
+
+// the scalar loop: kf4_propagate + kf4_update_xy
+template <typename T>
+std::vector<Track<T>> scalar_run(Track<T> t, const std::vector<Step<T>>& s, T r2, T gate, std::vector<int>& accepted) {
+  std::vector<Track<T>> out;
+  for (const auto& st : s) {
+    kf4_propagate(t.x, t.C, st.dz, st.q);
+    T d2{};
+    const bool ok = kf4_update_xy(t.x, t.C, st.mx, st.my, r2, gate, d2);
+    if (ok) t.chi2 += d2;
+    accepted.push_back(ok ? 1 : 0);
+    out.push_back(t);
+  }
+  return out;
+}
+
+// covariance element m of the N start tracks, one per lane
+template <typename T, typename V, std::size_t N>
+V gather(const Track<T> (&t)[N], T SymCov4<T>::*m) {
+  V v{};
+  for (std::size_t l = 0; l < N; ++l) v[l] = t[l].C.*m;
+  return v;
+}
+
+template <typename V>
+V select(const decltype(V{} < V{})& m, const V& a, const V& b) { return m ? a : b; }
+
+// the same steps for N tracks at once, one per lane; the gate is a mask as in MuonKFAlg::update_seeds
+template <typename T, typename V, std::size_t N>
+void check_lanes(std::mt19937& rng, int nSteps) {
+  const T r2 = static_cast<T>(135.0), gate = static_cast<T>(9.0);
+  Track<T> t0[N];
+  std::vector<Step<T>> s[N];
+  std::vector<Track<T>> ref[N];
+  std::vector<int> acc[N];
+  for (std::size_t l = 0; l < N; ++l) {
+    t0[l] = start<T>(rng);
+    s[l] = steps(t0[l], rng, nSteps);
+    ref[l] = scalar_run(t0[l], s[l], r2, gate, acc[l]);
+  }
+
+  V x[4], chi2{};
+  for (int i = 0; i < 4; ++i)
+    for (std::size_t l = 0; l < N; ++l) x[i][l] = t0[l].x[i];
+  SymCov4<V> C;
+  C.c00 = gather<T, V, N>(t0, &SymCov4<T>::c00);  C.c01 = gather<T, V, N>(t0, &SymCov4<T>::c01);
+  C.c02 = gather<T, V, N>(t0, &SymCov4<T>::c02);  C.c03 = gather<T, V, N>(t0, &SymCov4<T>::c03);
+  C.c11 = gather<T, V, N>(t0, &SymCov4<T>::c11);  C.c12 = gather<T, V, N>(t0, &SymCov4<T>::c12);
+  C.c13 = gather<T, V, N>(t0, &SymCov4<T>::c13);  C.c22 = gather<T, V, N>(t0, &SymCov4<T>::c22);
+  C.c23 = gather<T, V, N>(t0, &SymCov4<T>::c23);  C.c33 = gather<T, V, N>(t0, &SymCov4<T>::c33);
+
+  int bad = 0;
+  for (int i = 0; i < nSteps; ++i) {
+    V dz{}, q{}, mx{}, my{};
+    for (std::size_t l = 0; l < N; ++l) {
+      dz[l] = s[l][i].dz;
+      q[l] = s[l][i].q;
+      mx[l] = s[l][i].mx;
+      my[l] = s[l][i].my;
+    }
+    kf4_propagate(x, C, dz, q);
+    KF4Gain<V> g;
+    kf4_gain_xy(x, C, mx, my, V{} + r2, g);
+    const auto ok = ((g.det < 0 ? -g.det : g.det) >= static_cast<T>(1e-24)) & (g.d2 <= gate);
+    V xn[4] = {x[0], x[1], x[2], x[3]};
+    SymCov4<V> Cn = C;
+    kf4_apply(xn, Cn, g);
+    for (int k = 0; k < 4; ++k) x[k] = select<V>(ok, xn[k], x[k]);
+    C.c00 = select<V>(ok, Cn.c00, C.c00);  C.c01 = select<V>(ok, Cn.c01, C.c01);
+    C.c02 = select<V>(ok, Cn.c02, C.c02);  C.c03 = select<V>(ok, Cn.c03, C.c03);
+    C.c11 = select<V>(ok, Cn.c11, C.c11);  C.c12 = select<V>(ok, Cn.c12, C.c12);
+    C.c13 = select<V>(ok, Cn.c13, C.c13);  C.c22 = select<V>(ok, Cn.c22, C.c22);
+    C.c23 = select<V>(ok, Cn.c23, C.c23);  C.c33 = select<V>(ok, Cn.c33, C.c33);
+    chi2 = select<V>(ok, chi2 + g.d2, chi2);
+
+    for (std::size_t l = 0; l < N; ++l) {
+      const Track<T>& e = ref[l][i];
+      bool same = (ok[l] != 0) == (acc[l][i] != 0) && same_bits<T>(chi2[l], e.chi2);
+      for (int k = 0; k < 4; ++k) same = same && same_bits<T>(x[k][l], e.x[k]);
+      for (int r = 0; r < 4; ++r)
+        for (int c = r; c < 4; ++c) same = same && same_bits<T>(C(r, c)[l], e.C(r, c));
+      bad += same ? 0 : 1;
+    }
+  }
+  FAIR_CHECK(bad == 0);
+}
+
+// dense reference: C' = F C F^T + Q, K = C H^T S^-1, x' = x + K r, C' = (I - K H) C
+void dense_step(double x[4], double C[4][4], const Step<double>& s, double r2) {
+  double F[4][4] = {{1, 0, s.dz, 0}, {0, 1, 0, s.dz}, {0, 0, 1, 0}, {0, 0, 0, 1}};
+  double FC[4][4] = {}, P[4][4] = {}, xp[4] = {};
+  for (int i = 0; i < 4; ++i)
+    for (int j = 0; j < 4; ++j) {
+      xp[i] += F[i][j] * x[j];
+      for (int k = 0; k < 4; ++k) FC[i][j] += F[i][k] * C[k][j];
+    }
+  for (int i = 0; i < 4; ++i)
+    for (int j = 0; j < 4; ++j)
+      for (int k = 0; k < 4; ++k) P[i][j] += FC[i][k] * F[j][k];
+  P[2][2] += s.q;
+  P[3][3] += s.q;
+  const double S00 = P[0][0] + r2, S01 = P[0][1], S11 = P[1][1] + r2, det = S00 * S11 - S01 * S01;
+  const double Si[2][2] = {{S11 / det, -S01 / det}, {-S01 / det, S00 / det}};
+  const double r[2] = {s.mx - xp[0], s.my - xp[1]};
+  double K[4][2];
+  for (int i = 0; i < 4; ++i)
+    for (int j = 0; j < 2; ++j) K[i][j] = P[i][0] * Si[0][j] + P[i][1] * Si[1][j];
+  for (int i = 0; i < 4; ++i) {
+    x[i] = xp[i] + K[i][0] * r[0] + K[i][1] * r[1];
+    for (int j = 0; j < 4; ++j) C[i][j] = P[i][j] - (K[i][0] * P[0][j] + K[i][1] * P[1][j]);
+  }
+}
+
+void check_dense(std::mt19937& rng) {
+  for (int t = 0; t < 200; ++t) {
+    Track<double> trk = start<double>(rng);
+    double x[4], C[4][4];
+    for (int i = 0; i < 4; ++i) {
+      x[i] = trk.x[i];
+      for (int j = 0; j < 4; ++j) C[i][j] = trk.C(i, j);
+    }
+    for (const auto& s : steps(trk, rng, 30)) {
+      kf4_propagate(trk.x, trk.C, s.dz, s.q);
+      KF4Gain<double> g;
+      kf4_gain_xy(trk.x, trk.C, s.mx, s.my, 135.0, g);
+      kf4_apply(trk.x, trk.C, g);
+      dense_step(x, C, s, 135.0);
+      for (int i = 0; i < 4; ++i) {
+        FAIR_CHECK(std::abs(trk.x[i] - x[i]) <= 1e-9 * (1.0 + std::abs(x[i])));
+        for (int j = 0; j < 4; ++j) FAIR_CHECK(std::abs(trk.C(i, j) - C[i][j]) <= 1e-9 * (1.0 + std::abs(C[i][j])));
+      }
+    }
+  }
+}
+
+} // namespace
+
+int main() {
+  std::mt19937 rng(20241017);
+  for (int rep = 0; rep < 500; ++rep) {
+    check_lanes<double, Double2, 2>(rng, 40);
+    check_lanes<float, Float4, 4>(rng, 40);
+#ifdef __AVX__
+    check_lanes<double, Double4, 4>(rng, 40);
+    check_lanes<float, Float8, 8>(rng, 40);
+#endif
+  }
+  check_dense(rng);
+  return FairTest::result("test_kalman4");
+}
@@ -0,0 +1,164 @@
+// LineFit: the closed-form (Deming) solution must be the minimum of the effective-variance chi2 that a
+// numerical minimizer finds on the same points, for random tracks with and without x errors, per-point
+// weights, the slope limit, and the degenerate inputs (fewer than 2 points, no spread in z).
+#include "reco_alg/fit/LineFit.hpp"
+#include "tests/TestUtil.hpp"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace AHCALRecoAlg;
+
+namespace {
+
+struct Point {
+  double x, y, w;
+};
+
+// chi2 evaluated point by point, independently of the co-moments LineFit accumulates
+double chi2(const std::vector<Point>& pts, double ex, double ey, double a, double b) {
+  double s = 0.0;
+  for (const auto& p : pts) {
+    if (!(p.w > 0.0)) continue;
+    const double r = p.y - a - b * p.x;
+    s += p.w * r * r;
+  }
+  return s / (ey * ey + b * b * ex * ex);
+}
+
+// for a fixed slope the best intercept is the weighted mean residual (all points share the same errors)
+double best_intercept(const std::vector<Point>& pts, double b) {
+  double sw = 0.0, sr = 0.0;
+  for (const auto& p : pts) {
+    if (!(p.w > 0.0)) continue;
+    sw += p.w;
+    sr += p.w * (p.y - b * p.x);
+  }
+  return sr / sw;
+}
+
+// numerical minimizer: scan of the profiled chi2 over [-maxSlope, maxSlope], then golden-section search
+// around the best grid point
+double minimize_slope(const std::vector<Point>& pts, double ex, double ey, double maxSlope) {
+  auto f = [&](double b) { return chi2(pts, ex, ey, best_intercept(pts, b), b); };
+  const int nGrid = 20000;
+  const double step = 2.0 * maxSlope / nGrid;
+  double best = -maxSlope;
+  for (int i = 0; i <= nGrid; ++i) {
+    const double b = -maxSlope + i * step;
+    if (f(b) < f(best)) best = b;
+  }
+  double lo = std::max(-maxSlope, best - step), hi = std::min(maxSlope, best + step);
+  const double g = (std::sqrt(5.0) - 1.0) / 2.0;
+  double c = hi - g * (hi - lo), d = lo + g * (hi - lo);
+  for (int it = 0; it < 200; ++it) {
+    if (f(c) < f(d)) hi = d;
+    else lo = c;
+    c = hi - g * (hi - lo);
+    d = lo + g * (hi - lo);
+  }
+  return 0.5 * (lo + hi);
+}
+
+// closed form vs minimizer: the same slope within the minimizer's precision, and a chi2 no larger than
+// the minimizer's (up to rounding); intercept and chi2 consistent with the point-by-point evaluation
+void compare(const std::vector<Point>& pts, double ex, double ey, double maxSlope) {
+  LineFit fit(ex, ey, maxSlope);
+  int n = 0;
+  for (const auto& p : pts) {
+    fit.add(p.x, p.y, p.w);
+    n += p.w > 0.0;
+  }
+  const LineFitResult r = fit.solve();
+  FAIR_CHECK(r.ok && r.ndf == n - 2);
+  if (!r.ok) return;
+
+  const double b = minimize_slope(pts, ex, ey, maxSlope);
+  const double numeric = chi2(pts, ex, ey, best_intercept(pts, b), b);
+  const double closed = chi2(pts, ex, ey, r.intercept, r.slope);
+  FAIR_CHECK(std::abs(r.slope - b) <= 1e-6 * (1.0 + std::abs(b)));
+  FAIR_CHECK(closed <= numeric * (1.0 + 1e-12) + 1e-12);
+  FAIR_CHECK(std::abs(r.intercept - best_intercept(pts, r.slope)) <= 1e-9 * (1.0 + std::abs(r.intercept)));
+  FAIR_CHECK(std::abs(r.chi2 - closed) <= 1e-9 * (1.0 + closed));
+}
+
+// tracks through the AHCAL-like geometry: z at layer positions, x = x0 + slope z + smearing
+std::vector<Point> random_track(std::mt19937& rng, double slope, bool weighted) {
+  std::uniform_real_distribution<double> u(0.0, 1.0);
+  std::normal_distribution<double> smear(0.0, 20.0);
+  const int n = 2 + static_cast<int>(rng() % 40);
+  const double x0 = -300.0 + 600.0 * u(rng);
+  std::vector<Point> pts;
+  for (int i = 0; i < n; ++i) {
+    const double z = 30.0 * static_cast<int>(rng() % 40);
+    const double w = weighted ? (rng() % 5 == 0 ? 0.0 : u(rng) + 0.1) : 1.0;
+    pts.push_back({z, x0 + slope * z + smear(rng), w});
+  }
+  return pts;
+}
+
+// at least two used points at different z
+bool has_spread(const std::vector<Point>& pts) {
+  const Point* first = nullptr;
+  for (const auto& p : pts) {
+    if (!(p.w > 0.0)) continue;
+    if (first == nullptr) first = &p;
+    else if (p.x != first->x) return true;
+  }
+  return false;
+}
+
+void random_tracks() {
+  std::mt19937 rng(20241017);
+  std::uniform_real_distribution<double> slope(-1.5, 1.5);
+  for (int t = 0; t < 300; ++t) {
+    for (const bool weighted : {false, true}) {
+      const auto pts = random_track(rng, slope(rng), weighted);
+      if (!has_spread(pts)) continue;
+      compare(pts, 1.5, 20.0, 20.0); // TrackFitAlg's errors and slope limit
+      compare(pts, 0.0, 20.0, 20.0); // no x errors: ordinary least squares
+      compare(pts, 40.0, 5.0, 20.0); // x errors dominate
+    }
+  }
+}
+
+void degenerate() {
+  LineFit empty(1.5, 20.0, 20.0);
+  FAIR_CHECK(!empty.solve().ok);
+  empty.add(0.0, 1.0);
+  empty.add(30.0, 2.0, 0.0); // ignored
+  FAIR_CHECK(empty.size() == 1 && !empty.solve().ok);
+
+  // all points at the same z: the chi2 falls towards the slope limit, with the sign of the correlation
+  // (none here: +limit); without a limit the fit fails
+  LineFit vertical(1.5, 20.0, 20.0);
+  LineFit unlimited(1.5, 20.0);
+  for (const double y : {-10.0, 0.0, 25.0}) {
+    vertical.add(90.0, y);
+    unlimited.add(90.0, y);
+  }
+  const LineFitResult r = vertical.solve();
+  FAIR_CHECK(r.ok && std::abs(r.slope) == 20.0);
+  FAIR_CHECK(!unlimited.solve().ok);
+
+  // a steep track is clamped to the limit and the intercept follows the clamped slope
+  std::vector<Point> steep;
+  for (int i = 0; i < 10; ++i) steep.push_back({30.0 * i + (i % 2), 50.0 * 30.0 * i, 1.0});
+  compare(steep, 1.5, 20.0, 20.0);
+  LineFit clamped(1.5, 20.0, 20.0);
+  for (const auto& p : steep) clamped.add(p.x, p.y);
+  FAIR_CHECK(clamped.solve().slope == 20.0);
+
+  // clear() starts a new fit
+  clamped.clear();
+  FAIR_CHECK(clamped.size() == 0 && !clamped.solve().ok);
+}
+
+} // namespace
+
+int main() {
+  random_tracks();
+  degenerate();
+  return FairTest::result("test_line_fit");
+}
@@ -0,0 +1,189 @@
+// MuonKFAlg: the batched seed search (batchSeeds, seed pairs filtered together in SIMD lanes) and the
+// per-layer tile grid (hitGrid) must find exactly the tracks of the one-by-one search with the linear hit
+// scan: same hits, and parameters equal bit for bit (MuonKFAlg is built with -ffp-contract=off), over muon
+// events with noise, hadron showers and busy layers (the grid is only built from 32 hits per layer on),
+// and over the configurations that change the seeding, gating and termination.
+#include "reco_alg/module/MuonKFAlg/MuonKFAlg.hpp"
+#include "common/AHCALGeometry.hpp"
+#include "common/Logger.hpp"
+#include "common/edm/EDM.hpp"
+#include "tests/TestUtil.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace AHCALRecoAlg;
+
+namespace {
+
+// cellID (without the layer part) of every tile of the 18x18 grid, -1 if no channel sits there
+std::vector<int> tile_cells() {
+  std::vector<int> tiles(18 * 18, -1);
+  for (int chip = 0; chip < AHCALGeometry::chip_No; ++chip) {
+    for (int channel = 0; channel < AHCALGeometry::channel_No; ++channel) {
+      const auto p = AHCALGeometry::CellPos(chip * 10000 + channel);
+      if (p.xIndex >= 0 && p.xIndex < 18 && p.yIndex >= 0 && p.yIndex < 18) tiles[p.yIndex * 18 + p.xIndex] = chip * 10000 + channel;
+    }
+  }
+  return tiles;
+}
+
+// a muon (straight line in tile units, ~90% efficient), optionally a hadron shower from a random layer on
+// with ~showerHits hits per layer, and noiseHits random hits per layer; with duplicates, a quarter of the
+// hits get a second hit on the same tile (equal distances: the first hit in layer order must win).
+// coreOffset > 0: the shower is a narrow core that many tiles away from the muon and the muon is only
+// ~60% efficient, so the nearest hit of a busy layer is often several rings of tiles out.
+std::vector<std::vector<AHCALRecoHit>> make_events(int nEvents, int showerHits, int noiseHits, unsigned seed,
+                                                   bool duplicates = false, double coreOffset = 0.0) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> uni(0.0, 1.0);
+  std::normal_distribution<double> gaus(0.0, 1.0);
+  const std::vector<int> tiles = tile_cells();
+  auto add = [&](std::vector<AHCALRecoHit>& hits, int layer, double xi, double yi, double nmip) {
+    const int ix = static_cast<int>(std::floor(xi)), iy = static_cast<int>(std::floor(yi));
+    if (ix < 0 || ix >= 18 || iy < 0 || iy >= 18 || tiles[iy * 18 + ix] < 0) return;
+    AHCALRecoHit h;
+    h.cellID = layer * 100000 + tiles[iy * 18 + ix];
+    h.Nmip = nmip;
+    h.Edep = nmip * 0.461;
+    h.index = static_cast<int>(hits.size());
+    hits.push_back(h);
+    if (duplicates && rng() % 4 == 0) {
+      h.Nmip = 0.5 + uni(rng);
+      h.index = static_cast<int>(hits.size());
+      hits.push_back(h);
+    }
+  };
+
+  std::vector<std::vector<AHCALRecoHit>> events(nEvents);
+  for (auto& hits : events) {
+    const double x0 = 3.0 + 12.0 * uni(rng), y0 = 3.0 + 12.0 * uni(rng);
+    const double sx = 0.05 * gaus(rng), sy = 0.05 * gaus(rng);
+    const int start = static_cast<int>(20.0 * uni(rng));
+    const double phi = 6.283185307179586 * uni(rng);
+    const double cx = coreOffset > 0.0 ? x0 + coreOffset * std::cos(phi) : x0 + 2.0 * gaus(rng);
+    const double cy = coreOffset > 0.0 ? y0 + coreOffset * std::sin(phi) : y0 + 2.0 * gaus(rng);
+    const double efficiency = coreOffset > 0.0 ? 0.6 : 0.9;
+    for (int L = 0; L < AHCALGeometry::Layer_No; ++L) {
+      if (uni(rng) < efficiency) add(hits, L, x0 + sx * L, y0 + sy * L, 1.0 + 0.3 * std::abs(gaus(rng)));
+      if (showerHits > 0 && L >= start) {
+        const double width = coreOffset > 0.0 ? 0.8 : 1.0 + 0.15 * (L - start); // tiles
+        const int n = static_cast<int>(showerHits * (0.5 + uni(rng)));
+        for (int k = 0; k < n; ++k) add(hits, L, cx + width * gaus(rng), cy + width * gaus(rng), 5.0 * uni(rng));
+      }
+      for (int k = 0; k < noiseHits; ++k) add(hits, L, 18.0 * uni(rng), 18.0 * uni(rng), 0.1 + 2.5 * uni(rng));
+    }
+  }
+  return events;
+}
+
+bool same_bits(double a, double b) { return std::memcmp(&a, &b, sizeof(double)) == 0; }
+
+bool same_track(const Track& a, const Track& b) {
+  if (a.valid != b.valid) return false;
+  if (!a.valid) return true;
+  bool same = same_bits(a.x, b.x) && same_bits(a.y, b.y) && same_bits(a.tx, b.tx) && same_bits(a.ty, b.ty) &&
+              same_bits(a.z, b.z) && same_bits(a.chi2, b.chi2) && a.ndof == b.ndof &&
+              a.consecutive_skips == b.consecutive_skips && a.nInTrackHits == b.nInTrackHits &&
+              a.nOutTrackHits == b.nOutTrackHits && a.inTrackHitsIndices == b.inTrackHitsIndices &&
+              a.outTrackHitsIndices == b.outTrackHitsIndices && a.inTrackHits.size() == b.inTrackHits.size();
+  for (std::size_t i = 0; same && i < a.inTrackHits.size(); ++i) same = a.inTrackHits[i].cellID == b.inTrackHits[i].cellID;
+  return same;
+}
+
+// tracks of every event; found[e] is find_muon_track_kf's return value
+std::vector<Track> run(const std::vector<std::vector<AHCALRecoHit>>& events, const MuonKFAlgCfg& cfg,
+                       std::vector<bool>& found) {
+  std::vector<Track> out(events.size());
+  found.assign(events.size(), false);
+  for (std::size_t e = 0; e < events.size(); ++e) {
+    std::pmr::monotonic_buffer_resource arena;
+    found[e] = find_muon_track_kf(events[e], out[e], cfg, &arena);
+  }
+  return out;
+}
+
+// variant vs the one-by-one search with the per-layer scan; returns the number of tracks found
+int compare(const std::string& label, const std::vector<std::vector<AHCALRecoHit>>& events, MuonKFAlgCfg cfg,
+            bool batchSeeds, bool hitGrid) {
+  std::vector<bool> foundRef, found;
+  cfg.batchSeeds = false;
+  cfg.hitGrid = false;
+  const auto ref = run(events, cfg, foundRef);
+  cfg.batchSeeds = batchSeeds;
+  cfg.hitGrid = hitGrid;
+  const auto got = run(events, cfg, found);
+  int nFound = 0, bad = 0;
+  for (std::size_t e = 0; e < events.size(); ++e) {
+    nFound += foundRef[e] ? 1 : 0;
+    if (found[e] != foundRef[e] || !same_track(got[e], ref[e])) ++bad;
+  }
+  if (bad > 0) std::cerr << label << ": " << bad << " of " << events.size() << " events differ" << std::endl;
+  FAIR_CHECK(bad == 0);
+  return nFound;
+}
+
+// configurations that change which seeds exist, how long lanes live and which hits pass the gate
+std::vector<std::pair<std::string, MuonKFAlgCfg>> configs() {
+  std::vector<std::pair<std::string, MuonKFAlgCfg>> v;
+  MuonKFAlgCfg base;
+  base.skipLayer.set(0);
+  base.skipLayer.set(2);
+  base.skipLayer.set(14);
+  v.emplace_back("default", base);
+
+  MuonKFAlgCfg c = base;
+  c.useNmipWindow = false;
+  c.maxSeedHitsPerLayer = 3;
+  v.emplace_back("no nmip window, 3 seed hits", c);
+
+  c = base;
+  c.maxSeedHitsPerLayer = 16;
+  c.gateD2 = 4.0;
+  c.maxConsecutiveSkips = 1;
+  v.emplace_back("16 seed hits, tight gate, 1 skip", c);
+
+  c = base;
+  c.maxConsecutiveSkips = 0; // no termination on skips
+  c.minUsedLayers = 3;
+  c.lastNLayers = 20;
+  c.seedLayerGap = 2;
+  v.emplace_back("no skip limit, last 20 layers", c);
+
+  c = base;
+  c.gateD2 = 1e6; // every picked hit is used, however far: the nearest hit of the layer decides the track
+  v.emplace_back("wide gate", c);
+
+  c = MuonKFAlgCfg{};
+  c.measSigmaXY_mm = 5.0;
+  c.sigmaTheta = 0.02;
+  v.emplace_back("no skipped layers, explicit resolution", c);
+  return v;
+}
+
+} // namespace
+
+int main() {
+  FAIR::set_level(spdlog::level::warn);
+  const auto clean = make_events(200, 0, 2, 11);
+  const auto noisy = make_events(200, 0, 15, 12);
+  const auto showers = make_events(100, 40, 5, 13);
+  const auto busy = make_events(100, 120, 40, 14, true); // most layers >= HitGrid::kMinHits hits
+  const auto ties = make_events(200, 20, 30, 15, true);
+  const auto cores = make_events(300, 50, 0, 16, false, 5.0);
+  for (const auto& [name, cfg] : configs()) {
+    FAIR_CHECK(compare("batched, clean, " + name, clean, cfg, true, false) > 0);
+    compare("batched, noisy, " + name, noisy, cfg, true, false);
+    compare("batched, showers, " + name, showers, cfg, true, false);
+    compare("grid, noisy, " + name, noisy, cfg, false, true);
+    compare("grid, showers, " + name, showers, cfg, false, true);
+    FAIR_CHECK(compare("grid, busy, " + name, busy, cfg, false, true) > 0);
+    compare("grid, ties, " + name, ties, cfg, false, true);
+    compare("grid, cores, " + name, cores, cfg, false, true);
+  }
+  return FairTest::result("test_muon_kf");
+}
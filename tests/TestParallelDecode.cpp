@@ -0,0 +1,172 @@
+// BinaryRawHitReader::enable_parallel: chunks decoded on the thread pool must deliver the same events, in
+// the same order and with the same fine-timestamp suppression, as the sequential mmap reader, for any
+// number of threads and chunk size; also set_range() with chunks in flight and destruction mid-stream.
+#include "IO/reader/BinaryRawHitReader.hpp"
+#include "IO/reader/RawEventView.hpp"
+#include "EventFormats/DAQFormats.hpp"
+#include "common/Logger.hpp"
+#include "tests/TestUtil.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+template <class T>
+void put(std::vector<std::uint8_t>& b, T v) {
+  std::uint8_t x[sizeof(T)];
+  std::memcpy(x, &v, sizeof(T));
+  b.insert(b.end(), x, x + sizeof(T));
+}
+
+// nEvents events holding one TLU fragment each (see RawEvent for the header layouts). The fine timestamps
+// and input bits take a few values only, so that many of them repeat without signal (-1 on delivery).
+std::vector<std::uint8_t> make_file(int nEvents, std::mt19937& rng) {
+  std::vector<std::uint8_t> file;
+  for (int e = 0; e < nEvents; ++e) {
+    // w0: input bits 16-21, timestamp bits 32-47; w1: timestamp bits 0-31; w2: sc0-sc3; w3: event number;
+    // w4: sc4, sc5 in the two upper bytes
+    std::vector<std::uint8_t> payload;
+    const std::uint32_t inputs = rng() % 4 == 0 ? rng() % 64 : 0;
+    const std::uint32_t sc = rng() % 3;
+    put<std::uint32_t>(payload, inputs << 16);
+    put<std::uint32_t>(payload, static_cast<std::uint32_t>(1000 + 25 * e));
+    put<std::uint32_t>(payload, sc * 0x01010101u ^ (rng() % 2));
+    put<std::uint32_t>(payload, static_cast<std::uint32_t>(e));
+    put<std::uint32_t>(payload, sc * 0x01010000u);
+
+    std::vector<std::uint8_t> frag;
+    put<std::uint8_t>(frag, RawEvent::kFragmentMarker);
+    put<std::uint8_t>(frag, 0);
+    put<std::uint16_t>(frag, 0);
+    put<std::uint16_t>(frag, 1);
+    put<std::uint16_t>(frag, RawEvent::kFragmentHeaderBytes);
+    put<std::uint32_t>(frag, static_cast<std::uint32_t>(payload.size()));
+    put<std::uint32_t>(frag, DAQFormats::SourceIDs::TLUSourceID);
+    put<std::uint64_t>(frag, static_cast<std::uint64_t>(e));
+    put<std::uint16_t>(frag, 0);
+    put<std::uint16_t>(frag, 0);
+    put<std::uint64_t>(frag, 0);
+    frag.insert(frag.end(), payload.begin(), payload.end());
+
+    put<std::uint8_t>(file, RawEvent::kEventMarker);
+    put<std::uint8_t>(file, 0);
+    put<std::uint16_t>(file, 0);
+    put<std::uint16_t>(file, 1);
+    put<std::uint16_t>(file, RawEvent::kEventHeaderBytes);
+    put<std::uint32_t>(file, static_cast<std::uint32_t>(frag.size()));
+    put<std::uint8_t>(file, 1); // fragment count
+    put<std::uint8_t>(file, 0x34); // run number (3 bytes)
+    put<std::uint8_t>(file, 0x12);
+    put<std::uint8_t>(file, 0x00);
+    put<std::uint64_t>(file, static_cast<std::uint64_t>(e));
+    put<std::uint64_t>(file, static_cast<std::uint64_t>(e));
+    put<std::uint16_t>(file, 0);
+    put<std::uint16_t>(file, 0);
+    put<std::uint64_t>(file, 0);
+    file.insert(file.end(), frag.begin(), frag.end());
+  }
+  return file;
+}
+
+struct Event {
+  std::size_t hits = 0;
+  AHCALTLURawData tlu;
+};
+
+bool same(const Event& a, const Event& b) {
+  return a.hits == b.hits && a.tlu.TriggerID == b.tlu.TriggerID && a.tlu.Timestamp == b.tlu.Timestamp &&
+         a.tlu.BCID_TLU == b.tlu.BCID_TLU && a.tlu.Inputs == b.tlu.Inputs && a.tlu.FineTimestamps == b.tlu.FineTimestamps;
+}
+
+std::vector<Event> read_all(BinaryRawHitReader& r) {
+  std::vector<Event> v;
+  std::vector<AHCALRawHit> hits;
+  AHCALTLURawData tlu;
+  while (r.next(hits, tlu)) v.push_back(Event{hits.size(), tlu});
+  return v;
+}
+
+bool same(const std::vector<Event>& a, const std::vector<Event>& b) {
+  if (a.size() != b.size()) return false;
+  for (std::size_t i = 0; i < a.size(); ++i)
+    if (!same(a[i], b[i])) return false;
+  return true;
+}
+
+void whole_file(const std::string& path, const std::vector<Event>& ref) {
+  for (const std::size_t nThreads : {1u, 3u, 8u}) {
+    for (const std::size_t chunk : {1u, 7u, 64u, 5000u}) {
+      BinaryRawHitReader r(path);
+      r.enable_parallel(nThreads, chunk);
+      FAIR_CHECK(same(read_all(r), ref));
+    }
+  }
+}
+
+// set_range() after a few events, with chunks of the old position still in flight
+void ranges(const std::string& path) {
+  std::vector<AHCALRawHit> hits;
+  AHCALTLURawData tlu;
+  for (const auto& [begin, end] : {std::pair<long long, long long>{33, 150}, {0, 1}, {499, 500}, {200, 200}}) {
+    BinaryRawHitReader s(path, true);
+    s.build_index();
+    s.set_range(begin, end);
+    const auto ref = read_all(s);
+    FAIR_CHECK(static_cast<long long>(ref.size()) == end - begin);
+
+    BinaryRawHitReader p(path);
+    p.enable_parallel(4, 10);
+    for (int i = 0; i < 25; ++i) p.next(hits, tlu);
+    p.set_range(begin, end);
+    FAIR_CHECK(same(read_all(p), ref));
+  }
+}
+
+// the reader goes away while workers are still decoding chunks ahead of the consumer
+void destroy_mid_stream(const std::string& path) {
+  std::vector<AHCALRawHit> hits;
+  AHCALTLURawData tlu;
+  for (int rep = 0; rep < 50; ++rep) {
+    BinaryRawHitReader r(path);
+    r.enable_parallel(4, 5);
+    for (int i = 0; i < rep % 13; ++i) FAIR_CHECK(r.next(hits, tlu));
+  }
+}
+
+} // namespace
+
+int main() {
+  FAIR::set_level(spdlog::level::warn);
+  const std::string path =
+      (std::filesystem::temp_directory_path() / ("fair_test_parallel_decode_" + std::to_string(::getpid()) + ".raw")).string();
+  std::mt19937 rng(20240917);
+  const auto bytes = make_file(500, rng);
+  std::FILE* f = std::fopen(path.c_str(), "wb");
+  if (f == nullptr) {
+    std::cout << "test_parallel_decode: cannot write " << path << std::endl;
+    return 1;
+  }
+  std::fwrite(bytes.data(), 1, bytes.size(), f);
+  std::fclose(f);
+
+  BinaryRawHitReader seq(path, true);
+  const auto ref = read_all(seq);
+  FAIR_CHECK(ref.size() == 500);
+  int suppressed = 0;
+  for (const auto& e : ref)
+    for (const int t : e.tlu.FineTimestamps) suppressed += t == -1;
+  FAIR_CHECK(suppressed > 0); // the file exercises the fine-timestamp state
+
+  whole_file(path, ref);
+  ranges(path);
+  destroy_mid_stream(path);
+  std::filesystem::remove(path);
+  return FairTest::result("test_parallel_decode");
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <atomic>
+#include <iostream>
+
+// Minimal checks for the tests under tests/ (no test framework dependency).
+// A failed FAIR_CHECK prints its location and the test returns 1 from FairTest::result();
+// kSkip is ctest's SKIP_RETURN_CODE for tests that cannot run on this machine.
+namespace FairTest {
+  constexpr int kSkip = 77;
+
+  // checks may fail on several threads at once
+  inline std::atomic<int>& failures() {
+    static std::atomic<int> n{0};
+    return n;
+  }
+
+  inline int result(const char* name) {
+    if (failures() == 0) {
+      std::cout << name << ": ok" << std::endl;
+      return 0;
+    }
+    std::cout << name << ": " << failures().load() << " check(s) failed" << std::endl;
+    return 1;
+  }
+}
+
+#define FAIR_CHECK(cond)                                                                  \
+  do {                                                                                    \
+    if (!(cond)) {                                                                        \
+      ++FairTest::failures();                                                             \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #cond << std::endl;  \
+    }                                                                                     \
+  } while (0)